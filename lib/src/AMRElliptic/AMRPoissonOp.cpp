@@ -16,8 +16,11 @@
 #include "FineInterp.H"
 #include "CoarseAverage.H"
 #include "CH_OpenMP.H"
+#include "TileIterator.H"
+#include "MGAgglomeration.H"
 #include "AMRMultiGrid.H"
 #include "Misc.H"
+#include "ParmParse.H"
 
 #include "AMRPoissonOp.H"
 #include "AMRPoissonOpF_F.H"
@@ -26,10 +29,11 @@
 
 #include "NamespaceHeader.H"
 
-int AMRPoissonOp::s_exchangeMode = 1; // 1: no overlap (default); 0: ...
+int AMRPoissonOp::s_exchangeMode = 1; // 1: no overlap (default); 0: ...; 2: as 0, and operator interiors computed during exchange
 //int AMRPoissonOp::s_relaxMode = 0;
-int AMRPoissonOp::s_relaxMode = 1; // 1: GSRB; 4: Jacobi
+int AMRPoissonOp::s_relaxMode = 1; // 1: GSRB; 4: Jacobi; 6: Chebyshev; 7: GSRB with deep ghosts
 int AMRPoissonOp::s_maxCoarse = 2;
+Vector<int> AMRPoissonOp::s_sweepsPerExchange;
 
 // ---------------------------------------------------------
 static void
@@ -55,6 +59,40 @@ amrpgetMultiColors(Vector<IntVect>& a_colors)
 #endif
 }
 
+// ---------------------------------------------------------
+// cells of a_region that are not in a_interior, as a set of disjoint slabs.
+// used to finish an operator evaluation after the ghost cells arrive.
+static void
+amrpgetRimBoxes(Vector<Box>& a_rim,
+                const Box&   a_region,
+                const Box&   a_interior)
+{
+  a_rim.resize(0);
+  if (a_interior.isEmpty())
+    {
+      a_rim.push_back(a_region);
+      return;
+    }
+  Box remaining = a_region;
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      if (remaining.smallEnd(idir) < a_interior.smallEnd(idir))
+        {
+          Box lo = remaining;
+          lo.setBig(idir, a_interior.smallEnd(idir) - 1);
+          a_rim.push_back(lo);
+        }
+      if (remaining.bigEnd(idir) > a_interior.bigEnd(idir))
+        {
+          Box hi = remaining;
+          hi.setSmall(idir, a_interior.bigEnd(idir) + 1);
+          a_rim.push_back(hi);
+        }
+      remaining.setSmall(idir, a_interior.smallEnd(idir));
+      remaining.setBig(idir, a_interior.bigEnd(idir));
+    }
+}
+
 // ---------------------------------------------------------
 /** full define function for AMRLevelOp with both coarser and finer levels */
 void AMRPoissonOp::define(const DisjointBoxLayout& a_grids,
@@ -169,6 +207,9 @@ void AMRPoissonOp::define(const DisjointBoxLayout& a_grids,
   // these get set again after define is called
   m_alpha = 0.0;
   m_beta  = 1.0;
+  m_chebyshev.reset();
+  m_sweepsPerExchange = sweepsPerExchange(0);
+  m_deepSweeps = -1;
 
   m_exchangeCopier = a_exchange;
   // m_exchangeCopier.define(a_grids, a_grids, IntVect::Unit, true);
@@ -265,15 +306,36 @@ void AMRPoissonOp::residualI(LevelData<FArrayBox>&       a_lhs,
   CH_TIME("AMRPoissonOp::residualI");
 
   LevelData<FArrayBox>& phi = (LevelData<FArrayBox>&)a_phi;
+  const DisjointBoxLayout& dbl = a_lhs.disjointBoxLayout();
+  DataIterator dit = phi.dataIterator();
   if (s_exchangeMode == 0)
     phi.exchange(phi.interval(), m_exchangeCopier);
   else if (s_exchangeMode == 1)
     phi.exchangeNoOverlap(m_exchangeCopier);
+  else if (s_exchangeMode == 2)
+    {
+      // the interior of each box does not see the ghost cells,
+      // so compute it while the exchange messages are in flight
+      phi.exchangeBegin(m_exchangeCopier);
+      for (dit.begin(); dit.ok(); ++dit)
+        {
+          const Box interior = grow(dbl[dit], -1);
+          if (!interior.isEmpty())
+            {
+              FORT_OPERATORLAPRES(CHF_FRA(a_lhs[dit]),
+                                  CHF_CONST_FRA(phi[dit]),
+                                  CHF_CONST_FRA(a_rhs[dit]),
+                                  CHF_BOX(interior),
+                                  CHF_CONST_REAL(m_dx),
+                                  CHF_CONST_REAL(m_alpha),
+                                  CHF_CONST_REAL(m_beta));
+            }
+        }
+      phi.exchangeEnd();
+    }
   else
     MayDay::Abort("exchangeMode");
 
-  const DisjointBoxLayout& dbl = a_lhs.disjointBoxLayout();
-  DataIterator dit = phi.dataIterator();
   {
     CH_TIME("AMRPoissonOP::BCs");
 
@@ -283,16 +345,28 @@ void AMRPoissonOp::residualI(LevelData<FArrayBox>&       a_lhs,
       }
   }
 
+  Vector<Box> regions(1);
   for (dit.begin(); dit.ok(); ++dit)
     {
-      const Box& region = dbl[dit];
-      FORT_OPERATORLAPRES(CHF_FRA(a_lhs[dit]),
-                          CHF_CONST_FRA(phi[dit]),
-                          CHF_CONST_FRA(a_rhs[dit]),
-                          CHF_BOX(region),
-                          CHF_CONST_REAL(m_dx),
-                          CHF_CONST_REAL(m_alpha),
-                          CHF_CONST_REAL(m_beta));
+      if (s_exchangeMode == 2)
+        {
+          amrpgetRimBoxes(regions, dbl[dit], grow(dbl[dit], -1));
+        }
+      else
+        {
+          regions[0] = dbl[dit];
+        }
+      for (int ireg = 0; ireg < regions.size(); ireg++)
+        {
+          const Box& region = regions[ireg];
+          FORT_OPERATORLAPRES(CHF_FRA(a_lhs[dit]),
+                              CHF_CONST_FRA(phi[dit]),
+                              CHF_CONST_FRA(a_rhs[dit]),
+                              CHF_BOX(region),
+                              CHF_CONST_REAL(m_dx),
+                              CHF_CONST_REAL(m_alpha),
+                              CHF_CONST_REAL(m_beta));
+        }
     }
 }
 
@@ -347,16 +421,40 @@ void AMRPoissonOp::applyOpI(LevelData<FArrayBox>&       a_lhs,
   CH_TIME("AMRPoissonOp::applyOpI");
 
   LevelData<FArrayBox>& phi = (LevelData<FArrayBox>&)a_phi;
+  const DisjointBoxLayout& dbl = a_lhs.disjointBoxLayout();
+  DataIterator dit = phi.dataIterator();
+  int nbox=dit.size();
+  TileIterator tit(dbl);
+  int ntile=tit.size();
   if (s_exchangeMode == 0)
     phi.exchange(phi.interval(), m_exchangeCopier);
   else if (s_exchangeMode == 1)
     phi.exchangeNoOverlap(m_exchangeCopier);
+  else if (s_exchangeMode == 2)
+    {
+      // the interior of each box does not see the ghost cells,
+      // so compute it while the exchange messages are in flight
+      phi.exchangeBegin(m_exchangeCopier);
+#pragma omp parallel for
+      for (int itile=0; itile<ntile; itile++)
+        {
+          const DataIndex& d = tit.index(itile);
+          const Box interior = grow(dbl[d], -1) & tit[itile];
+          if (!interior.isEmpty())
+            {
+              FORT_OPERATORLAP(CHF_FRA(a_lhs[d]),
+                               CHF_CONST_FRA(phi[d]),
+                               CHF_BOX(interior),
+                               CHF_CONST_REAL(m_dx),
+                               CHF_CONST_REAL(m_alpha),
+                               CHF_CONST_REAL(m_beta));
+            }
+        }
+      phi.exchangeEnd();
+    }
   else
     MayDay::Abort("exchangeMode");
 
-  const DisjointBoxLayout& dbl = a_lhs.disjointBoxLayout();
-  DataIterator dit = phi.dataIterator();
-  int nbox=dit.size();
 #pragma omp parallel   default (shared)
   {
     CH_TIME("AMRPoissonOp::applyOpIBC");
@@ -370,16 +468,27 @@ void AMRPoissonOp::applyOpI(LevelData<FArrayBox>&       a_lhs,
 #pragma omp parallel 
   {
 #pragma omp for 
-    for (int ibox=0;ibox<nbox; ibox++)
+    for (int itile=0; itile<ntile; itile++)
       {
-      const Box& region = dbl[dit[ibox]];
+      const DataIndex& d = tit.index(itile);
+      Vector<Box> regions(1, tit[itile]);
+      if (s_exchangeMode == 2)
+        {
+          // only the cells next to the ghost cells are left
+          amrpgetRimBoxes(regions, dbl[d], grow(dbl[d], -1));
+        }
+      for (int ireg = 0; ireg < regions.size(); ireg++)
+        {
+          const Box region = regions[ireg] & tit[itile];
+          if (region.isEmpty()) continue;
 
-      FORT_OPERATORLAP(CHF_FRA(a_lhs[dit[ibox]]),
-                       CHF_CONST_FRA(phi[dit[ibox]]),
-                       CHF_BOX(region),
-                       CHF_CONST_REAL(m_dx),
-                       CHF_CONST_REAL(m_alpha),
-                       CHF_CONST_REAL(m_beta));
+          FORT_OPERATORLAP(CHF_FRA(a_lhs[d]),
+                           CHF_CONST_FRA(phi[d]),
+                           CHF_BOX(region),
+                           CHF_CONST_REAL(m_dx),
+                           CHF_CONST_REAL(m_alpha),
+                           CHF_CONST_REAL(m_beta));
+        }
     }
   }//end pragma
 }
@@ -391,18 +500,18 @@ void AMRPoissonOp::applyOpNoBoundary(LevelData<FArrayBox>&       a_lhs,
 
   LevelData<FArrayBox>& phi = (LevelData<FArrayBox>&)a_phi;
   const DisjointBoxLayout& dbl = a_lhs.disjointBoxLayout();
-  DataIterator dit = phi.dataIterator();
-  int nbox=dit.size();
+  TileIterator tit(dbl);
+  int ntile=tit.size();
   phi.exchange(phi.interval(), m_exchangeCopier);
 
 #pragma omp parallel 
   {
 #pragma omp for 
-    for (int ibox = 0; ibox < nbox; ibox++)
+    for (int itile = 0; itile < ntile; itile++)
     {
-      const Box& region = dbl[dit[ibox]];
-      FORT_OPERATORLAP(CHF_FRA(a_lhs[dit[ibox]]),
-                       CHF_CONST_FRA(phi[dit[ibox]]),
+      const Box& region = tit[itile];
+      FORT_OPERATORLAP(CHF_FRA(a_lhs[tit.index(itile)]),
+                       CHF_CONST_FRA(phi[tit.index(itile)]),
                        CHF_BOX(region),
                        CHF_CONST_REAL(m_dx),
                        CHF_CONST_REAL(m_alpha),
@@ -510,6 +619,15 @@ Real AMRPoissonOp::dotProduct(const LevelData<FArrayBox>& a_1,
   return m_levelOps.dotProduct(a_1, a_2);
 }
 
+// ---------------------------------------------------------
+Real AMRPoissonOp::localDotProduct(const LevelData<FArrayBox>& a_1,
+                                   const LevelData<FArrayBox>& a_2)
+{
+  CH_TIME("AMRPoissonOp::localDotProduct");
+
+  return m_levelOps.localDotProduct(a_1, a_2);
+}
+
 // ---------------------------------------------------------
 void AMRPoissonOp::mDotProduct(const LevelData<FArrayBox>& a_1,
                                const int a_sz,
@@ -552,6 +670,15 @@ void AMRPoissonOp::scale(LevelData<FArrayBox>& a_lhs,
   m_levelOps.scale(a_lhs, a_scale);
 }
 
+// ---------------------------------------------------------
+void AMRPoissonOp::divideByDiagonal(LevelData<FArrayBox>& a_lhs)
+{
+  CH_TIME("AMRPoissonOp::divideByDiagonal");
+
+  Real diagonal = m_alpha - 2.0*SpaceDim * m_beta / (m_dx*m_dx);
+  m_levelOps.scale(a_lhs, 1.0/diagonal);
+}
+
 // ---------------------------------------------------------
 Real AMRPoissonOp::norm(const LevelData<FArrayBox>& a_x,
                         int                         a_ord)
@@ -603,6 +730,19 @@ void AMRPoissonOp::relax(LevelData<FArrayBox>&       a_e,
 {
   CH_TIME("AMRPoissonOp::relax");
 
+  if (s_relaxMode == 6)
+    {
+      // one polynomial with a_iterations operator applies
+      levelChebyshev(a_e, a_residual, a_iterations);
+      return;
+    }
+  if (s_relaxMode == 7)
+    {
+      // the iterations in blocks of m_sweepsPerExchange
+      levelGSRBDeep(a_e, a_residual, a_iterations);
+      return;
+    }
+
   for (int i = 0; i < a_iterations; i++)
     {
       switch (s_relaxMode)
@@ -642,11 +782,77 @@ void AMRPoissonOp::createCoarser(LevelData<FArrayBox>&       a_coarse,
   IntVect ghost = a_fine.ghostVect();
 
   CH_assert(a_fine.disjointBoxLayout().coarsenable(2));
+  if (m_agglomeratedMGrids.isClosed())
+    {
+      a_coarse.define(m_agglomeratedMGrids, a_fine.nComp(), ghost);
+      return;
+    }
   if (m_coarsenedMGrids.size() == 0)
     coarsen(m_coarsenedMGrids, a_fine.disjointBoxLayout(), 2); //multigrid, so coarsen by 2
   a_coarse.define(m_coarsenedMGrids, a_fine.nComp(), ghost);
 }
 
+// ---------------------------------------------------------
+void AMRPoissonOp::setAgglomeratedMGrids(const DisjointBoxLayout& a_grids,
+                                         const DisjointBoxLayout& a_coarse)
+{
+  CH_TIME("AMRPoissonOp::setAgglomeratedMGrids");
+
+  if (m_coarsenedMGrids.size() == 0)
+    coarsen(m_coarsenedMGrids, a_grids, 2);
+  m_agglomeratedMGrids = a_coarse;
+  m_gatherCopier.define(m_coarsenedMGrids, m_agglomeratedMGrids);
+  m_scatterCopier.define(m_agglomeratedMGrids, m_coarsenedMGrids);
+  m_agglomerationBuffer.clear();
+}
+
+// ---------------------------------------------------------
+LevelData<FArrayBox>& AMRPoissonOp::restrictionTarget(LevelData<FArrayBox>& a_resCoarse)
+{
+  if (!m_agglomeratedMGrids.isClosed())
+    {
+      return a_resCoarse;
+    }
+  if (!m_agglomerationBuffer.isDefined() ||
+      m_agglomerationBuffer.nComp() != a_resCoarse.nComp())
+    {
+      m_agglomerationBuffer.define(m_coarsenedMGrids, a_resCoarse.nComp());
+    }
+  return m_agglomerationBuffer;
+}
+
+// ---------------------------------------------------------
+void AMRPoissonOp::gatherRestricted(LevelData<FArrayBox>& a_resCoarse)
+{
+  if (m_agglomeratedMGrids.isClosed())
+    {
+      CH_TIME("gather");
+      m_agglomerationBuffer.copyTo(m_agglomerationBuffer.interval(),
+                                   a_resCoarse, a_resCoarse.interval(),
+                                   m_gatherCopier);
+    }
+}
+
+// ---------------------------------------------------------
+const LevelData<FArrayBox>&
+AMRPoissonOp::scatteredCorrection(const LevelData<FArrayBox>& a_correctCoarse)
+{
+  if (!m_agglomeratedMGrids.isClosed())
+    {
+      return a_correctCoarse;
+    }
+  CH_TIME("scatter");
+  if (!m_agglomerationBuffer.isDefined() ||
+      m_agglomerationBuffer.nComp() != a_correctCoarse.nComp())
+    {
+      m_agglomerationBuffer.define(m_coarsenedMGrids, a_correctCoarse.nComp());
+    }
+  a_correctCoarse.copyTo(a_correctCoarse.interval(),
+                         m_agglomerationBuffer, m_agglomerationBuffer.interval(),
+                         m_scatterCopier);
+  return m_agglomerationBuffer;
+}
+
 // ---------------------------------------------------------
 void AMRPoissonOp::restrictResidual(LevelData<FArrayBox>&       a_resCoarse,
                                     LevelData<FArrayBox>&       a_phiFine,
@@ -656,7 +862,7 @@ void AMRPoissonOp::restrictResidual(LevelData<FArrayBox>&       a_resCoarse,
 
   homogeneousCFInterp(a_phiFine);
 
-  if (s_exchangeMode == 0)
+  if (s_exchangeMode == 0 || s_exchangeMode == 2)
     a_phiFine.exchange(a_phiFine.interval(), m_exchangeCopier);
   else if (s_exchangeMode == 1)
     a_phiFine.exchangeNoOverlap(m_exchangeCopier);
@@ -676,6 +882,9 @@ void AMRPoissonOp::restrictResidual(LevelData<FArrayBox>&       a_resCoarse,
       }
   }//end pragma
 
+  // an agglomerated coarser level gets the residual through a buffer
+  LevelData<FArrayBox>* resCoarse = &restrictionTarget(a_resCoarse);
+
 #pragma omp parallel 
   {
 #pragma omp for 
@@ -683,7 +892,7 @@ void AMRPoissonOp::restrictResidual(LevelData<FArrayBox>&       a_resCoarse,
       {
         FArrayBox&       phi = a_phiFine[dit[ibox]];
         const FArrayBox& rhs = a_rhsFine[dit[ibox]];
-        FArrayBox&       res = a_resCoarse[dit[ibox]];
+        FArrayBox&       res = (*resCoarse)[dit[ibox]];
         
         Box region = dblFine[dit[ibox]];
         const IntVect& iv = region.smallEnd();
@@ -700,6 +909,8 @@ void AMRPoissonOp::restrictResidual(LevelData<FArrayBox>&       a_resCoarse,
                          CHF_CONST_REAL(m_dx));
       }
   }//end pragma
+
+  gatherRestricted(a_resCoarse);
 }
 
 // ---------------------------------------------------------
@@ -712,6 +923,9 @@ void AMRPoissonOp::prolongIncrement(LevelData<FArrayBox>&       a_phiThisLevel,
   int mgref = 2; //this is a multigrid func
   DataIterator dit = a_phiThisLevel.dataIterator();
   int nbox=dit.size();
+
+  // scatter the correction of an agglomerated coarser level
+  const LevelData<FArrayBox>* correctCoarse = &scatteredCorrection(a_correctCoarse);
   
 #pragma omp parallel 
   {
@@ -719,7 +933,7 @@ void AMRPoissonOp::prolongIncrement(LevelData<FArrayBox>&       a_phiThisLevel,
     for(int ibox = 0; ibox < nbox; ibox++)
       {
         FArrayBox& phi =  a_phiThisLevel[dit[ibox]];
-        const FArrayBox& coarse = a_correctCoarse[dit[ibox]];
+        const FArrayBox& coarse = (*correctCoarse)[dit[ibox]];
         Box region = dbl[dit[ibox]];
         const IntVect& iv = region.smallEnd();
         IntVect civ=coarsen(iv, 2);
@@ -1105,6 +1319,7 @@ void AMRPoissonOp::setAlphaAndBeta(const Real& a_alpha,
 {
   m_alpha = a_alpha * m_aCoef;
   m_beta  = a_beta  * m_bCoef;
+  m_chebyshev.reset();
 }
 
 // ---------------------------------------------------------
@@ -1227,6 +1442,8 @@ void AMRPoissonOp::levelGSRB( LevelData<FArrayBox>&       a_phi,
 
   DataIterator dit = a_phi.dataIterator();
   int nbox=dit.size();
+  TileIterator tit(dbl);
+  int ntile=tit.size();
   // do first red, then black passes
   for (int whichPass = 0; whichPass <= 1; whichPass++)
     {
@@ -1240,7 +1457,7 @@ void AMRPoissonOp::levelGSRB( LevelData<FArrayBox>&       a_phi,
 
       {
         CH_TIME("AMRPoissonOp::levelGSRB::exchange");
-        if (s_exchangeMode == 0)
+        if (s_exchangeMode == 0 || s_exchangeMode == 2)
           a_phi.exchange( a_phi.interval(), m_exchangeCopier );
         else if (s_exchangeMode == 1)
           a_phi.exchangeNoOverlap(m_exchangeCopier);
@@ -1252,15 +1469,22 @@ void AMRPoissonOp::levelGSRB( LevelData<FArrayBox>&       a_phi,
 #pragma omp for 
 	for (int ibox=0; ibox < nbox; ibox++)
           {
-            const Box& region = dbl[dit[ibox]];
-            FArrayBox& phiFab = a_phi[dit[ibox]];
-            
-            m_bc( phiFab, region, m_domain, m_dx, true );
+            m_bc( a_phi[dit[ibox]], dbl[dit[ibox]], m_domain, m_dx, true );
+          }
+
+        // the colors are those of the cells in the domain, so the tiles
+        // of a pass are independent
+#pragma omp for 
+	for (int itile=0; itile < ntile; itile++)
+          {
+            const Box& region = tit[itile];
+            const DataIndex& d = tit.index(itile);
+            FArrayBox& phiFab = a_phi[d];
             
             if (m_alpha == 0.0 && m_beta == 1.0 )
 	      {
 		FORT_GSRBLAPLACIAN(CHF_FRA(phiFab),
-				   CHF_CONST_FRA(a_rhs[dit[ibox]]),
+				   CHF_CONST_FRA(a_rhs[d]),
 				   CHF_BOX(region),
 				   CHF_CONST_REAL(m_dx),
 				   CHF_CONST_INT(whichPass));
@@ -1268,7 +1492,7 @@ void AMRPoissonOp::levelGSRB( LevelData<FArrayBox>&       a_phi,
             else
 	      {
 		FORT_GSRBHELMHOLTZ(CHF_FRA(phiFab),
-				   CHF_CONST_FRA(a_rhs[dit[ibox]]),
+				   CHF_CONST_FRA(a_rhs[d]),
 				   CHF_BOX(region),
 				   CHF_CONST_REAL(m_dx),
 				   CHF_CONST_REAL(m_alpha),
@@ -1345,6 +1569,8 @@ void AMRPoissonOp::looseGSRB(LevelData<FArrayBox>&       a_phi,
 
   DataIterator dit = a_phi.dataIterator();
   int nbox=dit.size();
+  TileIterator tit(dbl);
+  int ntile=tit.size();
   //fill in intersection of ghostcells and a_phi's boxes
   {
     CH_TIME("AMRPoissonOp::looseGSRB::homogeneousCFInterp");
@@ -1353,7 +1579,7 @@ void AMRPoissonOp::looseGSRB(LevelData<FArrayBox>&       a_phi,
 
   {
     CH_TIME("AMRPoissonOp::looseGSRB::exchange");
-    if (s_exchangeMode == 0)
+    if (s_exchangeMode == 0 || s_exchangeMode == 2)
       a_phi.exchange(a_phi.interval(), m_exchangeCopier);
     else if (s_exchangeMode == 1)
       a_phi.exchangeNoOverlap(m_exchangeCopier);
@@ -1368,50 +1594,39 @@ void AMRPoissonOp::looseGSRB(LevelData<FArrayBox>&       a_phi,
     for(int ibox = 0; ibox < nbox; ibox++)
       {
         // invoke physical BC's where necessary
-        {
+        m_bc(a_phi[dit[ibox]], dbl[dit[ibox]], m_domain, m_dx, true);
+      }
 
-          m_bc(a_phi[dit[ibox]], dbl[dit[ibox]], m_domain, m_dx, true);
-        }
-        
-        const Box& region = dbl[dit[ibox]];
-        
-        if (m_alpha == 0.0 && m_beta == 1.0)
-          {
-            int whichPass = 0;
-            FORT_GSRBLAPLACIAN(CHF_FRA(a_phi[dit[ibox]]),
-                               CHF_CONST_FRA(a_rhs[dit[ibox]]),
-                               CHF_BOX(region),
-                               CHF_CONST_REAL(m_dx),
-                               CHF_CONST_INT(whichPass));
-            
-            whichPass = 1;
-            FORT_GSRBLAPLACIAN(CHF_FRA(a_phi[dit[ibox]]),
-                               CHF_CONST_FRA(a_rhs[dit[ibox]]),
-                               CHF_BOX(region),
-                               CHF_CONST_REAL(m_dx),
-                               CHF_CONST_INT(whichPass));
-          }
-        else
+    // a pass reads the cells of the other color next to its tile, so
+    // every tile finishes the red pass before any starts the black one
+    for (int whichPass = 0; whichPass <= 1; whichPass++)
+      {
+#pragma omp for 
+        for(int itile = 0; itile < ntile; itile++)
           {
-            int whichPass = 0;
-            FORT_GSRBHELMHOLTZ(CHF_FRA(a_phi[dit[ibox]]),
-                               CHF_CONST_FRA(a_rhs[dit[ibox]]),
-                               CHF_BOX(region),
-                               CHF_CONST_REAL(m_dx),
-                               CHF_CONST_REAL(m_alpha),
-                               CHF_CONST_REAL(m_beta),
-                               CHF_CONST_INT(whichPass));
-            
-            whichPass = 1;
-            FORT_GSRBHELMHOLTZ(CHF_FRA(a_phi[dit[ibox]]),
-                               CHF_CONST_FRA(a_rhs[dit[ibox]]),
-                               CHF_BOX(region),
-                               CHF_CONST_REAL(m_dx),
-                               CHF_CONST_REAL(m_alpha),
-                               CHF_CONST_REAL(m_beta),
-                               CHF_CONST_INT(whichPass));
-          }
-      } // end loop through grids
+            const Box& region = tit[itile];
+            const DataIndex& d = tit.index(itile);
+
+            if (m_alpha == 0.0 && m_beta == 1.0)
+              {
+                FORT_GSRBLAPLACIAN(CHF_FRA(a_phi[d]),
+                                   CHF_CONST_FRA(a_rhs[d]),
+                                   CHF_BOX(region),
+                                   CHF_CONST_REAL(m_dx),
+                                   CHF_CONST_INT(whichPass));
+              }
+            else
+              {
+                FORT_GSRBHELMHOLTZ(CHF_FRA(a_phi[d]),
+                                   CHF_CONST_FRA(a_rhs[d]),
+                                   CHF_BOX(region),
+                                   CHF_CONST_REAL(m_dx),
+                                   CHF_CONST_REAL(m_alpha),
+                                   CHF_CONST_REAL(m_beta),
+                                   CHF_CONST_INT(whichPass));
+              }
+          } // end loop through tiles
+      }
   }//end pragma
 }
 
@@ -1594,6 +1809,155 @@ void AMRPoissonOp::levelJacobi(LevelData<FArrayBox>&       a_phi,
   incr(a_phi, resid, 0.666/weight);
 }
 
+// ---------------------------------------------------------
+void AMRPoissonOp::levelChebyshev(LevelData<FArrayBox>&       a_phi,
+                                  const LevelData<FArrayBox>& a_rhs,
+                                  int                         a_degree)
+{
+  CH_TIME("AMRPoissonOp::levelChebyshev");
+
+  m_chebyshev.relax(*this, a_phi, a_rhs, a_degree);
+}
+
+// ---------------------------------------------------------
+int AMRPoissonOp::sweepsPerExchange(int a_level)
+{
+  if (s_sweepsPerExchange.size() == 0)
+    {
+      s_sweepsPerExchange.push_back(2);
+      ParmParse pp("mg");
+      int n = pp.countval("sweeps_per_exchange");
+      if (n > 0)
+        {
+          pp.getarr("sweeps_per_exchange", s_sweepsPerExchange, 0, n);
+        }
+      for (int i = 0; i < s_sweepsPerExchange.size(); i++)
+        {
+          if (s_sweepsPerExchange[i] < 1)
+            {
+              MayDay::Error("mg.sweeps_per_exchange must be > 0");
+            }
+        }
+    }
+  return s_sweepsPerExchange[Min(a_level, (int)s_sweepsPerExchange.size()-1)];
+}
+
+// ---------------------------------------------------------
+void AMRPoissonOp::setSweepsPerExchange(const Vector<int>& a_sweeps)
+{
+  CH_assert(a_sweeps.size() > 0);
+  s_sweepsPerExchange = a_sweeps;
+}
+
+// ---------------------------------------------------------
+// GSRB that exchanges 2k ghost layers of phi and the right hand side
+// once every k iterations, k = m_sweepsPerExchange, and does the k red
+// and black pass pairs in between on regions that shrink by one cell per
+// pass, recomputing the cells of the neighboring boxes it needs.  The
+// result is that of levelGSRB.  The uncovered ghost cells at coarse-fine
+// interfaces are only one layer deep, so such levels use levelGSRB.
+void AMRPoissonOp::levelGSRBDeep(LevelData<FArrayBox>&       a_phi,
+                                 const LevelData<FArrayBox>& a_rhs,
+                                 int                         a_iterations)
+{
+  CH_TIME("AMRPoissonOp::levelGSRBDeep");
+
+  CH_assert(a_phi.nComp() == a_rhs.nComp());
+
+  const DisjointBoxLayout& dbl = a_rhs.disjointBoxLayout();
+  if (m_deepSweeps < 0)
+    {
+      m_deepSweeps = 0;
+      if (dbl.numCells() == m_domain.domainBox().numPts())
+        {
+          // no more ghost layers than the smallest box has cells
+          int minSize = m_domain.domainBox().longside();
+          for (LayoutIterator lit = dbl.layoutIterator(); lit.ok(); ++lit)
+            {
+              minSize = Min(minSize, dbl[lit].shortside());
+            }
+          m_deepSweeps = Max(1, Min(m_sweepsPerExchange, minSize/2));
+          m_deepCopier.define(dbl, dbl, 2*m_deepSweeps*IntVect::Unit, true);
+        }
+    }
+  if (m_deepSweeps == 0)
+    {
+      for (int i = 0; i < a_iterations; i++)
+        {
+          levelGSRB(a_phi, a_rhs);
+        }
+      return;
+    }
+
+  // phi and the right hand side side by side, so that one exchange
+  // carries both
+  const int ncomp = a_phi.nComp();
+  const Interval phiComps(0, ncomp-1);
+  const Interval rhsComps(ncomp, 2*ncomp-1);
+  LevelData<FArrayBox> work(dbl, 2*ncomp, 2*m_deepSweeps*IntVect::Unit);
+
+  DataIterator dit = a_phi.dataIterator();
+  int nbox = dit.size();
+#pragma omp parallel for
+  for (int ibox = 0; ibox < nbox; ibox++)
+    {
+      const Box& valid = dbl[dit[ibox]];
+      work[dit[ibox]].copy(a_phi[dit[ibox]], valid, 0, valid, 0, ncomp);
+      work[dit[ibox]].copy(a_rhs[dit[ibox]], valid, 0, valid, ncomp, ncomp);
+    }
+
+  for (int iter = 0; iter < a_iterations; iter += m_deepSweeps)
+    {
+      const int npass = 2*Min(m_deepSweeps, a_iterations - iter);
+      {
+        CH_TIME("AMRPoissonOp::levelGSRBDeep::exchange");
+        // the right hand side does not change
+        work.exchange((iter == 0) ? work.interval() : phiComps, m_deepCopier);
+      }
+
+#pragma omp parallel for
+      for (int ibox = 0; ibox < nbox; ibox++)
+        {
+          const Box& valid = dbl[dit[ibox]];
+          FArrayBox phiFab(phiComps, work[dit[ibox]]);
+          FArrayBox rhsFab(rhsComps, work[dit[ibox]]);
+          for (int pass = 0; pass < npass; pass++)
+            {
+              const int whichPass = pass % 2;
+              Box region = grow(valid, npass - 1 - pass);
+              region &= m_domain;
+              m_bc(phiFab, region, m_domain, m_dx, true);
+
+              if (m_alpha == 0.0 && m_beta == 1.0)
+                {
+                  FORT_GSRBLAPLACIAN(CHF_FRA(phiFab),
+                                     CHF_CONST_FRA(rhsFab),
+                                     CHF_BOX(region),
+                                     CHF_CONST_REAL(m_dx),
+                                     CHF_CONST_INT(whichPass));
+                }
+              else
+                {
+                  FORT_GSRBHELMHOLTZ(CHF_FRA(phiFab),
+                                     CHF_CONST_FRA(rhsFab),
+                                     CHF_BOX(region),
+                                     CHF_CONST_REAL(m_dx),
+                                     CHF_CONST_REAL(m_alpha),
+                                     CHF_CONST_REAL(m_beta),
+                                     CHF_CONST_INT(whichPass));
+                }
+            }
+        }
+    }
+
+#pragma omp parallel for
+  for (int ibox = 0; ibox < nbox; ibox++)
+    {
+      const Box& valid = dbl[dit[ibox]];
+      a_phi[dit[ibox]].copy(work[dit[ibox]], valid, 0, valid, 0, ncomp);
+    }
+}
+
 // ---------------------------------------------------------
 void AMRPoissonOp::homogeneousCFInterp(LevelData<FArrayBox>& a_phif)
 {
@@ -1881,6 +2245,8 @@ void AMRPoissonOpFactory::define(const ProblemDomain&             a_coarseDomain
   m_exchangeCopiers[0].trimEdges(a_grids[0], IntVect::Unit);
 
   m_cfregion.resize(a_grids.size());
+  m_agglomeratedGrids.resize(0);
+  m_agglomeratedGrids.resize(a_grids.size());
   m_cfregion[0].define(a_grids[0], m_domains[0]);
 
   for (int i = 1; i < a_grids.size(); i++)
@@ -1963,12 +2329,19 @@ MGLevelOp<LevelData<FArrayBox> >* AMRPoissonOpFactory::MGnewOp(const ProblemDoma
   dx *= coarsening;
 
   DisjointBoxLayout layout;
-  coarsen_dbl(layout, m_boxes[ref], coarsening);
+  bool agglomerated = mgCoarsen(layout, m_boxes[ref], a_depth, m_agglomeratedGrids[ref]);
 
   Copier ex = m_exchangeCopiers[ref];
   CFRegion cfregion = m_cfregion[ref];
 
-  if (coarsening > 1)
+  if (agglomerated)
+    {
+      // the boxes moved, so the coarsened copiers do not apply
+      ex.exchangeDefine(layout, IntVect::Unit);
+      ex.trimEdges(layout, IntVect::Unit);
+      cfregion.define(layout, domain);
+    }
+  else if (coarsening > 1)
     {
       ex.coarsen(coarsening);
       cfregion.coarsen(coarsening);
@@ -1977,6 +2350,13 @@ MGLevelOp<LevelData<FArrayBox> >* AMRPoissonOpFactory::MGnewOp(const ProblemDoma
   AMRPoissonOp* newOp = new AMRPoissonOp;
   newOp->define(layout, dx, domain, m_bc, ex, cfregion);
 
+  if (!agglomerated && mgAgglomerationDepth(m_boxes[ref]) == a_depth+1)
+    {
+      DisjointBoxLayout coarser;
+      mgCoarsen(coarser, m_boxes[ref], a_depth+1, m_agglomeratedGrids[ref]);
+      newOp->setAgglomeratedMGrids(layout, coarser);
+    }
+
   newOp->m_alpha = m_alpha;
   newOp->m_beta  = m_beta;
 
@@ -1984,6 +2364,7 @@ MGLevelOp<LevelData<FArrayBox> >* AMRPoissonOpFactory::MGnewOp(const ProblemDoma
   newOp->m_bCoef = m_beta;
 
   newOp->m_dxCrse = dxCrse;
+  newOp->m_sweepsPerExchange = AMRPoissonOp::sweepsPerExchange(ref);
 
   return (MGLevelOp<LevelData<FArrayBox> >*)newOp;
 }
@@ -2060,6 +2441,14 @@ AMRLevelOp<LevelData<FArrayBox> >* AMRPoissonOpFactory::AMRnewOp(const ProblemDo
   newOp->m_bCoef = m_beta;
 
   newOp->m_dxCrse = dxCrse;
+  newOp->m_sweepsPerExchange = AMRPoissonOp::sweepsPerExchange(ref);
+
+  if (mgAgglomerationDepth(m_boxes[ref]) == 1)
+    {
+      DisjointBoxLayout coarser;
+      mgCoarsen(coarser, m_boxes[ref], 1, m_agglomeratedGrids[ref]);
+      newOp->setAgglomeratedMGrids(m_boxes[ref], coarser);
+    }
 
   return (AMRLevelOp<LevelData<FArrayBox> >*)newOp;
 }
@@ -0,0 +1,181 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include "ChebyshevSmoother.H"
+#include "BoxIterator.H"
+#include "ParmParse.H"
+#include "MayDay.H"
+#include "CH_Timer.H"
+#include "NamespaceHeader.H"
+
+int  ChebyshevSmoother::s_powerIterations = -1;
+Real ChebyshevSmoother::s_eigenRatio = -1.0;
+
+// a value in [-1, 1) that depends on the cell and component only, so the
+// eigenvalue estimate does not depend on the layout
+static Real cellNoise(const IntVect& a_iv, int a_comp)
+{
+  unsigned int h = 2166136261u;
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      h = (h ^ (unsigned int)a_iv[idir])*16777619u;
+    }
+  h = (h ^ (unsigned int)a_comp)*16777619u;
+  h ^= h >> 15;
+  h *= 0x2c1b3c6du;
+  h ^= h >> 12;
+  return (h & 0xffffff)/Real(0x800000) - 1.0;
+}
+
+ChebyshevSmoother::ChebyshevSmoother()
+  :m_maxEigenvalue(-1.0)
+{
+}
+
+ChebyshevSmoother::~ChebyshevSmoother()
+{
+}
+
+void ChebyshevSmoother::setPowerIterations(int a_iterations)
+{
+  CH_assert(a_iterations > 0);
+  s_powerIterations = a_iterations;
+}
+
+int ChebyshevSmoother::powerIterations()
+{
+  if (s_powerIterations < 0)
+    {
+      s_powerIterations = 10;
+      ParmParse pp("mg");
+      pp.query("chebyshev_power_iterations", s_powerIterations);
+      if (s_powerIterations < 1)
+        {
+          MayDay::Error("mg.chebyshev_power_iterations must be > 0");
+        }
+    }
+  return s_powerIterations;
+}
+
+void ChebyshevSmoother::setEigenRatio(Real a_ratio)
+{
+  CH_assert(a_ratio > 0.0 && a_ratio < 1.0);
+  s_eigenRatio = a_ratio;
+}
+
+Real ChebyshevSmoother::eigenRatio()
+{
+  if (s_eigenRatio < 0.0)
+    {
+      s_eigenRatio = 0.3;
+      ParmParse pp("mg");
+      pp.query("chebyshev_eigen_ratio", s_eigenRatio);
+      if (s_eigenRatio <= 0.0 || s_eigenRatio >= 1.0)
+        {
+          MayDay::Error("mg.chebyshev_eigen_ratio must be in (0, 1)");
+        }
+    }
+  return s_eigenRatio;
+}
+
+Real ChebyshevSmoother::maxEigenvalue(LinearOp<LevelData<FArrayBox> >& a_op,
+                                      const LevelData<FArrayBox>&       a_phi)
+{
+  if (m_maxEigenvalue > 0.0)
+    {
+      return m_maxEigenvalue;
+    }
+  CH_TIME("ChebyshevSmoother::maxEigenvalue");
+
+  LevelData<FArrayBox> x, y;
+  a_op.create(x, a_phi);
+  a_op.create(y, a_phi);
+  a_op.setToZero(x);
+
+  const DisjointBoxLayout& grids = x.disjointBoxLayout();
+  for (DataIterator dit = x.dataIterator(); dit.ok(); ++dit)
+    {
+      FArrayBox& xfab = x[dit];
+      for (BoxIterator bit(grids[dit]); bit.ok(); ++bit)
+        {
+          for (int comp = 0; comp < xfab.nComp(); comp++)
+            {
+              xfab(bit(), comp) = cellNoise(bit(), comp);
+            }
+        }
+    }
+
+  Real xnorm = a_op.norm(x, 2);
+  Real lambda = 0.0;
+  const int niter = powerIterations();
+  for (int iter = 0; iter < niter && xnorm > 0.0; iter++)
+    {
+      a_op.applyOp(y, x, true);
+      a_op.divideByDiagonal(y);
+      Real ynorm = a_op.norm(y, 2);
+      lambda = ynorm/xnorm;
+      a_op.assignLocal(x, y);
+      a_op.scale(x, 1.0/ynorm);
+      xnorm = 1.0;
+    }
+  if (!(lambda > 0.0))
+    {
+      MayDay::Error("ChebyshevSmoother: cannot estimate the largest eigenvalue");
+    }
+  m_maxEigenvalue = lambda;
+
+  return m_maxEigenvalue;
+}
+
+void ChebyshevSmoother::relax(LinearOp<LevelData<FArrayBox> >& a_op,
+                              LevelData<FArrayBox>&             a_phi,
+                              const LevelData<FArrayBox>&       a_rhs,
+                              int                               a_degree,
+                              Real                              a_eigenRatio)
+{
+  CH_TIME("ChebyshevSmoother::relax");
+
+  // the bottom of a multigrid cycle may ask for no relaxation at all
+  if (a_degree < 1)
+    {
+      return;
+    }
+
+  // power iterations approach the largest eigenvalue from below
+  const Real upper = 1.1*maxEigenvalue(a_op, a_phi);
+  const Real lower = ((a_eigenRatio > 0.0) ? a_eigenRatio : eigenRatio())*upper;
+  const Real theta = 0.5*(upper + lower);
+  const Real delta = 0.5*(upper - lower);
+  const Real sigma = theta/delta;
+  Real rho = 1.0/sigma;
+
+  LevelData<FArrayBox> resid, dphi;
+  a_op.create(resid, a_rhs);
+  a_op.create(dphi,  a_rhs);
+
+  a_op.residual(resid, a_phi, a_rhs, true);
+  a_op.divideByDiagonal(resid);
+  a_op.assignLocal(dphi, resid);
+  a_op.scale(dphi, 1.0/theta);
+  a_op.incr(a_phi, dphi, 1.0);
+
+  for (int k = 1; k < a_degree; k++)
+    {
+      a_op.residual(resid, a_phi, a_rhs, true);
+      a_op.divideByDiagonal(resid);
+      const Real rhoNew = 1.0/(2.0*sigma - rho);
+      a_op.scale(dphi, rhoNew*rho);
+      a_op.incr(dphi, resid, 2.0*rhoNew/delta);
+      a_op.incr(a_phi, dphi, 1.0);
+      rho = rhoNew;
+    }
+}
+
+#include "NamespaceFooter.H"
@@ -0,0 +1,679 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include <cmath>
+#include <sstream>
+#include "FloatPoissonOp.H"
+#include "AMRPoissonOp.H"
+#include "FArrayBox.H"
+#include "BoxIterator.H"
+#include "IntVectSet.H"
+#include "SPMD.H"
+#include "MayDay.H"
+#include "CH_Timer.H"
+#include "NamespaceHeader.H"
+
+// offsets of the neighbors of a cell of a fab over a_box
+static IntVect fabStrides(const Box& a_box)
+{
+  IntVect strides;
+  strides[0] = 1;
+  for (int idir = 1; idir < SpaceDim; idir++)
+    {
+      strides[idir] = strides[idir-1]*a_box.size(idir-1);
+    }
+  return strides;
+}
+
+// the cells of a_box with the lowest index in direction 0: each starts a
+// row of a_box.size(0) cells that the kernels below run along
+static Box rowStarts(const Box& a_box)
+{
+  Box starts(a_box);
+  starts.setBig(0, a_box.smallEnd(0));
+  return starts;
+}
+
+// a_lphi[i] = alpha a_phi[i] + beta/dx^2 (sum of neighbors - 2 SpaceDim a_phi[i])
+static inline void applyRow(float*         a_lphi,
+                            const float*   a_phi,
+                            int            a_n,
+                            const IntVect& a_strides,
+                            float          a_alpha,
+                            float          a_betaDx2)
+{
+  const float center = a_alpha - 2*SpaceDim*a_betaDx2;
+  for (int i = 0; i < a_n; i++)
+    {
+      float sum = 0;
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          sum += a_phi[i+a_strides[idir]] + a_phi[i-a_strides[idir]];
+        }
+      a_lphi[i] = center*a_phi[i] + a_betaDx2*sum;
+    }
+}
+
+// one ghost cell of FloatPoissonOp::homogeneousCFInterp
+static inline void interpHomoCell(BaseFab<float>& a_phi,
+                                  const IntVect&  a_iv,
+                                  const IntVect&  a_inward,
+                                  bool            a_linear,
+                                  float           a_factor,
+                                  float           a_c1,
+                                  float           a_c2)
+{
+  for (int comp = 0; comp < a_phi.nComp(); comp++)
+    {
+      const float pa = a_phi(a_iv + a_inward, comp);
+      a_phi(a_iv, comp) = a_linear ? a_factor*pa :
+        a_c1*pa + a_c2*a_phi(a_iv + 2*a_inward, comp);
+    }
+}
+
+FloatPoissonOp::FloatPoissonOp()
+  :m_dx(-1.0),
+   m_dxCrse(-1.0),
+   m_alpha(0.0),
+   m_beta(1.0)
+{
+}
+
+FloatPoissonOp::~FloatPoissonOp()
+{
+}
+
+void FloatPoissonOp::define(const DisjointBoxLayout& a_grids,
+                            Real                     a_dx,
+                            Real                     a_dxCrse,
+                            const ProblemDomain&     a_domain,
+                            BCHolder                 a_bc,
+                            Real                     a_alpha,
+                            Real                     a_beta)
+{
+  CH_TIME("FloatPoissonOp::define");
+
+  m_grids  = a_grids;
+  m_dx     = a_dx;
+  m_dxCrse = a_dxCrse;
+  m_domain = a_domain;
+  m_bc     = a_bc;
+  m_alpha  = a_alpha;
+  m_beta   = a_beta;
+  m_coarsenedMGrids = DisjointBoxLayout();
+
+  m_exchangeCopier.exchangeDefine(a_grids, IntVect::Unit);
+  m_exchangeCopier.trimEdges(a_grids, IntVect::Unit);
+  m_cfregion.define(a_grids, a_domain);
+}
+
+// the ghost cells next to a_index that no box covers, extrapolated from
+// the valid cells and a zero coarse value as FORT_INTERPHOMO does
+void FloatPoissonOp::homogeneousCFInterp(BaseFab<float>&  a_phi,
+                                         const DataIndex& a_index)
+{
+  const float c1 = 2*(m_dxCrse - m_dx)/(m_dxCrse + m_dx);
+  const float c2 = -(m_dxCrse - m_dx)/(m_dxCrse + 3*m_dx);
+  const float factor = 1 - 2*m_dx/(m_dx + m_dxCrse);
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      // one valid cell across: linear, as FORT_INTERPHOMOLINEAR
+      const bool linear = (a_phi.box().size(idir) == 3);
+      for (SideIterator sit; sit.ok(); ++sit)
+        {
+          const CFIVS& cfivs = (sit() == Side::Lo) ?
+            m_cfregion.loCFIVS(a_index, idir) : m_cfregion.hiCFIVS(a_index, idir);
+          if (cfivs.isEmpty()) continue;
+
+          const IntVect inward = -sign(sit())*BASISV(idir);
+          if (cfivs.isPacked())
+            {
+              for (BoxIterator bit(cfivs.packedBox()); bit.ok(); ++bit)
+                {
+                  interpHomoCell(a_phi, bit(), inward, linear, factor, c1, c2);
+                }
+            }
+          else
+            {
+              for (IVSIterator ivsit(cfivs.getFineIVS()); ivsit.ok(); ++ivsit)
+                {
+                  interpHomoCell(a_phi, ivsit(), inward, linear, factor, c1, c2);
+                }
+            }
+        }
+    }
+}
+
+void FloatPoissonOp::fillBoundaryGhosts(BaseFab<float>& a_phi,
+                                        const Box&      a_valid)
+{
+  const int ncomp = a_phi.nComp();
+  // AMRPoissonOp hands every box to m_bc, which decides which of its
+  // faces are on the domain boundary, so every face is done here too
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      for (SideIterator sit; sit.ok(); ++sit)
+        {
+          Box ghost = adjCellBox(a_valid, idir, sit(), 1);
+
+          // the two layers of valid cells next to the face, with their
+          // ghost cells, in double precision
+          Box slab(a_valid);
+          if (sit() == Side::Lo)
+            {
+              slab.setBig(idir, Min(a_valid.smallEnd(idir)+1, a_valid.bigEnd(idir)));
+            }
+          else
+            {
+              slab.setSmall(idir, Max(a_valid.bigEnd(idir)-1, a_valid.smallEnd(idir)));
+            }
+          Box region = grow(slab, 1);
+          region &= a_phi.box();
+          FArrayBox state(grow(slab, 1), ncomp);
+          state.setVal(0.0);
+          for (BoxIterator bit(region); bit.ok(); ++bit)
+            {
+              for (int comp = 0; comp < ncomp; comp++)
+                {
+                  state(bit(), comp) = a_phi(bit(), comp);
+                }
+            }
+
+          m_bc(state, slab, m_domain, m_dx, true);
+
+          ghost &= a_phi.box();
+          for (BoxIterator bit(ghost); bit.ok(); ++bit)
+            {
+              for (int comp = 0; comp < ncomp; comp++)
+                {
+                  a_phi(bit(), comp) = state(bit(), comp);
+                }
+            }
+        }
+    }
+}
+
+void FloatPoissonOp::fillGhosts(FloatLevelData& a_phi)
+{
+  CH_TIME("FloatPoissonOp::fillGhosts");
+
+  CH_assert(a_phi.ghostVect() >= IntVect::Unit);
+  DataIterator dit = a_phi.dataIterator();
+  int nbox = dit.size();
+#pragma omp parallel for
+  for (int ibox = 0; ibox < nbox; ibox++)
+    {
+      homogeneousCFInterp(a_phi[dit[ibox]], dit[ibox]);
+    }
+  a_phi.exchange(m_exchangeCopier);
+#pragma omp parallel for
+  for (int ibox = 0; ibox < nbox; ibox++)
+    {
+      fillBoundaryGhosts(a_phi[dit[ibox]], m_grids[dit[ibox]]);
+    }
+}
+
+void FloatPoissonOp::residual(FloatLevelData&       a_lhs,
+                              const FloatLevelData& a_phi,
+                              const FloatLevelData& a_rhs,
+                              bool                  a_homogeneous)
+{
+  CH_TIME("FloatPoissonOp::residual");
+
+  applyOp(a_lhs, a_phi, a_homogeneous);
+  axby(a_lhs, a_rhs, a_lhs, 1.0, -1.0);
+}
+
+void FloatPoissonOp::preCond(FloatLevelData&       a_correction,
+                             const FloatLevelData& a_residual)
+{
+  CH_TIME("FloatPoissonOp::preCond");
+
+  assignLocal(a_correction, a_residual);
+  divideByDiagonal(a_correction);
+  relax(a_correction, a_residual, 2);
+}
+
+void FloatPoissonOp::applyOp(FloatLevelData&       a_lhs,
+                             const FloatLevelData& a_phi,
+                             bool                  a_homogeneous)
+{
+  CH_TIME("FloatPoissonOp::applyOp");
+
+  if (!a_homogeneous)
+    {
+      MayDay::Error("FloatPoissonOp: only homogeneous boundary conditions are supported");
+    }
+  FloatLevelData& phi = (FloatLevelData&)a_phi;
+  fillGhosts(phi);
+
+  const float alpha = m_alpha;
+  const float betaDx2 = m_beta/(m_dx*m_dx);
+  DataIterator dit = a_lhs.dataIterator();
+  int nbox = dit.size();
+#pragma omp parallel for
+  for (int ibox = 0; ibox < nbox; ibox++)
+    {
+      const Box& valid = m_grids[dit[ibox]];
+      BaseFab<float>& lhs = a_lhs[dit[ibox]];
+      const BaseFab<float>& phiFab = phi[dit[ibox]];
+      const IntVect strides = fabStrides(phiFab.box());
+      const int n = valid.size(0);
+      for (int comp = 0; comp < lhs.nComp(); comp++)
+        {
+          for (BoxIterator bit(rowStarts(valid)); bit.ok(); ++bit)
+            {
+              applyRow(&lhs(bit(), comp), &phiFab(bit(), comp), n, strides, alpha, betaDx2);
+            }
+        }
+    }
+}
+
+void FloatPoissonOp::create(FloatLevelData&       a_lhs,
+                            const FloatLevelData& a_rhs)
+{
+  a_lhs.define(a_rhs.disjointBoxLayout(), a_rhs.nComp(), a_rhs.ghostVect());
+}
+
+void FloatPoissonOp::assign(FloatLevelData&       a_lhs,
+                            const FloatLevelData& a_rhs)
+{
+  CH_TIME("FloatPoissonOp::assign");
+
+  a_rhs.copyTo(a_rhs.interval(), a_lhs, a_lhs.interval());
+}
+
+void FloatPoissonOp::assignLocal(FloatLevelData&       a_lhs,
+                                 const FloatLevelData& a_rhs)
+{
+  CH_TIME("FloatPoissonOp::assignLocal");
+
+  DataIterator dit = a_lhs.dataIterator();
+  int nbox = dit.size();
+#pragma omp parallel for
+  for (int ibox = 0; ibox < nbox; ibox++)
+    {
+      const Box& valid = m_grids[dit[ibox]];
+      a_lhs[dit[ibox]].copy(a_rhs[dit[ibox]], valid);
+    }
+}
+
+Real FloatPoissonOp::localDotProduct(const FloatLevelData& a_1,
+                                     const FloatLevelData& a_2)
+{
+  CH_TIME("FloatPoissonOp::localDotProduct");
+
+  Real val = 0.0;
+  DataIterator dit = a_1.dataIterator();
+  int nbox = dit.size();
+#pragma omp parallel for reduction (+:val)
+  for (int ibox = 0; ibox < nbox; ibox++)
+    {
+      const Box& valid = m_grids[dit[ibox]];
+      const BaseFab<float>& fab1 = a_1[dit[ibox]];
+      const BaseFab<float>& fab2 = a_2[dit[ibox]];
+      const int n = valid.size(0);
+      for (int comp = 0; comp < fab1.nComp(); comp++)
+        {
+          for (BoxIterator bit(rowStarts(valid)); bit.ok(); ++bit)
+            {
+              const float* p1 = &fab1(bit(), comp);
+              const float* p2 = &fab2(bit(), comp);
+              for (int i = 0; i < n; i++)
+                {
+                  val += (Real)p1[i]*p2[i];
+                }
+            }
+        }
+    }
+  return val;
+}
+
+Real FloatPoissonOp::dotProduct(const FloatLevelData& a_1,
+                                const FloatLevelData& a_2)
+{
+  CH_TIME("FloatPoissonOp::dotProduct");
+
+  Real val = localDotProduct(a_1, a_2);
+#ifdef CH_MPI
+  Real recv;
+  int result = MPI_Allreduce(&val, &recv, 1, MPI_CH_REAL,
+                             MPI_SUM, Chombo_MPI::comm);
+  if (result != MPI_SUCCESS)
+    {
+      std::ostringstream msg;
+      msg << "FloatPoissonOp::dotProduct() called MPI_Allreduce() which returned error code " << result;
+      MayDay::Warning(msg.str().c_str());
+    }
+  val = recv;
+#endif
+  return val;
+}
+
+void FloatPoissonOp::incr(FloatLevelData&       a_lhs,
+                          const FloatLevelData& a_x,
+                          Real                  a_scale)
+{
+  axby(a_lhs, a_lhs, a_x, 1.0, a_scale);
+}
+
+void FloatPoissonOp::axby(FloatLevelData&       a_lhs,
+                          const FloatLevelData& a_x,
+                          const FloatLevelData& a_y,
+                          Real                  a_a,
+                          Real                  a_b)
+{
+  CH_TIME("FloatPoissonOp::axby");
+
+  const float a = a_a;
+  const float b = a_b;
+  DataIterator dit = a_lhs.dataIterator();
+  int nbox = dit.size();
+#pragma omp parallel for
+  for (int ibox = 0; ibox < nbox; ibox++)
+    {
+      const Box& valid = m_grids[dit[ibox]];
+      BaseFab<float>& lhs = a_lhs[dit[ibox]];
+      const BaseFab<float>& x = a_x[dit[ibox]];
+      const BaseFab<float>& y = a_y[dit[ibox]];
+      const int n = valid.size(0);
+      for (int comp = 0; comp < lhs.nComp(); comp++)
+        {
+          for (BoxIterator bit(rowStarts(valid)); bit.ok(); ++bit)
+            {
+              float* l = &lhs(bit(), comp);
+              const float* px = &x(bit(), comp);
+              const float* py = &y(bit(), comp);
+              for (int i = 0; i < n; i++)
+                {
+                  l[i] = a*px[i] + b*py[i];
+                }
+            }
+        }
+    }
+}
+
+void FloatPoissonOp::scale(FloatLevelData& a_lhs,
+                           const Real&     a_scale)
+{
+  CH_TIME("FloatPoissonOp::scale");
+
+  DataIterator dit = a_lhs.dataIterator();
+  int nbox = dit.size();
+#pragma omp parallel for
+  for (int ibox = 0; ibox < nbox; ibox++)
+    {
+      BaseFab<float>& lhs = a_lhs[dit[ibox]];
+      float* p = lhs.dataPtr();
+      const long n = lhs.box().numPts()*lhs.nComp();
+      const float s = a_scale;
+      for (long i = 0; i < n; i++)
+        {
+          p[i] *= s;
+        }
+    }
+}
+
+void FloatPoissonOp::divideByDiagonal(FloatLevelData& a_lhs)
+{
+  scale(a_lhs, 1.0/(m_alpha - 2.0*SpaceDim*m_beta/(m_dx*m_dx)));
+}
+
+Real FloatPoissonOp::norm(const FloatLevelData& a_x,
+                          int                   a_ord)
+{
+  CH_TIME("FloatPoissonOp::norm");
+
+  Real val = 0.0;
+  DataIterator dit = a_x.dataIterator();
+  for (dit.begin(); dit.ok(); ++dit)
+    {
+      const Box& valid = m_grids[dit];
+      const BaseFab<float>& x = a_x[dit];
+      const int n = valid.size(0);
+      for (int comp = 0; comp < x.nComp(); comp++)
+        {
+          for (BoxIterator bit(rowStarts(valid)); bit.ok(); ++bit)
+            {
+              const float* px = &x(bit(), comp);
+              for (int i = 0; i < n; i++)
+                {
+                  Real absx = Abs((Real)px[i]);
+                  if (a_ord == 0)
+                    {
+                      val = Max(val, absx);
+                    }
+                  else
+                    {
+                      val += pow(absx, a_ord);
+                    }
+                }
+            }
+        }
+    }
+#ifdef CH_MPI
+  Real recv;
+  int result = MPI_Allreduce(&val, &recv, 1, MPI_CH_REAL,
+                             (a_ord == 0) ? MPI_MAX : MPI_SUM, Chombo_MPI::comm);
+  if (result != MPI_SUCCESS)
+    {
+      std::ostringstream msg;
+      msg << "FloatPoissonOp::norm() called MPI_Allreduce() which returned error code " << result;
+      MayDay::Warning(msg.str().c_str());
+    }
+  val = recv;
+#endif
+  if (a_ord > 0)
+    {
+      val = pow(val, 1.0/a_ord);
+    }
+  return val;
+}
+
+void FloatPoissonOp::setToZero(FloatLevelData& a_lhs)
+{
+  CH_TIME("FloatPoissonOp::setToZero");
+
+  DataIterator dit = a_lhs.dataIterator();
+  int nbox = dit.size();
+#pragma omp parallel for
+  for (int ibox = 0; ibox < nbox; ibox++)
+    {
+      a_lhs[dit[ibox]].setVal(0.0f);
+    }
+}
+
+void FloatPoissonOp::relax(FloatLevelData&       a_e,
+                           const FloatLevelData& a_residual,
+                           int                   a_iterations)
+{
+  CH_TIME("FloatPoissonOp::relax");
+
+  const float alpha = m_alpha;
+  const float betaDx2 = m_beta/(m_dx*m_dx);
+  const float invDiagonal = 1.0/(m_alpha - 2.0*SpaceDim*m_beta/(m_dx*m_dx));
+  DataIterator dit = a_e.dataIterator();
+  int nbox = dit.size();
+  for (int iter = 0; iter < a_iterations; iter++)
+    {
+      for (int color = 0; color < 2; color++)
+        {
+          fillGhosts(a_e);
+#pragma omp parallel for
+          for (int ibox = 0; ibox < nbox; ibox++)
+            {
+              const Box& valid = m_grids[dit[ibox]];
+              BaseFab<float>& phi = a_e[dit[ibox]];
+              const BaseFab<float>& rhs = a_residual[dit[ibox]];
+              const IntVect strides = fabStrides(phi.box());
+              const int n = valid.size(0);
+              for (int comp = 0; comp < phi.nComp(); comp++)
+                {
+                  for (BoxIterator bit(rowStarts(valid)); bit.ok(); ++bit)
+                    {
+                      int parity = bit().sum() % 2;
+                      if (parity < 0) parity += 2;
+                      float* p = &phi(bit(), comp);
+                      const float* r = &rhs(bit(), comp);
+                      for (int i = (color + parity) % 2; i < n; i += 2)
+                        {
+                          float sum = 0;
+                          for (int idir = 0; idir < SpaceDim; idir++)
+                            {
+                              sum += p[i+strides[idir]] + p[i-strides[idir]];
+                            }
+                          float lphi = (alpha - 2*SpaceDim*betaDx2)*p[i] + betaDx2*sum;
+                          p[i] += invDiagonal*(r[i] - lphi);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void FloatPoissonOp::createCoarser(FloatLevelData&       a_coarse,
+                                   const FloatLevelData& a_fine,
+                                   bool                  a_ghosted)
+{
+  CH_assert(a_fine.disjointBoxLayout().coarsenable(2));
+  if (m_coarsenedMGrids.size() == 0)
+    {
+      coarsen(m_coarsenedMGrids, a_fine.disjointBoxLayout(), 2);
+    }
+  a_coarse.define(m_coarsenedMGrids, a_fine.nComp(), a_fine.ghostVect());
+}
+
+void FloatPoissonOp::restrictResidual(FloatLevelData&       a_resCoarse,
+                                      FloatLevelData&       a_phiFine,
+                                      const FloatLevelData& a_rhsFine)
+{
+  CH_TIME("FloatPoissonOp::restrictResidual");
+
+  fillGhosts(a_phiFine);
+
+  const float alpha = m_alpha;
+  const float betaDx2 = m_beta/(m_dx*m_dx);
+  const float weight = 1.0/(1 << SpaceDim);
+  DataIterator dit = a_phiFine.dataIterator();
+  int nbox = dit.size();
+#pragma omp parallel for
+  for (int ibox = 0; ibox < nbox; ibox++)
+    {
+      const Box& valid = m_grids[dit[ibox]];
+      const BaseFab<float>& phi = a_phiFine[dit[ibox]];
+      const BaseFab<float>& rhs = a_rhsFine[dit[ibox]];
+      BaseFab<float>& res = a_resCoarse[dit[ibox]];
+      res.setVal(0.0f);
+      const IntVect strides = fabStrides(phi.box());
+      const int n = valid.size(0);
+      CH_assert(valid.smallEnd(0) % 2 == 0);
+      float* lphi = new float[n];
+      for (int comp = 0; comp < phi.nComp(); comp++)
+        {
+          for (BoxIterator bit(rowStarts(valid)); bit.ok(); ++bit)
+            {
+              applyRow(lphi, &phi(bit(), comp), n, strides, alpha, betaDx2);
+              const float* r = &rhs(bit(), comp);
+              float* c = &res(coarsen(bit(), 2), comp);
+              for (int i = 0; i < n; i++)
+                {
+                  c[i/2] += weight*(r[i] - lphi[i]);
+                }
+            }
+        }
+      delete[] lphi;
+    }
+}
+
+void FloatPoissonOp::prolongIncrement(FloatLevelData&       a_phiThisLevel,
+                                      const FloatLevelData& a_correctCoarse)
+{
+  CH_TIME("FloatPoissonOp::prolongIncrement");
+
+  DataIterator dit = a_phiThisLevel.dataIterator();
+  int nbox = dit.size();
+#pragma omp parallel for
+  for (int ibox = 0; ibox < nbox; ibox++)
+    {
+      const Box& valid = m_grids[dit[ibox]];
+      BaseFab<float>& phi = a_phiThisLevel[dit[ibox]];
+      const BaseFab<float>& cor = a_correctCoarse[dit[ibox]];
+      const int n = valid.size(0);
+      CH_assert(valid.smallEnd(0) % 2 == 0);
+      for (int comp = 0; comp < phi.nComp(); comp++)
+        {
+          for (BoxIterator bit(rowStarts(valid)); bit.ok(); ++bit)
+            {
+              float* p = &phi(bit(), comp);
+              const float* c = &cor(coarsen(bit(), 2), comp);
+              for (int i = 0; i < n; i++)
+                {
+                  p[i] += c[i/2];
+                }
+            }
+        }
+    }
+}
+
+FloatPoissonOpFactory::FloatPoissonOpFactory()
+  :m_dx(-1.0),
+   m_dxCrse(-1.0),
+   m_alpha(0.0),
+   m_beta(1.0)
+{
+}
+
+FloatPoissonOpFactory::~FloatPoissonOpFactory()
+{
+}
+
+void FloatPoissonOpFactory::define(const DisjointBoxLayout& a_grids,
+                                   Real                     a_dx,
+                                   const ProblemDomain&     a_domain,
+                                   BCHolder                 a_bc,
+                                   Real                     a_alpha,
+                                   Real                     a_beta,
+                                   Real                     a_dxCrse)
+{
+  m_grids  = a_grids;
+  m_dx     = a_dx;
+  m_dxCrse = a_dxCrse;
+  m_domain = a_domain;
+  m_bc     = a_bc;
+  m_alpha  = a_alpha;
+  m_beta   = a_beta;
+}
+
+MGLevelOp<LevelData<BaseFab<float> > >* FloatPoissonOpFactory::MGnewOp(const ProblemDomain& a_indexSpace,
+                                                                       int                  a_depth,
+                                                                       bool                 a_homoOnly)
+{
+  CH_TIME("FloatPoissonOpFactory::MGnewOp");
+
+  CH_assert(a_indexSpace.domainBox() == m_domain.domainBox());
+
+  int coarsening = 1 << a_depth;
+  if (coarsening > 1 && !m_grids.coarsenable(coarsening*AMRPoissonOp::s_maxCoarse))
+    {
+      return NULL;
+    }
+
+  ProblemDomain domain(m_domain);
+  domain.coarsen(coarsening);
+  DisjointBoxLayout layout;
+  coarsen_dbl(layout, m_grids, coarsening);
+
+  FloatPoissonOp* newOp = new FloatPoissonOp;
+  newOp->define(layout, m_dx*coarsening, m_dxCrse, domain, m_bc, m_alpha, m_beta);
+  return newOp;
+}
+
+#include "NamespaceFooter.H"
@@ -0,0 +1,116 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include "MGAgglomeration.H"
+#include "LoadBalance.H"
+#include "LayoutIterator.H"
+#include "ParmParse.H"
+#include "SPMD.H"
+#include "MayDay.H"
+#include "CH_Timer.H"
+#include "NamespaceHeader.H"
+
+static long long s_mgAgglomerationCells = -1;
+
+void setMGAgglomerationCells(long long a_cells)
+{
+  CH_assert(a_cells >= 0);
+  s_mgAgglomerationCells = a_cells;
+}
+
+long long mgAgglomerationCells()
+{
+  if (s_mgAgglomerationCells < 0)
+    {
+      s_mgAgglomerationCells = 0;
+      ParmParse pp("mg");
+      int cells;
+      if (pp.query("agglomerate_cells", cells))
+        {
+          if (cells < 0) MayDay::Error("mg.agglomerate_cells must be >= 0");
+          s_mgAgglomerationCells = cells;
+        }
+    }
+  return s_mgAgglomerationCells;
+}
+
+static long long numCells(const DisjointBoxLayout& a_grids)
+{
+  long long cells = 0;
+  for (LayoutIterator lit = a_grids.layoutIterator(); lit.ok(); ++lit)
+    {
+      cells += a_grids[lit()].numPts();
+    }
+  return cells;
+}
+
+int mgAgglomerationDepth(const DisjointBoxLayout& a_grids)
+{
+  const long long minCells = mgAgglomerationCells();
+  const long long nproc = numProc();
+  if (minCells == 0 || nproc == 1)
+    {
+      return -1;
+    }
+  long long cells = numCells(a_grids);
+  long long perCoarsening = 1;
+  for (int idir = 0; idir < SpaceDim; idir++) perCoarsening *= 2;
+  for (int depth = 1; cells > 0; depth++)
+    {
+      cells /= perCoarsening;
+      if (cells < minCells*nproc)
+        {
+          return depth;
+        }
+    }
+  return -1;
+}
+
+bool mgCoarsen(DisjointBoxLayout&       a_coarse,
+               const DisjointBoxLayout& a_grids,
+               int                      a_depth,
+               DisjointBoxLayout&       a_agglomerated)
+{
+  CH_TIME("mgCoarsen");
+  const int aggDepth = mgAgglomerationDepth(a_grids);
+  if (aggDepth < 0 || a_depth < aggDepth)
+    {
+      coarsen_dbl(a_coarse, a_grids, 1 << a_depth);
+      return false;
+    }
+
+  if (!a_agglomerated.isClosed())
+    {
+      const int aggCoarsening = 1 << aggDepth;
+      Vector<Box> boxes;
+      long long cells = 0;
+      for (LayoutIterator lit = a_grids.layoutIterator(); lit.ok(); ++lit)
+        {
+          Box b = coarsen(a_grids[lit()], aggCoarsening);
+          cells += b.numPts();
+          boxes.push_back(b);
+        }
+      long long nproc = cells/mgAgglomerationCells();
+      if (nproc < 1) nproc = 1;
+      if (nproc > numProc()) nproc = numProc();
+
+      Vector<int> procs;
+      LoadBalance(procs, boxes, nproc);
+
+      ProblemDomain domain = a_grids.physDomain();
+      domain.coarsen(aggCoarsening);
+      a_agglomerated.define(boxes, procs, domain);
+    }
+
+  coarsen_dbl(a_coarse, a_agglomerated, 1 << (a_depth - aggDepth));
+  return true;
+}
+
+#include "NamespaceFooter.H"
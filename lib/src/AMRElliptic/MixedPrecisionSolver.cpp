@@ -0,0 +1,172 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include "MixedPrecisionSolver.H"
+#include "BoxIterator.H"
+#include "parstream.H"
+#include "CH_Timer.H"
+#include "NamespaceHeader.H"
+
+// a_lhs = a_rhs on the valid cells, in the precision of a_lhs
+template <class T, class S>
+static void convert(LevelData<T>& a_lhs, const LevelData<S>& a_rhs)
+{
+  CH_TIME("MixedPrecisionSolver::convert");
+
+  const DisjointBoxLayout& grids = a_lhs.disjointBoxLayout();
+  DataIterator dit = a_lhs.dataIterator();
+  int nbox = dit.size();
+#pragma omp parallel for
+  for (int ibox = 0; ibox < nbox; ibox++)
+    {
+      const Box& valid = grids[dit[ibox]];
+      T& lhs = a_lhs[dit[ibox]];
+      const S& rhs = a_rhs[dit[ibox]];
+      Box rows(valid);
+      rows.setBig(0, valid.smallEnd(0));
+      const int n = valid.size(0);
+      for (int comp = 0; comp < lhs.nComp(); comp++)
+        {
+          for (BoxIterator bit(rows); bit.ok(); ++bit)
+            {
+              auto* l = &lhs(bit(), comp);
+              const auto* r = &rhs(bit(), comp);
+              for (int i = 0; i < n; i++)
+                {
+                  l[i] = r[i];
+                }
+            }
+        }
+    }
+}
+
+MixedPrecisionSolver::MixedPrecisionSolver()
+  :m_homogeneous(false),
+   m_op(NULL),
+   m_imax(40),
+   m_numCycles(1),
+   m_verbosity(3),
+   m_eps(1.0E-50),
+   m_reps(1.0E-10),
+   m_exitStatus(-1),
+   m_normType(0)
+{
+  m_bottomSolver.m_verbosity = 0;
+}
+
+MixedPrecisionSolver::~MixedPrecisionSolver()
+{
+  m_op = NULL;
+}
+
+void MixedPrecisionSolver::define(LinearOp<LevelData<FArrayBox> >* a_op,
+                                  FloatPoissonOpFactory&            a_factory,
+                                  const ProblemDomain&              a_domain,
+                                  bool                              a_homogeneous)
+{
+  CH_TIME("MixedPrecisionSolver::define");
+
+  define(a_op, a_homogeneous);
+  m_mg.define(a_factory, &m_bottomSolver, a_domain);
+}
+
+void MixedPrecisionSolver::define(LinearOp<LevelData<FArrayBox> >* a_op,
+                                  bool                              a_homogeneous)
+{
+  m_homogeneous = a_homogeneous;
+  m_op = a_op;
+}
+
+void MixedPrecisionSolver::setConvergenceMetrics(Real a_metric,
+                                                 Real a_tolerance)
+{
+  m_eps = a_tolerance;
+}
+
+void MixedPrecisionSolver::solve(LevelData<FArrayBox>&       a_phi,
+                                 const LevelData<FArrayBox>& a_rhs)
+{
+  CH_TIMERS("MixedPrecisionSolver::solve");
+  CH_TIMER("MixedPrecisionSolver::solve::residual", timeResidual);
+  CH_TIMER("MixedPrecisionSolver::solve::cycles", timeCycles);
+
+  CH_assert(m_op != NULL);
+
+  const DisjointBoxLayout& grids = a_rhs.disjointBoxLayout();
+  LevelData<FArrayBox> r, e;
+  m_op->create(r, a_rhs);
+  m_op->create(e, a_phi);
+  m_op->setToZero(e);
+  LevelData<BaseFab<float> > rf(grids, a_rhs.nComp(), IntVect::Zero);
+  LevelData<BaseFab<float> > ef(grids, a_phi.nComp(), a_phi.ghostVect());
+  m_mg.init(ef, rf);
+
+  CH_START(timeResidual);
+  m_op->residual(r, a_phi, a_rhs, m_homogeneous);
+  Real res = m_op->norm(r, m_normType);
+  CH_STOP(timeResidual);
+  const Real rnorm0 = res;
+  if (m_verbosity >= 3)
+    {
+      pout() << "MixedPrecisionSolver::solve initial residual = " << rnorm0 << endl;
+    }
+
+  m_exitStatus = -1;
+  int iter = 0;
+  while (m_exitStatus == -1)
+    {
+      if (res == 0.0 || res <= m_reps*rnorm0 || res <= m_eps)
+        {
+          m_exitStatus = 1;
+          break;
+        }
+      if (iter >= m_imax)
+        {
+          m_exitStatus = 3;
+          break;
+        }
+
+      CH_START(timeCycles);
+      convert(rf, r);
+      for (DataIterator dit = ef.dataIterator(); dit.ok(); ++dit)
+        {
+          ef[dit].setVal(0.0f);
+        }
+      for (int icycle = 0; icycle < m_numCycles; icycle++)
+        {
+          m_mg.oneCycle(ef, rf);
+        }
+      convert(e, ef);
+      CH_STOP(timeCycles);
+
+      CH_START(timeResidual);
+      m_op->incr(a_phi, e, 1.0);
+      m_op->residual(r, a_phi, a_rhs, m_homogeneous);
+      res = m_op->norm(r, m_normType);
+      CH_STOP(timeResidual);
+
+      iter++;
+      if (m_verbosity >= 4)
+        {
+          pout() << iter << ") MixedPrecisionSolver residual = " << res << endl;
+        }
+    }
+
+  if (m_verbosity >= 3)
+    {
+      pout() << "MixedPrecisionSolver::solve done, status = " << m_exitStatus
+             << ", " << iter << " iterations, residual = " << res << endl;
+    }
+
+  m_op->clear(r);
+  m_op->clear(e);
+}
+
+#include "NamespaceFooter.H"
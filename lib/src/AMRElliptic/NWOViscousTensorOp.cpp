@@ -950,6 +950,14 @@ dotProduct(const LevelData<FArrayBox>& a_1,
   return m_levelOps.dotProduct(a_1, a_2);
 }
 /***/
+Real
+NWOViscousTensorOp::
+localDotProduct(const LevelData<FArrayBox>& a_1,
+                const LevelData<FArrayBox>& a_2)
+{
+  return m_levelOps.localDotProduct(a_1, a_2);
+}
+/***/
 void
 NWOViscousTensorOp::
 incr( LevelData<FArrayBox>&       a_lhs,
@@ -0,0 +1,76 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include <sstream>
+#include "NonBlockingSum.H"
+#include "MayDay.H"
+#include "CH_Timer.H"
+#include "NamespaceHeader.H"
+
+NonBlockingSum::NonBlockingSum()
+  :m_pending(false)
+{
+}
+
+NonBlockingSum::~NonBlockingSum()
+{
+  if (m_pending)
+    {
+      Vector<Real> sum;
+      finish(sum);
+    }
+}
+
+void NonBlockingSum::start(const Vector<Real>& a_local)
+{
+  CH_TIME("NonBlockingSum::start");
+  CH_assert(!m_pending);
+  m_local = a_local;
+  m_sum.resize(m_local.size());
+  m_pending = true;
+#ifdef CH_MPI
+  if (m_local.size() > 0)
+    {
+      int result = MPI_Iallreduce(&(m_local[0]), &(m_sum[0]), m_local.size(),
+                                  MPI_CH_REAL, MPI_SUM, Chombo_MPI::comm,
+                                  &m_request);
+      if (result != MPI_SUCCESS)
+        {
+          std::ostringstream msg;
+          msg << "NonBlockingSum::start() called MPI_Iallreduce() which returned error code " << result;
+          MayDay::Error(msg.str().c_str());
+        }
+    }
+#else
+  m_sum = m_local;
+#endif
+}
+
+void NonBlockingSum::finish(Vector<Real>& a_sum)
+{
+  CH_TIME("NonBlockingSum::finish");
+  CH_assert(m_pending);
+#ifdef CH_MPI
+  if (m_local.size() > 0)
+    {
+      int result = MPI_Wait(&m_request, MPI_STATUS_IGNORE);
+      if (result != MPI_SUCCESS)
+        {
+          std::ostringstream msg;
+          msg << "NonBlockingSum::finish() called MPI_Wait() which returned error code " << result;
+          MayDay::Error(msg.str().c_str());
+        }
+    }
+#endif
+  m_pending = false;
+  a_sum = m_sum;
+}
+
+#include "NamespaceFooter.H"
@@ -786,6 +786,14 @@ dotProduct(const LevelData<FArrayBox>& a_1,
   return m_levelOps.dotProduct(a_1, a_2);
 }
 /***/
+Real
+ResistivityOp::
+localDotProduct(const LevelData<FArrayBox>& a_1,
+                const LevelData<FArrayBox>& a_2)
+{
+  return m_levelOps.localDotProduct(a_1, a_2);
+}
+/***/
 void
 ResistivityOp::
 incr( LevelData<FArrayBox>&       a_lhs,
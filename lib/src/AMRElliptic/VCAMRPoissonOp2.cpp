@@ -22,6 +22,7 @@
 #include "AMRPoissonOpF_F.H"
 
 #include "VCAMRPoissonOp2.H"
+#include "MGAgglomeration.H"
 #include "VCAMRPoissonOpF_F.H"
 #include "DebugOut.H"
 
@@ -208,11 +209,14 @@ void VCAMRPoissonOp2::restrictResidual(LevelData<FArrayBox>&       a_resCoarse,
 
   a_phiFine.exchange(a_phiFine.interval(), m_exchangeCopier);
 
+  // an agglomerated coarser level gets the residual through a buffer
+  LevelData<FArrayBox>& resCoarse = restrictionTarget(a_resCoarse);
+
   for (DataIterator dit = a_phiFine.dataIterator(); dit.ok(); ++dit)
     {
       FArrayBox&       phi = a_phiFine[dit];
       const FArrayBox& rhs = a_rhsFine[dit];
-      FArrayBox&       res = a_resCoarse[dit];
+      FArrayBox&       res = resCoarse[dit];
 
       const FArrayBox& thisACoef = (*m_aCoef)[dit];
       const FluxBox&   thisBCoef = (*m_bCoef)[dit];
@@ -253,6 +257,8 @@ void VCAMRPoissonOp2::restrictResidual(LevelData<FArrayBox>&       a_resCoarse,
                            CHF_BOX_SHIFT(region, iv),
                            CHF_CONST_REAL(m_dx));
     }
+
+  gatherRestricted(a_resCoarse);
 }
 
 void VCAMRPoissonOp2::setAlphaAndBeta(const Real& a_alpha,
@@ -312,8 +318,9 @@ void VCAMRPoissonOp2::resetLambda()
       lambdaFab.invert(1.0);
     }
 
-    // Lambda is reset.
+    // Lambda is reset, and so is the Chebyshev eigenvalue estimate.
     m_lambdaNeedsResetting = false;
+    m_chebyshev.reset();
   }
 }
 
@@ -784,6 +791,32 @@ void VCAMRPoissonOp2::levelJacobi(LevelData<FArrayBox>&       a_phi,
   incr(a_phi, resid, 0.5);
 }
 
+void VCAMRPoissonOp2::levelChebyshev(LevelData<FArrayBox>&       a_phi,
+                                    const LevelData<FArrayBox>& a_rhs,
+                                    int                         a_degree)
+{
+  CH_TIME("VCAMRPoissonOp2::levelChebyshev");
+
+  // Recompute the relaxation coefficient (and forget the eigenvalue
+  // estimate) if needed.
+  resetLambda();
+
+  m_chebyshev.relax(*this, a_phi, a_rhs, a_degree);
+}
+
+void VCAMRPoissonOp2::divideByDiagonal(LevelData<FArrayBox>& a_lhs)
+{
+  CH_TIME("VCAMRPoissonOp2::divideByDiagonal");
+
+  resetLambda();
+
+  DataIterator dit = m_lambda.dataIterator();
+  for (dit.begin(); dit.ok(); ++dit)
+  {
+    a_lhs[dit].mult(m_lambda[dit], m_lambda[dit].box(), 0, 0, a_lhs.nComp());
+  }
+}
+
 void VCAMRPoissonOp2::getFlux(FArrayBox&       a_flux,
                              const FArrayBox& a_data,
                              const FluxBox&   a_bCoef,
@@ -903,6 +936,9 @@ void VCAMRPoissonOp2Factory::define(const ProblemDomain&
   m_cfregion.resize(a_grids.size());
   m_cfregion[0].define(a_grids[0], m_domains[0]);
 
+  m_agglomeratedGrids.resize(0);
+  m_agglomeratedGrids.resize(a_grids.size());
+
   for (int i = 1; i < a_grids.size(); i++)
     {
       m_dx[i] = m_dx[i-1] / m_refRatios[i-1];
@@ -1004,12 +1040,19 @@ MGLevelOp<LevelData<FArrayBox> >* VCAMRPoissonOp2Factory::MGnewOp(const ProblemD
   dx *= coarsening;
 
   DisjointBoxLayout layout;
-  coarsen_dbl(layout, m_boxes[ref], coarsening);
+  bool agglomerated = mgCoarsen(layout, m_boxes[ref], a_depth, m_agglomeratedGrids[ref]);
 
   Copier ex = m_exchangeCopiers[ref];
   CFRegion cfregion = m_cfregion[ref];
 
-  if (coarsening > 1)
+  if (agglomerated)
+  {
+    // the boxes moved, so the coarsened copiers do not apply
+    ex.exchangeDefine(layout, IntVect::Unit);
+    ex.trimEdges(layout, IntVect::Unit);
+    cfregion.define(layout, domain);
+  }
+  else if (coarsening > 1)
   {
     ex.coarsen(coarsening);
     cfregion.coarsen(coarsening);
@@ -1019,6 +1062,13 @@ MGLevelOp<LevelData<FArrayBox> >* VCAMRPoissonOp2Factory::MGnewOp(const ProblemD
 
   newOp->define(layout, dx, domain, m_bc, ex, cfregion);
 
+  if (!agglomerated && mgAgglomerationDepth(m_boxes[ref]) == a_depth+1)
+  {
+    DisjointBoxLayout coarser;
+    mgCoarsen(coarser, m_boxes[ref], a_depth+1, m_agglomeratedGrids[ref]);
+    newOp->setAgglomeratedMGrids(layout, coarser);
+  }
+
   newOp->m_alpha = m_alpha;
   newOp->m_beta  = m_beta;
 
@@ -1030,17 +1080,28 @@ MGLevelOp<LevelData<FArrayBox> >* VCAMRPoissonOp2Factory::MGnewOp(const ProblemD
     }
   else
     {
-      // need to coarsen coefficients
+      // need to coarsen coefficients; CoarseAverageFace can only copy
+      // faces without ghost cells onto a coarsening of the fine layout,
+      // so an agglomerated level gets them through the coarsened layout
+      DisjointBoxLayout coarsened;
+      if (agglomerated)
+        {
+          coarsen_dbl(coarsened, m_boxes[ref], coarsening);
+        }
+      else
+        {
+          coarsened = layout;
+        }
       RefCountedPtr<LevelData<FArrayBox> > aCoef( new LevelData<FArrayBox> );
       RefCountedPtr<LevelData<FluxBox> > bCoef( new LevelData<FluxBox> );
-      aCoef->define(layout, m_aCoef[ref]->nComp(), m_aCoef[ref]->ghostVect());
-      bCoef->define(layout, m_bCoef[ref]->nComp(), m_bCoef[ref]->ghostVect());
+      aCoef->define(coarsened, m_aCoef[ref]->nComp(), m_aCoef[ref]->ghostVect());
+      bCoef->define(coarsened, m_bCoef[ref]->nComp(), m_bCoef[ref]->ghostVect());
 
       // average coefficients to coarser level
       // for now, do this with a CoarseAverage --
       // may want to switch to harmonic averaging at some point
       CoarseAverage averager(m_aCoef[ref]->getBoxes(),
-                             layout, aCoef->nComp(), coarsening);
+                             coarsened, aCoef->nComp(), coarsening);
 
       CoarseAverageFace faceAverager(m_bCoef[ref]->getBoxes(),
                                      bCoef->nComp(), coarsening);
@@ -1060,6 +1121,19 @@ MGLevelOp<LevelData<FArrayBox> >* VCAMRPoissonOp2Factory::MGnewOp(const ProblemD
           MayDay::Abort("VCAMRPoissonOp2Factory::MGNewOp -- bad averagetype");
         }
 
+      if (agglomerated)
+        {
+          // the same boxes, on the agglomerated processors
+          RefCountedPtr<LevelData<FArrayBox> > aAgglomerated( new LevelData<FArrayBox> );
+          RefCountedPtr<LevelData<FluxBox> > bAgglomerated( new LevelData<FluxBox> );
+          aAgglomerated->define(layout, aCoef->nComp(), aCoef->ghostVect());
+          bAgglomerated->define(layout, bCoef->nComp(), bCoef->ghostVect());
+          aCoef->copyTo(*aAgglomerated);
+          bCoef->copyTo(*bAgglomerated);
+          aCoef = aAgglomerated;
+          bCoef = bAgglomerated;
+        }
+
       newOp->m_aCoef = aCoef;
       newOp->m_bCoef = bCoef;
     }
@@ -1167,6 +1241,13 @@ AMRLevelOp<LevelData<FArrayBox> >* VCAMRPoissonOp2Factory::AMRnewOp(const Proble
 
   newOp->m_dxCrse = dxCrse;
 
+  if (mgAgglomerationDepth(m_boxes[ref]) == 1)
+  {
+    DisjointBoxLayout coarser;
+    mgCoarsen(coarser, m_boxes[ref], 1, m_agglomeratedGrids[ref]);
+    newOp->setAgglomeratedMGrids(m_boxes[ref], coarser);
+  }
+
   return (AMRLevelOp<LevelData<FArrayBox> >*)newOp;
 }
 
@@ -9,6 +9,7 @@
 #endif
 
 #include "ViscousTensorOp.H"
+#include "MGAgglomeration.H"
 #include "FORT_PROTO.H"
 #include "ViscousTensorOpF_F.H"
 #include "BoxIterator.H"
@@ -27,6 +28,8 @@
 int ViscousTensorOpFactory::s_coefficientAverageType = 1;
 //int ViscousTensorOp::s_prolongType = piecewiseConstant;
 int ViscousTensorOp::s_prolongType = linearInterp;
+int ViscousTensorOp::s_relaxMode = 0;
+Real ViscousTensorOp::s_chebyshevEigenRatio = 0.15;
 
 void
 vtogetMultiColors(Vector<IntVect>& a_colors)
@@ -92,6 +95,11 @@ createCoarser(LevelData<FArrayBox>&       a_coarse,
 {
   // CH_assert(!ghosted);
   IntVect ghost = a_fine.ghostVect();
+  if (m_agglomeratedMGrids.isClosed())
+    {
+      a_coarse.define(m_agglomeratedMGrids, a_fine.nComp(), ghost);
+      return;
+    }
   DisjointBoxLayout dbl;
   CH_assert(dbl.coarsenable(2));
   coarsen(dbl, a_fine.disjointBoxLayout(), 2); //multigrid, so coarsen by 2
@@ -100,6 +108,32 @@ createCoarser(LevelData<FArrayBox>&       a_coarse,
 /***/
 void
 ViscousTensorOp::
+setAgglomeratedMGrids(const DisjointBoxLayout& a_grids,
+                      const DisjointBoxLayout& a_coarse)
+{
+  CH_TIME("ViscousTensorOp::setAgglomeratedMGrids");
+
+  coarsen(m_coarsenedMGrids, a_grids, 2);
+  m_agglomeratedMGrids = a_coarse;
+  m_gatherCopier.define(m_coarsenedMGrids, m_agglomeratedMGrids);
+  m_scatterCopier.define(m_agglomeratedMGrids, m_coarsenedMGrids);
+  m_agglomerationBuffer.clear();
+}
+/***/
+void
+ViscousTensorOp::
+defineAgglomerationBuffer(const LevelData<FArrayBox>& a_coarse)
+{
+  if (!m_agglomerationBuffer.isDefined() ||
+      m_agglomerationBuffer.nComp() != a_coarse.nComp() ||
+      m_agglomerationBuffer.ghostVect() != a_coarse.ghostVect())
+    {
+      m_agglomerationBuffer.define(m_coarsenedMGrids, a_coarse.nComp(), a_coarse.ghostVect());
+    }
+}
+/***/
+void
+ViscousTensorOp::
 computeOperatorNoBCs(LevelData<FArrayBox>& a_lhs,
                      const LevelData<FArrayBox>& a_phi)
 {
@@ -153,17 +187,34 @@ restrictResidual(LevelData<FArrayBox>&       a_resCoarse,
   homogeneousCFInterp(a_phiFine);
   //bcs and exchange done within applyOp
   residual(resFine, a_phiFine, a_rhsFine, true);
+
+  // an agglomerated coarser level gets the residual through a buffer
+  LevelData<FArrayBox>* resCoarse = &a_resCoarse;
+  if (m_agglomeratedMGrids.isClosed())
+    {
+      defineAgglomerationBuffer(a_resCoarse);
+      resCoarse = &m_agglomerationBuffer;
+    }
+
   int ncomp = SpaceDim;
   const DisjointBoxLayout dblFine = a_phiFine.disjointBoxLayout();
   for (DataIterator dit = dblFine.dataIterator(); dit.ok(); ++dit)
     {
       Box region = dblFine.get(dit());
-      a_resCoarse[dit()].setVal(0.0);
-      FORT_RESTRICTRESVTOP(CHF_FRA(a_resCoarse[dit()]),
+      (*resCoarse)[dit()].setVal(0.0);
+      FORT_RESTRICTRESVTOP(CHF_FRA((*resCoarse)[dit()]),
                            CHF_CONST_FRA(resFine[dit()]),
                            CHF_BOX(region),
                            CHF_CONST_INT(ncomp));
     }
+
+  if (m_agglomeratedMGrids.isClosed())
+    {
+      CH_TIME("gather");
+      m_agglomerationBuffer.copyTo(m_agglomerationBuffer.interval(),
+                                   a_resCoarse, a_resCoarse.interval(),
+                                   m_gatherCopier);
+    }
 }
 /***/
 void
@@ -174,6 +225,20 @@ prolongIncrement(LevelData<FArrayBox>&       a_phiThisLevel,
   DisjointBoxLayout dbl = a_phiThisLevel.disjointBoxLayout();
   int mgref = 2; //this is a multigrid func
 
+  // need to cast away const-ness in order to set ghost cells
+  LevelData<FArrayBox>* correctCoarse = const_cast<LevelData<FArrayBox>*>(&a_correctCoarse);
+
+  // scatter the correction of an agglomerated coarser level
+  if (m_agglomeratedMGrids.isClosed())
+    {
+      CH_TIME("scatter");
+      defineAgglomerationBuffer(a_correctCoarse);
+      a_correctCoarse.copyTo(a_correctCoarse.interval(),
+                             m_agglomerationBuffer, m_agglomerationBuffer.interval(),
+                             m_scatterCopier);
+      correctCoarse = &m_agglomerationBuffer;
+    }
+
   if (s_prolongType > piecewiseConstant)
     {
       // need to set ghost cells for interpolation
@@ -182,12 +247,10 @@ prolongIncrement(LevelData<FArrayBox>&       a_phiThisLevel,
 
       // as a first cut, do linear extrapolation everywhere,
       // followed by an exchange
-      const DisjointBoxLayout& crseGrids = a_correctCoarse.getBoxes();
-
-      // need to cast away const-ness in order to make this happen
-      LevelData<FArrayBox>& crseCorr = *(const_cast<LevelData<FArrayBox>*>(&a_correctCoarse));
+      LevelData<FArrayBox>& crseCorr = *correctCoarse;
+      const DisjointBoxLayout& crseGrids = crseCorr.getBoxes();
 
-      DataIterator crseDit = a_correctCoarse.dataIterator();
+      DataIterator crseDit = crseCorr.dataIterator();
       for (crseDit.begin(); crseDit.ok(); ++crseDit)
         {
 
@@ -219,7 +282,7 @@ prolongIncrement(LevelData<FArrayBox>&       a_phiThisLevel,
   for (DataIterator dit = a_phiThisLevel.dataIterator(); dit.ok(); ++dit)
     {
       FArrayBox& phi =  a_phiThisLevel[dit];
-      const FArrayBox& coarse = a_correctCoarse[dit];
+      const FArrayBox& coarse = (*correctCoarse)[dit];
       Box region = dbl.get(dit());
       Box cBox = coarsen(region, mgref);
 
@@ -308,7 +371,8 @@ AMRResidualNF(LevelData<FArrayBox>&       a_residual,
               bool a_homogeneousPhysBC)
 {
   this->cfinterp(a_phi, a_phiCoarse);
-  this->residual(a_residual, a_phi, a_rhs, a_homogeneousPhysBC ); //apply boundary conditions
+  //apply boundary conditions, keeping the coarse-fine values just set
+  this->residualI(a_residual, a_phi, a_rhs, a_homogeneousPhysBC );
 }
 
 /***/
@@ -940,6 +1004,20 @@ residual(LevelData<FArrayBox>&       a_lhs,
          const LevelData<FArrayBox>& a_phi,
          const LevelData<FArrayBox>& a_rhs,
          bool a_homogeneous)
+{
+  if (a_homogeneous)
+    {
+      homogeneousCFInterp((LevelData<FArrayBox>&)a_phi);
+    }
+  residualI(a_lhs, a_phi, a_rhs, a_homogeneous);
+}
+/***/
+void
+ViscousTensorOp::
+residualI(LevelData<FArrayBox>&       a_lhs,
+          const LevelData<FArrayBox>& a_phi,
+          const LevelData<FArrayBox>& a_rhs,
+          bool a_homogeneous)
 {
   applyOp(a_lhs, a_phi, a_homogeneous);
   incr(a_lhs, a_rhs, -1);
@@ -1007,6 +1085,14 @@ dotProduct(const LevelData<FArrayBox>& a_1,
   return m_levelOps.dotProduct(a_1, a_2);
 }
 /***/
+Real
+ViscousTensorOp::
+localDotProduct(const LevelData<FArrayBox>& a_1,
+                const LevelData<FArrayBox>& a_2)
+{
+  return m_levelOps.localDotProduct(a_1, a_2);
+}
+/***/
 void
 ViscousTensorOp::
 incr( LevelData<FArrayBox>&       a_lhs,
@@ -1036,6 +1122,19 @@ scale(LevelData<FArrayBox>& a_lhs,
 /***/
 void
 ViscousTensorOp::
+divideByDiagonal(LevelData<FArrayBox>& a_lhs)
+{
+  // m_relaxCoef is m_safety over the diagonal
+  for (DataIterator dit = a_lhs.dataIterator(); dit.ok(); ++dit)
+    {
+      const FArrayBox& relaxCoef = m_relaxCoef[dit()];
+      a_lhs[dit()].mult(relaxCoef, relaxCoef.box(), 0, 0, a_lhs.nComp());
+    }
+  m_levelOps.scale(a_lhs, 1.0/m_safety);
+}
+/***/
+void
+ViscousTensorOp::
 setToZero(LevelData<FArrayBox>& a_lhs)
 {
   m_levelOps.setToZero(a_lhs);
@@ -1055,6 +1154,13 @@ relax(LevelData<FArrayBox>&       a_phi,
   CH_assert(a_phi.ghostVect() >= IntVect::Unit);
   CH_assert(a_phi.nComp() == a_rhs.nComp());
 
+  if (s_relaxMode == 1)
+    {
+      // one polynomial with a_iterations operator applies
+      m_chebyshev.relax(*this, a_phi, a_rhs, a_iterations, s_chebyshevEigenRatio);
+      return;
+    }
+
 #define HUGE_NORM 1.0e+20
 #define TINY_NORM 1.0e-20
   LevelData<FArrayBox> lphi;
@@ -1281,6 +1387,7 @@ void
 ViscousTensorOp::
 defineRelCoef()
 {
+  m_chebyshev.reset();
 
   DisjointBoxLayout grids = m_relaxCoef.disjointBoxLayout();
   for (DataIterator dit(grids); dit.ok(); ++dit)
@@ -1396,6 +1503,8 @@ define(const Vector<DisjointBoxLayout>&                     a_grids,
   m_relaxMinIter = a_relaxMinIter;
   m_domains[0] = a_coarseDomain;
   m_dx[0] = a_coarseDx;
+  m_agglomeratedGrids.resize(0);
+  m_agglomeratedGrids.resize(a_grids.size());
   for (int i=1; i<a_grids.size(); i++)
     {
       m_dx[i] = m_dx[i-1]/m_refRatios[i-1] ;
@@ -1426,22 +1535,21 @@ MGnewOp(const ProblemDomain& a_indexSpace,
       MayDay::Error("Domain not found in AMR hierarchy");
     }
 
-  DisjointBoxLayout layout(m_boxes[ref]);
   ProblemDomain domain(m_domains[ref]);
   Real dx = m_dx[ref];
 
   int refToDepth = 1;
   for (int i=0; i< a_depth; i++)
     {
-      if (!layout.coarsenable(4)) return NULL;
-      DisjointBoxLayout dbl;
-      coarsen_dbl(dbl, layout, 2);
-      layout = dbl;
+      if (!m_boxes[ref].coarsenable(4*refToDepth)) return NULL;
       dx*=2;
       refToDepth *= 2;
       domain.coarsen(2);
     }
-  
+
+  DisjointBoxLayout layout;
+  bool agglomerated = mgCoarsen(layout, m_boxes[ref], a_depth, m_agglomeratedGrids[ref]);
+
   RefCountedPtr<LevelData<FluxBox> >     eta;
   RefCountedPtr<LevelData<FluxBox> >  lambda;
   RefCountedPtr<LevelData<FArrayBox> > acoef;
@@ -1456,12 +1564,37 @@ MGnewOp(const ProblemDomain& a_indexSpace,
     }
   else
     {
-      // allocated (coarsened) storage and do coarsening
-      RefCountedPtr<LevelData<FluxBox> >     etaNew( new LevelData<FluxBox>  (layout, 1, IntVect::Zero) );
-      RefCountedPtr<LevelData<FluxBox> >  lambdaNew( new LevelData<FluxBox>  (layout, 1, IntVect::Zero) );
-      RefCountedPtr<LevelData<FArrayBox> > acoefNew( new LevelData<FArrayBox>(layout, 1, IntVect::Zero) );
+      // allocated (coarsened) storage and do coarsening; CoarseAverageFace
+      // can only copy faces without ghost cells onto a coarsening of the
+      // fine layout, so an agglomerated level gets them through one
+      DisjointBoxLayout coarsened;
+      if (agglomerated)
+        {
+          coarsen_dbl(coarsened, m_boxes[ref], refToDepth);
+        }
+      else
+        {
+          coarsened = layout;
+        }
+      RefCountedPtr<LevelData<FluxBox> >     etaNew( new LevelData<FluxBox>  (coarsened, 1, IntVect::Zero) );
+      RefCountedPtr<LevelData<FluxBox> >  lambdaNew( new LevelData<FluxBox>  (coarsened, 1, IntVect::Zero) );
+      RefCountedPtr<LevelData<FArrayBox> > acoefNew( new LevelData<FArrayBox>(coarsened, 1, IntVect::Zero) );
       coarsenStuff(*etaNew, *lambdaNew,  *acoefNew, *m_eta[ref], *m_lambda[ref],  *m_acoef[ref], refToDepth, s_coefficientAverageType);
 
+      if (agglomerated)
+        {
+          // the same boxes, on the agglomerated processors
+          RefCountedPtr<LevelData<FluxBox> >     etaAgg( new LevelData<FluxBox>  (layout, 1, IntVect::Zero) );
+          RefCountedPtr<LevelData<FluxBox> >  lambdaAgg( new LevelData<FluxBox>  (layout, 1, IntVect::Zero) );
+          RefCountedPtr<LevelData<FArrayBox> > acoefAgg( new LevelData<FArrayBox>(layout, 1, IntVect::Zero) );
+          etaNew->copyTo(*etaAgg);
+          lambdaNew->copyTo(*lambdaAgg);
+          acoefNew->copyTo(*acoefAgg);
+          etaNew = etaAgg;
+          lambdaNew = lambdaAgg;
+          acoefNew = acoefAgg;
+        }
+
       eta = etaNew;
       lambda = lambdaNew;
       acoef = acoefNew;
@@ -1477,6 +1610,13 @@ MGnewOp(const ProblemDomain& a_indexSpace,
                                                eta, lambda, acoef, m_alpha, m_beta, -1, -1,
                                                domain,  dx, dxCrse, m_bc, m_safety, m_relaxTolerance, m_relaxMinIter);
 
+  if (!agglomerated && mgAgglomerationDepth(m_boxes[ref]) == a_depth+1)
+    {
+      DisjointBoxLayout coarser;
+      mgCoarsen(coarser, m_boxes[ref], a_depth+1, m_agglomeratedGrids[ref]);
+      newOp->setAgglomeratedMGrids(layout, coarser);
+    }
+
   return newOp;
 }
 void
@@ -1595,6 +1735,13 @@ AMRnewOp(const ProblemDomain& a_indexSpace)
                                                m_domains[ref],  m_dx[ref],
                                                dxCrse, m_bc, m_safety, m_relaxTolerance, m_relaxMinIter);
 
+  if (mgAgglomerationDepth(m_boxes[ref]) == 1)
+    {
+      DisjointBoxLayout coarser;
+      mgCoarsen(coarser, m_boxes[ref], 1, m_agglomeratedGrids[ref]);
+      newOp->setAgglomeratedMGrids(m_boxes[ref], coarser);
+    }
+
   return newOp;
 }
 /***/
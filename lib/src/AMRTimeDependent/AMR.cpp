@@ -13,6 +13,8 @@
 #include <cmath>
 #include <cstdio>
 #include <string>
+#include <vector>
+#include <algorithm>
 
 #ifndef CH_DISABLE_SIGNALS
 #include <signal.h>  // For handling Ctrl-C.
@@ -23,6 +25,7 @@
 #include "Tuple.H"
 #include "BoxIterator.H"
 #include "AMR.H"
+#include "LoadBalance.H"
 #include "CH_Timer.H"
 #include "NamespaceHeader.H"
 
@@ -71,6 +74,7 @@ void AMR::setDefaultValues()
   m_checkpoint_interval= -1;
   m_plot_interval=-1;
   m_checkForSteadyState = false;
+  m_incrementalRegrid = false;
   m_plot_period=-1.0;
   m_next_plot_time=-1.0;
   m_max_grid_size= 0;
@@ -92,6 +96,7 @@ void AMR::setDefaultValues()
   m_fixedDt = -1;
   m_blockFactor = 4;
   m_scheduler = RefCountedPtr<Scheduler>();
+  m_taskGraph = RefCountedPtr<TaskGraph>();
 }
 //-----------------------------------------------------------------------
 
@@ -175,6 +180,15 @@ void AMR::gridBufferSize(int a_grid_buffer_size)
 }
 //-----------------------------------------------------------------------
 
+//-----------------------------------------------------------------------
+void AMR::loadBalanceMethod(int a_method)
+{
+  CH_TIME("AMR::loadBalanceMethod");
+
+  setLoadBalanceMethod(a_method);
+}
+//-----------------------------------------------------------------------
+
 //-----------------------------------------------------------------------
 int AMR::maxGridSize() const
 {
@@ -265,6 +279,69 @@ void AMR::checkForSteadyState(bool a_checkForSteadyState)
 }
 //-----------------------------------------------------------------------
 
+//-----------------------------------------------------------------------
+void AMR::incrementalRegrid(bool a_incrementalRegrid)
+{
+  m_incrementalRegrid = a_incrementalRegrid;
+}
+//-----------------------------------------------------------------------
+
+//-----------------------------------------------------------------------
+void AMR::asyncOutput(int a_maxPending)
+{
+#ifdef CH_USE_HDF5
+  if (a_maxPending <= 0)
+    {
+      if (!m_asyncWriter.isNull())
+        {
+          m_asyncWriter->wait();
+        }
+      m_asyncWriter = RefCountedPtr<AsyncHDF5Writer>();
+    }
+  else if (numProc() > 1)
+    {
+      MayDay::Warning("AMR::asyncOutput: asynchronous output is only supported in serial runs; writing synchronously");
+    }
+  else if (m_asyncWriter.isNull())
+    {
+      m_asyncWriter = RefCountedPtr<AsyncHDF5Writer>(new AsyncHDF5Writer(a_maxPending));
+    }
+  else
+    {
+      m_asyncWriter->setMaxPending(a_maxPending);
+    }
+#endif
+}
+//-----------------------------------------------------------------------
+
+//-----------------------------------------------------------------------
+void AMR::useTaskGraph(int a_numThreads)
+{
+  if (!m_taskGraph.isNull())
+    {
+      finishTasks();
+    }
+  if (a_numThreads <= 0)
+    {
+      m_taskGraph = RefCountedPtr<TaskGraph>();
+    }
+  else
+    {
+      m_taskGraph = RefCountedPtr<TaskGraph>(new TaskGraph(a_numThreads));
+    }
+}
+//-----------------------------------------------------------------------
+
+//-----------------------------------------------------------------------
+void AMR::finishTasks()
+{
+  CH_TIME("AMR::finishTasks");
+  m_taskGraph->waitAll();
+  m_advanceTask = Vector<int>(m_max_level+1, -1);
+  m_lastTask = Vector<int>(m_max_level+1, -1);
+}
+//-----------------------------------------------------------------------
+
 //-----------------------------------------------------------------------
 void AMR::plotPeriod(Real a_plot_period)
 {
@@ -723,6 +800,13 @@ void AMR::conclude() const
       writeCheckpointFile();
     }
 
+#ifdef CH_USE_HDF5
+  if (!m_asyncWriter.isNull())
+    {
+      m_asyncWriter->wait();
+    }
+#endif
+
   // Call any scheduled functions. This is placed after plotting and
   // checkpointing so that the plotting functions can congeal plot files.
   if (!m_scheduler.isNull())
@@ -832,7 +916,15 @@ void AMR::run(Real a_max_time, int a_max_step)
       // Call any scheduled functions. This is placed here so that
       // the plotter function can assume plot files have already been dumped.
       if (!m_scheduler.isNull())
-        m_scheduler->execute(m_cur_step, m_cur_time);
+        {
+#ifdef CH_USE_HDF5
+          if (!m_asyncWriter.isNull())
+            {
+              m_asyncWriter->wait();
+            }
+#endif
+          m_scheduler->execute(m_cur_step, m_cur_time);
+        }
 
       int level = 0;
       int stepsLeft = 0;
@@ -1035,6 +1127,14 @@ int AMR::timeStep(int a_level, int a_stepsLeft, bool a_coarseTimeBoundary)
 
   if (m_useSubcycling)
     {
+      // with a task graph, the work of the levels is added to it here and
+      // done by its threads; what is read here is waited for
+      const bool useTasks = !m_taskGraph.isNull();
+      if (useTasks && a_level == 0)
+        {
+          finishTasks();
+        }
+
       if (a_level < m_max_level)
         {
           CH_TIME("AMR::timeStep::regrid");
@@ -1051,6 +1151,10 @@ int AMR::timeStep(int a_level, int a_stepsLeft, bool a_coarseTimeBoundary)
                   pout() << "yes" << endl;
                 }
 
+              if (useTasks)
+                {
+                  finishTasks();
+                }
               regrid(a_level);
             }
           else
@@ -1072,6 +1176,15 @@ int AMR::timeStep(int a_level, int a_stepsLeft, bool a_coarseTimeBoundary)
         {
           CH_TIME("AMR::timeStep::subcycle");
 
+          if (useTasks)
+            {
+              // the dt's of this and the finer levels are read and changed
+              for (int i = a_level; i <= m_max_level; i++)
+                {
+                  m_taskGraph->wait(m_lastTask[i]);
+                }
+            }
+
           // The factor by which the current time step at the current level
           // has been divided (so far) for subcycling.
           int maxFactor = m_reduction_factor[a_level];
@@ -1133,23 +1246,50 @@ int AMR::timeStep(int a_level, int a_stepsLeft, bool a_coarseTimeBoundary)
         }
 
 
-      {
-        // advance this level
-        CH_TIME("AMR::timeStep::advance");
-        m_amrlevels[a_level]->advance();
-      }
+      if (useTasks)
+        {
+          // after the previous substep of this level and the advance of
+          // the next coarser one
+          Vector<int> after(1, m_lastTask[a_level]);
+          if (a_level > 0)
+            {
+              after.push_back(m_advanceTask[a_level-1]);
+            }
+          AMRLevel* level = m_amrlevels[a_level];
+          m_advanceTask[a_level] = level->addAdvanceTasks(*m_taskGraph, after);
+
+          // Save the current dt and the new (max) dt.
+          const int lev = a_level;
+          m_lastTask[a_level] =
+            m_taskGraph->addTask([this, level, lev]
+                                 {
+                                   CH_TIME("AMR::timeStep::newDt");
+                                   Real dt_level = level->computeDt();
+                                   m_dt_cur[lev] = level->dt();
+                                   m_dt_new[lev] = dt_level;
+                                 },
+                                 Vector<int>(1, m_advanceTask[a_level]), true);
+        }
+      else
+        {
+          {
+            // advance this level
+            CH_TIME("AMR::timeStep::advance");
+            m_amrlevels[a_level]->advance();
+          }
 
-      Real dt_level;
+          Real dt_level;
 
-      {
-        // get the new dt
-        CH_TIME("AMR::timeStep::newDt");
-        dt_level = m_amrlevels[a_level]->computeDt();
-      }
+          {
+            // get the new dt
+            CH_TIME("AMR::timeStep::newDt");
+            dt_level = m_amrlevels[a_level]->computeDt();
+          }
 
-      // Save the current dt and the new (max) dt.
-      m_dt_cur[a_level] = m_amrlevels[a_level]->dt();
-      m_dt_new[a_level] = dt_level;
+          // Save the current dt and the new (max) dt.
+          m_dt_cur[a_level] = m_amrlevels[a_level]->dt();
+          m_dt_new[a_level] = dt_level;
+        }
 
       // increment counter that gives the number of cells updates.
       long long numPts = 0;
@@ -1195,10 +1335,26 @@ int AMR::timeStep(int a_level, int a_stepsLeft, bool a_coarseTimeBoundary)
             }
         }
 
-      {
-        CH_TIME("AMR::timeStep::postTimeStep");
-        m_amrlevels[a_level]->postTimeStep();
-      }
+      if (useTasks)
+        {
+          // after the substeps of the next finer level
+          Vector<int> after(1, m_lastTask[a_level]);
+          if (a_level < m_finest_level)
+            {
+              after.push_back(m_lastTask[a_level+1]);
+            }
+          m_lastTask[a_level] =
+            m_amrlevels[a_level]->addPostTimeStepTasks(*m_taskGraph, after);
+          if (a_level == 0)
+            {
+              finishTasks();
+            }
+        }
+      else
+        {
+          CH_TIME("AMR::timeStep::postTimeStep");
+          m_amrlevels[a_level]->postTimeStep();
+        }
 
     }
   else
@@ -1447,14 +1603,51 @@ void AMR::regrid(int a_base_level)
       m_amrlevels[level]->preRegrid(a_base_level, new_grids);
     }
 
+  // levels whose boxes, coarser levels and finer level are all as they
+  // were keep their data and everything built on it
+  Vector<int> unchanged(m_max_level+1, 0);
+  if (m_incrementalRegrid)
+    {
+      bool coarserUnchanged = true;
+      for (int level = a_base_level + 1; level <= m_max_level; ++level)
+        {
+          std::vector<Box> oldBoxes;
+          if (level <= m_finest_level_old)
+            {
+              oldBoxes = m_amrlevels[level]->boxes().stdVector();
+            }
+          std::vector<Box> newBoxes;
+          if (level <= m_finest_level)
+            {
+              newBoxes = new_grids[level].stdVector();
+            }
+          std::sort(oldBoxes.begin(), oldBoxes.end());
+          std::sort(newBoxes.begin(), newBoxes.end());
+          const bool sameBoxes = (oldBoxes == newBoxes);
+          const bool sameFiner = ((level < m_finest_level_old) == (level < m_finest_level));
+          unchanged[level] = coarserUnchanged && sameBoxes && sameFiner;
+          coarserUnchanged = coarserUnchanged && sameBoxes;
+          if (unchanged[level] && m_verbosity >= 2 && level <= m_finest_level)
+            {
+              pout() << "AMR::regrid: level " << level << " unchanged" << endl;
+            }
+        }
+    }
+
   for (int level = a_base_level + 1; level <= m_finest_level; ++level)
     {
-      m_amrlevels[level]->regrid(new_grids[level]);
+      if (!unchanged[level])
+        {
+          m_amrlevels[level]->regrid(new_grids[level]);
+        }
     }
 
   for (int level = m_finest_level + 1; level <= m_max_level; ++level)
     {
-      m_amrlevels[level]->regrid(Vector<Box>());
+      if (!unchanged[level])
+        {
+          m_amrlevels[level]->regrid(Vector<Box>());
+        }
     }
 
   // now that the new hierarchy is defined, do post-regridding ops
@@ -1765,7 +1958,19 @@ void AMR::writePlotFile() const
       pout() << "plot file name = " << iter_str << endl;
     }
 
-  HDF5Handle handle(iter_str.c_str(), HDF5Handle::CREATE);
+  HDF5Handle handle;
+  if (m_asyncWriter.isNull())
+    {
+      if (handle.open(iter_str.c_str(), HDF5Handle::CREATE) < 0)
+        {
+          MayDay::Error(("Problem opening file " + iter_str).c_str());
+        }
+    }
+  else
+    {
+      m_asyncWriter->open(handle, iter_str);
+    }
+  handle.setCompression(CH_HDF5::plotCompression());
 
   // write amr data
   HDF5HeaderData header;
@@ -1792,7 +1997,14 @@ void AMR::writePlotFile() const
       m_amrlevels[level]->writePlotLevel(handle);
     }
 
-  handle.close();
+  if (m_asyncWriter.isNull())
+    {
+      handle.close();
+    }
+  else
+    {
+      m_asyncWriter->write(handle);
+    }
 #endif
 
   // Here's an extra hook for doing custom plots. :-P -JNJ
@@ -1831,7 +2043,14 @@ void AMR::writeCheckpointFile() const
   HDF5Handle handle;
   {
     CH_TIME("AMR::writeCheckpointFile.openFile");
-    handle.open(iter_str.c_str(), HDF5Handle::CREATE);
+    if (m_asyncWriter.isNull())
+      {
+        handle.open(iter_str.c_str(), HDF5Handle::CREATE);
+      }
+    else
+      {
+        m_asyncWriter->open(handle, iter_str);
+      }
   }
   // write amr data
   HDF5HeaderData header;
@@ -1878,7 +2097,14 @@ void AMR::writeCheckpointFile() const
 #endif
   {
     CH_TIME("AMR::closeCheckpoint");
-    handle.close();
+    if (m_asyncWriter.isNull())
+      {
+        handle.close();
+      }
+    else
+      {
+        m_asyncWriter->write(handle);
+      }
   }
 #endif
 }
@@ -258,4 +258,20 @@ AMRLevel::conclude(int a_step) const
 }
 //-----------------------------------------------------------------------
 
+//-----------------------------------------------------------------------
+int
+AMRLevel::addAdvanceTasks(TaskGraph& a_graph, const Vector<int>& a_after)
+{
+  return a_graph.addTask([this]{ advance(); }, a_after, true);
+}
+//-----------------------------------------------------------------------
+
+//-----------------------------------------------------------------------
+int
+AMRLevel::addPostTimeStepTasks(TaskGraph& a_graph, const Vector<int>& a_after)
+{
+  return a_graph.addTask([this]{ postTimeStep(); }, a_after, true);
+}
+//-----------------------------------------------------------------------
+
 #include "NamespaceFooter.H"
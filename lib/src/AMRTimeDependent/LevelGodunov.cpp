@@ -15,6 +15,7 @@
 #include "PhysIBC.H"
 #include "LoHiSide.H"
 #include "CH_Timer.H"
+#include "TileIterator.H"
 
 #include "LevelGodunov.H"
 
@@ -26,6 +27,12 @@ LevelGodunov::LevelGodunov()
   m_dx           = 0.0;
   m_refineCoarse = 0;
   m_isDefined    = false;
+
+  m_finerFluxRegister   = NULL;
+  m_coarserFluxRegister = NULL;
+  m_source              = NULL;
+  m_time                = 0.0;
+  m_dt                  = 0.0;
 }
 
 // Destructor - free up storage
@@ -105,6 +112,8 @@ void LevelGodunov::define(const DisjointBoxLayout&    a_thisDisjointBoxLayout,
                         m_artificialViscosity);
       m_patchGodunov[dit()].setCurrentBox(m_grids[dit()]);
     }
+  m_maxWaveSpeed.define(m_grids);
+
   // Set the number of ghost cells appropriately
   if (m_useFourthOrderSlopes || m_normalPredOrder == 2)
     {
@@ -172,17 +181,52 @@ Real LevelGodunov::step(LevelData<FArrayBox>&       a_U,
                         const Real&                 a_time,
                         const Real&                 a_dt)
 {
-  CH_TIMERS("LevelGodunov::step");
+  CH_TIME("LevelGodunov::step");
+
+  stepBegin(a_U,
+            a_finerFluxRegister,
+            a_coarserFluxRegister,
+            a_S,
+            a_UCoarseOld,
+            a_TCoarseOld,
+            a_UCoarseNew,
+            a_TCoarseNew,
+            a_time,
+            a_dt);
 
-  CH_TIMER("LevelGodunov::step::setup"   ,timeSetup);
-  //CH_TIMER("LevelGodunov::step::update"  ,timeUpdate);
-  //CH_TIMER("LevelGodunov::step::reflux"  ,timeReflux);
-  CH_TIMER("LevelGodunov::step::conclude",timeConclude);
+  DataIterator dit = m_grids.dataIterator();
+  int nbox = dit.size();
+#pragma omp parallel for
+  for(int ibox = 0; ibox < nbox; ibox++)
+    {
+      stepBox(dit[ibox]);
+    }
+
+  return stepEnd(a_U);
+}
+
+void LevelGodunov::stepBegin(LevelData<FArrayBox>&       a_U,
+                             LevelFluxRegister&          a_finerFluxRegister,
+                             LevelFluxRegister&          a_coarserFluxRegister,
+                             const LevelData<FArrayBox>& a_S,
+                             const LevelData<FArrayBox>& a_UCoarseOld,
+                             const Real&                 a_TCoarseOld,
+                             const LevelData<FArrayBox>& a_UCoarseNew,
+                             const Real&                 a_TCoarseNew,
+                             const Real&                 a_time,
+                             const Real&                 a_dt)
+{
+  CH_TIME("LevelGodunov::step::setup");
 
   // Make sure everything is defined
   CH_assert(m_isDefined);
 
-  CH_START(timeSetup);
+  // Remember the arguments the box updates need
+  m_finerFluxRegister   = &a_finerFluxRegister;
+  m_coarserFluxRegister = &a_coarserFluxRegister;
+  m_source              = &a_S;
+  m_time                = a_time;
+  m_dt                  = a_dt;
 
   // Clear flux registers with next finer level
   if (m_hasFiner)
@@ -190,29 +234,31 @@ Real LevelGodunov::step(LevelData<FArrayBox>&       a_U,
       a_finerFluxRegister.setToZero();
     }
 
-  // Setup an interval corresponding to the conserved variables
-  Interval UInterval(0,m_numCons-1);
-  DataIterator dit = m_grids.dataIterator();
+  // the copy covers the ghost cells too, so it is split into tiles of
+  // the grown boxes
+  TileIterator tit(m_grids, TileIterator::defaultTileSize(), m_U.ghostVect());
+  int ntile = tit.size();
 
 #pragma omp parallel
   {
     CH_TIME("setup::localU");
-    //    DataIterator dit = m_U.dataIterator();
-    int nbox = dit.size();
 #pragma omp for
-    for(int ibox = 0; ibox < nbox; ibox++)
+    for(int itile = 0; itile < ntile; itile++)
       {
-        const DataIndex & datind = dit[ibox];
-        Box curBox = m_grids[datind];
-        m_U[dit[ibox]].setVal(0.0); // Gets rid of denormalized crap.
-        m_U[dit[ibox]].copy(a_U[dit[ibox]]);
+        const DataIndex& datind = tit.index(itile);
+        FArrayBox& curU = m_U[datind];
+        curU.setVal(0.0, tit[itile], 0, curU.nComp()); // Gets rid of denormalized crap.
+        curU.copy(a_U[datind], tit[itile]);
 
-      } //end data iterator loop
+      } //end tile loop
 
   }//end pragma
-  m_U.exchange(m_exchangeCopier);
-  
-  
+
+  // Start filling m_U's ghost cells from neighboring grids; the coarse-fine
+  // interpolation below touches a disjoint set of ghost cells, so it can
+  // proceed while the exchange messages are in flight
+  m_U.exchangeBegin(m_exchangeCopier);
+
   // Fill m_U's ghost cells using fillInterp
   if (m_hasCoarser)
     {
@@ -254,115 +300,97 @@ Real LevelGodunov::step(LevelData<FArrayBox>&       a_U,
                            0,0,m_numCons);
     }
 
-  // Potentially used in boundary conditions
+  m_U.exchangeEnd();
+}
 
+void LevelGodunov::stepBox(const DataIndex& a_dataIndex)
+{
+  CH_assert(m_isDefined);
+
+  // Setup an interval corresponding to the conserved variables
+  Interval UInterval(0,m_numCons-1);
 
   // Dummy source used if source term passed in is empty
+  FArrayBox zeroSource;
 
-  // Use to restrict maximum wave speed away from zero
-  Real maxWaveSpeed = 1.0e-12;
+  // The current box
+  const Box& curBox = m_grids.get(a_dataIndex);
 
-  CH_STOP(timeSetup);
-  //  return 0;
-  Vector<Real> speeds(m_grids.size(), 0);
-#pragma omp parallel  default (shared)
-  {
-    int nbox = dit.size();
-#pragma omp for 
-    for(int ibox = 0; ibox < nbox; ibox++)
-      {
-        //      CH_START(timeUpdate);
-        FArrayBox zeroSource;
-        //AD: work on this section later
-      // The current box
-      const Box& curBox = m_grids.get(dit[ibox]);
+  // The current grid of conserved variables
+  FArrayBox& curU = m_U[a_dataIndex];
 
-      // The current grid of conserved variables
-      FArrayBox& curU = m_U[dit[ibox]];
+  // The current source terms if they exist
+  const FArrayBox* source = &zeroSource;
+  if (m_source->isDefined())
+    {
+      source = &(*m_source)[a_dataIndex];
+    }
 
-      // The current source terms if they exist
-      const FArrayBox* source = &zeroSource;
-      if (a_S.isDefined())
+  // The fluxes computed for this grid - used for refluxing and returning
+  // other face centered quantities
+  FluxBox flux;
+
+  // Update the current grid's conserved variables, return the final
+  // fluxes used for this, and the maximum wave speed for this grid
+  PatchGodunov& patchGodunov = m_patchGodunov[a_dataIndex];
+  patchGodunov.setCurrentTime(m_time);
+  patchGodunov.updateState(curU,
+                           flux,
+                           m_maxWaveSpeed[a_dataIndex],
+                           *source,
+                           m_dt,
+                           curBox);
+
+  // Do flux register updates
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      // Increment coarse flux register between this level and the next
+      // finer level - this level is the next coarser level with respect
+      // to the next finer level
+      if (m_hasFiner)
         {
-          source = &a_S[dit[ibox]];
+          m_finerFluxRegister->incrementCoarse(flux[idir],m_dt,a_dataIndex,
+                                               UInterval,
+                                               UInterval,idir);
         }
 
-      // The fluxes computed for this grid - used for refluxing and returning
-      // other face centered quantities
-      FluxBox flux;
-
-
-      Real maxWaveSpeedGrid;
-
-      // Update the current grid's conserved variables, return the final
-      // fluxes used for this, and the maximum wave speed for this grid
-      m_patchGodunov[dit[ibox]].setCurrentTime(a_time);
-      m_patchGodunov[dit[ibox]].updateState(curU,
-                                 flux,
-                                 maxWaveSpeedGrid,
-                                 *source,
-                                 a_dt,
-                                 curBox);
-
-      // Clamp away from zero
-           speeds[ibox]=maxWaveSpeedGrid;
-           maxWaveSpeed = Max(maxWaveSpeed,maxWaveSpeedGrid);
-
-      //      CH_STOP(timeUpdate);
-
-      //CH_START(timeReflux);
-
-      // Do flux register updates
-      for (int idir = 0; idir < SpaceDim; idir++)
+      // Increment fine flux registers between this level and the next
+      // coarser level - this level is the next finer level with respect
+      // to the next coarser level
+      if (m_hasCoarser)
         {
-          // Increment coarse flux register between this level and the next
-          // finer level - this level is the next coarser level with respect
-          // to the next finer level
-          if (m_hasFiner)
-            {
-              a_finerFluxRegister.incrementCoarse(flux[idir],a_dt,dit[ibox],
-                                                  UInterval,
-                                                  UInterval,idir);
-            }
-
-          // Increment fine flux registers between this level and the next
-          // coarser level - this level is the next finer level with respect
-          // to the next coarser level
-          if (m_hasCoarser)
-            {
-              a_coarserFluxRegister.incrementFine(flux[idir],a_dt,dit[ibox],
-                                                  UInterval,
-                                                  UInterval,idir);
-            }
+          m_coarserFluxRegister->incrementFine(flux[idir],m_dt,a_dataIndex,
+                                               UInterval,
+                                               UInterval,idir);
         }
-      //CH_STOP(timeReflux);
-      }
-  }
-  for(int ibox = 0; ibox < speeds.size(); ibox++)
-    {
-      maxWaveSpeed = Max(maxWaveSpeed, speeds[ibox]);
     }
-  
-  CH_START(timeConclude);
+}
 
+Real LevelGodunov::stepEnd(LevelData<FArrayBox>& a_U)
+{
+  CH_TIME("LevelGodunov::step::conclude");
+
+  CH_assert(m_isDefined);
+
+  // Now that we have completed the updates of all the patches, we copy the
+  // contents of temporary storage, m_U, into the permanent storage, a_U.
   {
-    //DataIterator dit = m_U.dataIterator();
-    int nbox = dit.size();
-    for(int ibox = 0; ibox < nbox; ibox++)
+    TileIterator tit(m_grids, TileIterator::defaultTileSize(), a_U.ghostVect());
+    int ntile = tit.size();
+#pragma omp parallel for
+    for(int itile = 0; itile < ntile; itile++)
       {
-        a_U[dit[ibox]].copy(m_U[dit[ibox]]);
+        const DataIndex& datind = tit.index(itile);
+        a_U[datind].copy(m_U[datind], tit[itile]);
       }
   }
-  
-  // {
-  //   CH_TIME("conclude::copyU");
-  //   // Now that we have completed the updates of all the patches, we copy the
-  //   // contents of temporary storage, m_U, into the permanent storage, a_U.
-  //   for (DataIterator dit = m_U.dataIterator(); dit.ok(); ++dit)
-  //     {
-  //       a_U[dit].copy(m_U[dit]);
-  //     }
-  // }
+
+  // Use to restrict maximum wave speed away from zero
+  Real maxWaveSpeed = 1.0e-12;
+  for (DataIterator dit = m_grids.dataIterator(); dit.ok(); ++dit)
+    {
+      maxWaveSpeed = Max(maxWaveSpeed, m_maxWaveSpeed[dit]);
+    }
 
   // Find the minimum of dt's over this level
   Real local_dtNew = m_dx / maxWaveSpeed;
@@ -382,8 +410,6 @@ Real LevelGodunov::step(LevelData<FArrayBox>&       a_U,
 #endif
   }
 
-  CH_STOP(timeConclude);
-
   // Return the maximum stable time step
   return dtNew;
 }
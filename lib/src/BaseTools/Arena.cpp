@@ -345,4 +345,235 @@ void* CArena::realloc(void*  a_ptr,
 }
 #endif
 
+//
+// PArena
+//
+
+// smallest size class, and the tag that marks a block as ours
+static const int    s_minClassLog2 = 8;
+static const size_t s_minClassSize = 256;
+static const int    s_parenaMagic  = 0x5041524e;
+
+// Guards the ThreadCache::m_arena pointers and the PArena::m_threadCaches
+// sets, which a thread's exit and an arena's destruction both change.
+static std::mutex s_threadCacheLock;
+
+// the calling thread's caches, one per PArena it has used; when the
+// thread exits, its cached blocks go back to the arenas' shared pools
+struct PArenaThreadCaches
+{
+  std::vector<PArena::ThreadCache*> m_caches;
+
+  ~PArenaThreadCaches();
+};
+
+static thread_local PArenaThreadCaches t_threadCaches;
+// set once t_threadCaches is destroyed: objects with static lifetime can
+// still free blocks after the main thread's thread_locals are gone
+static thread_local bool t_threadCachesGone = false;
+
+PArenaThreadCaches::~PArenaThreadCaches()
+{
+  t_threadCachesGone = true;
+  std::lock_guard<std::mutex> guard(s_threadCacheLock);
+  for (unsigned int i = 0; i < m_caches.size(); i++)
+    {
+      PArena::ThreadCache* cache = m_caches[i];
+      if (cache->m_arena != NULL)
+        {
+          cache->m_arena->drain(*cache);
+          cache->m_arena->m_threadCaches.erase(cache);
+        }
+      delete cache;
+    }
+}
+
+PArena::PArena(const char* a_name, size_t a_maxPooledSize)
+  :m_maxPooledSize(a_maxPooledSize)
+{
+#ifdef CH_USE_MEMORY_TRACKING
+  strncpy(name_, a_name, NSIZE);
+  name_[NSIZE-1]=0;
+#endif
+  m_numClasses = sizeClass(m_maxPooledSize) + 1;
+  m_pool.resize(m_numClasses);
+}
+
+PArena::~PArena()
+{
+  release();
+  // threads still alive delete their caches when they exit
+  std::lock_guard<std::mutex> guard(s_threadCacheLock);
+  for (std::set<ThreadCache*>::iterator it = m_threadCaches.begin();
+       it != m_threadCaches.end(); ++it)
+    {
+      (*it)->m_arena = NULL;
+    }
+  m_threadCaches.clear();
+}
+
+int PArena::sizeClass(size_t a_sz) const
+{
+  if (a_sz > m_maxPooledSize) return -1;
+  if (a_sz <= s_minClassSize) return 0;
+  // 2^e < a_sz <= 2^(e+1), split into four steps of 2^(e-2)
+  int e = s_minClassLog2;
+  size_t p = s_minClassSize;
+  while (2*p < a_sz)
+    {
+      p *= 2;
+      e++;
+    }
+  size_t step = p/4;
+  int s = (a_sz - p + step - 1)/step;
+  return 4*(e - s_minClassLog2) + s;
+}
+
+size_t PArena::classSize(int a_class)
+{
+  if (a_class == 0) return s_minClassSize;
+  int e = s_minClassLog2 + (a_class - 1)/4;
+  int s = (a_class - 1)%4 + 1;
+  size_t p = ((size_t)1) << e;
+  return p + s*(p/4);
+}
+
+PArena::ThreadCache* PArena::threadCache()
+{
+  if (t_threadCachesGone) return NULL;
+  std::vector<ThreadCache*>& caches = t_threadCaches.m_caches;
+  for (unsigned int i = 0; i < caches.size(); i++)
+    {
+      if (caches[i]->m_arena == this) return caches[i];
+    }
+  ThreadCache* cache = new ThreadCache;
+  cache->m_arena = this;
+  cache->m_free.resize(m_numClasses);
+  {
+    std::lock_guard<std::mutex> guard(s_threadCacheLock);
+    m_threadCaches.insert(cache);
+  }
+  caches.push_back(cache);
+  return cache;
+}
+
+void PArena::drain(ThreadCache& a_cache)
+{
+  std::lock_guard<std::mutex> guard(m_lock);
+  for (int c = 0; c < m_numClasses; c++)
+    {
+      std::vector<void*>& cached = a_cache.m_free[c];
+      m_pool[c].insert(m_pool[c].end(), cached.begin(), cached.end());
+      cached.resize(0);
+    }
+}
+
+void* PArena::alloc(size_t a_sz)
+{
+  int c = sizeClass(a_sz);
+  void* block = NULL;
+  if (c >= 0)
+    {
+      ThreadCache* cache = threadCache();
+      if (cache != NULL && cache->m_free[c].size() > 0)
+        {
+          block = cache->m_free[c].back();
+          cache->m_free[c].pop_back();
+        }
+      else
+        {
+          std::lock_guard<std::mutex> guard(m_lock);
+          if (m_pool[c].size() > 0)
+            {
+              block = m_pool[c].back();
+              m_pool[c].pop_back();
+            }
+        }
+    }
+  if (block == NULL)
+    {
+      // a new block; only the header is touched here
+      size_t bytes = (c >= 0 ? classSize(c) : a_sz) + Alignment;
+      if (posix_memalign(&block, Alignment, bytes) != 0)
+        {
+          block = NULL;
+        }
+      if (block == NULL)
+        {
+          print_memory_line("Out of memory");
+          pout() << " Trying to allocate " << bytes << " bytes in PArena::alloc()" << std::endl;
+          MayDay::Error("Out of memory in PArena::alloc");
+        }
+      Header* h  = (Header*)block;
+      h->m_class = c;
+      h->m_magic = s_parenaMagic;
+      h->m_bytes = bytes;
+    }
+  return (char*)block + Alignment;
+}
+
+void PArena::free(void* a_pt)
+{
+  if (a_pt == NULL) return;
+  void* block = (char*)a_pt - Alignment;
+  const Header* h = (const Header*)block;
+  if (h->m_magic != s_parenaMagic)
+    {
+      MayDay::Error("PArena::free: block was not allocated by a PArena");
+    }
+  int c = h->m_class;
+  if (c < 0)
+    {
+      ::free(block);
+      return;
+    }
+  ThreadCache* cache = threadCache();
+  if (cache != NULL && cache->m_free[c].size() < ThreadCacheDepth)
+    {
+      cache->m_free[c].push_back(block);
+      return;
+    }
+  std::lock_guard<std::mutex> guard(m_lock);
+  m_pool[c].push_back(block);
+}
+
+void PArena::release()
+{
+  // the other threads' caches too, so no other thread may be using the arena
+  std::lock_guard<std::mutex> cacheGuard(s_threadCacheLock);
+  for (std::set<ThreadCache*>::iterator it = m_threadCaches.begin();
+       it != m_threadCaches.end(); ++it)
+    {
+      drain(**it);
+    }
+  std::lock_guard<std::mutex> guard(m_lock);
+  for (int c = 0; c < m_numClasses; c++)
+    {
+      for (unsigned int i = 0; i < m_pool[c].size(); i++)
+        {
+          ::free(m_pool[c][i]);
+        }
+      m_pool[c].resize(0);
+    }
+}
+
+size_t PArena::pooledBytes() const
+{
+  PArena& arena = (PArena&)*this;
+  std::lock_guard<std::mutex> cacheGuard(s_threadCacheLock);
+  std::lock_guard<std::mutex> guard(arena.m_lock);
+  size_t bytes = 0;
+  for (int c = 0; c < m_numClasses; c++)
+    {
+      size_t count = m_pool[c].size();
+      for (std::set<ThreadCache*>::const_iterator it = m_threadCaches.begin();
+           it != m_threadCaches.end(); ++it)
+        {
+          count += (*it)->m_free[c].size();
+        }
+      bytes += count*classSize(c);
+    }
+  return bytes;
+}
+
 #include "BaseNamespaceFooter.H"
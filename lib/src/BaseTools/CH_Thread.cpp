@@ -11,16 +11,23 @@
 #include "CH_Thread.H"
 #include "NamespaceHeader.H"
 
+static thread_local bool s_notThread0 = false;
+
 bool onThread0()
 {
-  bool retval = true;
+  bool retval = !s_notThread0;
 #ifdef _OPENMP
   int thread_num = omp_get_thread_num();
-  retval = (thread_num== 0);
+  retval = retval && (thread_num== 0);
 #endif       
   return retval;
 }
 
+void setNotThread0()
+{
+  s_notThread0 = true;
+}
+
 int getMaxThreads()
 {
   int retval = 1;
@@ -31,6 +31,7 @@
 using namespace std;
 
 #include "SPMD.H"
+#include "CH_Thread.H"
 
 #include "BaseNamespaceHeader.H"
 
@@ -907,9 +908,7 @@ void TraceTimer::reportName(std::ostream& out, const char* name)
   
 TraceTimer* TraceTimer::getTimer(const char* name)
 {
-#ifdef _OPENMP
   if(onThread0()){
-#endif
   int thread_id = 0; // this line will change in MThread-aware code.
   TraceTimer* parent = TraceTimer::s_currentTimer[thread_id];
   if (parent->m_pruned) return parent;
@@ -923,10 +922,8 @@ TraceTimer* TraceTimer::getTimer(const char* name)
   TraceTimer* newTimer = new TraceTimer(name, parent, thread_id);
   children.push_back(newTimer);
   return newTimer;
-#ifdef _OPENMP
   }
   return NULL;
-#endif
 }
 
 #ifdef _OPENMP
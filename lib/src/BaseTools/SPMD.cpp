@@ -10,6 +10,7 @@
 
 #include <iostream>
 #include <cstring>
+#include <algorithm>
 // #extern "C" {      // The #extern "C" might have been here for a reason...
 #include <unistd.h>
 // }
@@ -445,4 +446,103 @@ uniqueProc(const SerialTask::task& a_task)
 #endif
 }
 
+
+// processor of the a_aggregator'th piece, spread evenly over all processors
+static int aggregatorRank(int a_aggregator, int a_numAggregators)
+{
+  return (int)(((long long)a_aggregator*numProc())/a_numAggregators);
+}
+
+void gatherPieces(std::vector<char>& a_contiguous, long long& a_lo, long long& a_hi,
+                  const char* a_local, const Vector<long long>& a_offsets,
+                  const Vector<int>& a_procs, long long a_piece, int a_numAggregators,
+                  long long a_start)
+{
+  CH_assert(a_piece > 0);
+  CH_assert(a_numAggregators > 0 && a_numAggregators <= (int)numProc());
+  const int me = procID();
+  const int numBoxes = a_procs.size();
+  const long long total = a_offsets[numBoxes];
+  const long long end = std::min(total, a_start + a_numAggregators*a_piece);
+
+  // the bytes [a_lo, a_hi) this processor gathers, if any
+  a_lo = 0;
+  a_hi = 0;
+  for (int a = 0; a < a_numAggregators; a++)
+    {
+      if (aggregatorRank(a, a_numAggregators) == me)
+        {
+          a_lo = std::min(end, a_start + a*a_piece);
+          a_hi = std::min(end, a_start + (a+1)*a_piece);
+        }
+    }
+  a_contiguous.resize(a_hi - a_lo);
+
+  // where the bytes of this round start in a_local
+  const char* local = a_local;
+  for (int b = 0; b < numBoxes; b++)
+    {
+      if (a_procs[b] == me && a_offsets[b] < a_start)
+        {
+          local += std::min(a_offsets[b+1], a_start) - a_offsets[b];
+        }
+    }
+
+#ifdef CH_MPI
+  const int nproc = numProc();
+
+  // my boxes are one after the other in a_local, in the order of the array,
+  // so what goes to each aggregator is contiguous, and in processor order
+  std::vector<int> sendCounts(nproc, 0), sendDispls(nproc, 0);
+  std::vector<int> recvCounts(nproc, 0), recvDispls(nproc, 0);
+  for (int b = 0; b < numBoxes; b++)
+    {
+      const long long boxLo = std::max(a_offsets[b], a_start);
+      const long long boxHi = std::min(a_offsets[b+1], end);
+      if (a_procs[b] == me)
+        {
+          for (long long from = boxLo; from < boxHi; )
+            {
+              int a = (from - a_start)/a_piece;
+              long long to = std::min(boxHi, a_start + (a+1)*a_piece);
+              sendCounts[aggregatorRank(a, a_numAggregators)] += to - from;
+              from = to;
+            }
+        }
+      long long overlap = std::min(boxHi, a_hi) - std::max(boxLo, a_lo);
+      if (overlap > 0)
+        {
+          recvCounts[a_procs[b]] += overlap;
+        }
+    }
+  for (int p = 1; p < nproc; p++)
+    {
+      sendDispls[p] = sendDispls[p-1] + sendCounts[p-1];
+      recvDispls[p] = recvDispls[p-1] + recvCounts[p-1];
+    }
+
+  std::vector<char> received(a_hi - a_lo + 1);
+  MPI_Alltoallv((void*)local, &(sendCounts[0]), &(sendDispls[0]), MPI_BYTE,
+                &(received[0]), &(recvCounts[0]), &(recvDispls[0]), MPI_BYTE,
+                Chombo_MPI::comm);
+
+  // what a processor sent is the part of its boxes in [a_lo, a_hi), in order
+  std::vector<int> next(recvDispls);
+  for (int b = 0; b < numBoxes; b++)
+    {
+      long long from = std::max(a_offsets[b], a_lo);
+      long long to   = std::min(a_offsets[b+1], a_hi);
+      if (to <= from) continue;
+      int p = a_procs[b];
+      memcpy(&(a_contiguous[from - a_lo]), &(received[next[p]]), to - from);
+      next[p] += to - from;
+    }
+#else
+  if (a_hi > a_lo)
+    {
+      memcpy(&(a_contiguous[0]), local + (a_lo - a_start), a_hi - a_lo);
+    }
+#endif
+}
+
 #include "BaseNamespaceFooter.H"
@@ -76,6 +76,7 @@ WriteAMRHierarchyHDF5(const string& filename,
 #endif
   CH_START(createFile);
   HDF5Handle handle(filename.c_str(),  HDF5Handle::CREATE);
+  handle.setCompression(CH_HDF5::plotCompression());
   CH_STOP(createFile);
 
   CH_START(writeFile);
@@ -127,6 +128,7 @@ WriteAnisotropicAMRHierarchyHDF5(
 
   CH_START(createFile);
   HDF5Handle handle(filename.c_str(),  HDF5Handle::CREATE);
+  handle.setCompression(CH_HDF5::plotCompression());
   CH_STOP(createFile);
 
   CH_START(writeFile);
@@ -283,6 +285,7 @@ WriteAMRHierarchyHDF5(const string& filename,
 {
 
   HDF5Handle handle(filename.c_str(),  HDF5Handle::CREATE);
+  handle.setCompression(CH_HDF5::plotCompression());
   WriteAMRHierarchyHDF5(handle, a_vectGrids, a_vectData,
                         a_domain, a_refRatio, a_numLevels);
 
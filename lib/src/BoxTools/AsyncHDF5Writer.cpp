@@ -0,0 +1,152 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#ifdef CH_USE_HDF5
+
+#include <cstdio>
+#include "AsyncHDF5Writer.H"
+#include "MayDay.H"
+#include "CH_Timer.H"
+#include "NamespaceHeader.H"
+
+AsyncHDF5Writer::AsyncHDF5Writer(int a_maxPending)
+  :m_maxPending(a_maxPending),
+   m_stop(false)
+{
+  CH_assert(m_maxPending > 0);
+}
+
+AsyncHDF5Writer::~AsyncHDF5Writer()
+{
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_changed.wait(lock, [this]{ return m_pending.empty(); });
+    m_stop = true;
+  }
+  m_changed.notify_all();
+  if (m_thread.joinable())
+    {
+      m_thread.join();
+    }
+}
+
+void AsyncHDF5Writer::setMaxPending(int a_maxPending)
+{
+  CH_assert(a_maxPending > 0);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_maxPending = a_maxPending;
+}
+
+void AsyncHDF5Writer::open(HDF5Handle& a_handle, const std::string& a_filename)
+{
+  int err = a_handle.open(a_filename, HDF5Handle::CREATE_IN_MEMORY);
+  if (err < 0)
+    {
+      std::string msg = "AsyncHDF5Writer: could not create in-memory file for " + a_filename;
+      MayDay::Error(msg.c_str());
+    }
+}
+
+void AsyncHDF5Writer::write(HDF5Handle& a_handle)
+{
+  CH_TIME("AsyncHDF5Writer::write");
+  CH_assert(a_handle.openMode() == HDF5Handle::CREATE_IN_MEMORY);
+
+  Snapshot snapshot;
+  snapshot.m_filename = a_handle.getFilename();
+  {
+    CH_TIME("snapshot");
+    int err = a_handle.getFileImage(snapshot.m_image);
+    a_handle.close();
+    if (err != 0)
+      {
+        std::string msg = "AsyncHDF5Writer: could not get the image of " + snapshot.m_filename;
+        MayDay::Error(msg.c_str());
+      }
+  }
+
+  {
+    CH_TIME("waitForSlot");
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_changed.wait(lock, [this]{ return (int)m_pending.size() < m_maxPending; });
+    checkErrors();
+    m_pending.push_back(Snapshot());
+    m_pending.back().m_filename.swap(snapshot.m_filename);
+    m_pending.back().m_image.swap(snapshot.m_image);
+    if (!m_thread.joinable())
+      {
+        m_thread = std::thread(&AsyncHDF5Writer::run, this);
+      }
+  }
+  m_changed.notify_all();
+}
+
+void AsyncHDF5Writer::wait()
+{
+  CH_TIME("AsyncHDF5Writer::wait");
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_changed.wait(lock, [this]{ return m_pending.empty(); });
+  checkErrors();
+}
+
+int AsyncHDF5Writer::numPending()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_pending.size();
+}
+
+void AsyncHDF5Writer::checkErrors()
+{
+  if (m_errors.size() > 0)
+    {
+      std::string msg = "AsyncHDF5Writer: could not write " + m_errors[0];
+      m_errors.clear();
+      MayDay::Error(msg.c_str());
+    }
+}
+
+void AsyncHDF5Writer::run()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true)
+    {
+      m_changed.wait(lock, [this]{ return m_stop || !m_pending.empty(); });
+      if (m_pending.empty())
+        {
+          return;
+        }
+      // the front snapshot is not touched by anyone else until it is popped
+      const Snapshot& snapshot = m_pending.front();
+      lock.unlock();
+
+      std::string partial = snapshot.m_filename + ".partial";
+      bool ok = false;
+      FILE* file = fopen(partial.c_str(), "wb");
+      if (file != NULL)
+        {
+          size_t size = snapshot.m_image.size();
+          ok = (size == 0 || fwrite(&(snapshot.m_image[0]), 1, size, file) == size);
+          ok = (fclose(file) == 0) && ok;
+          ok = ok && (rename(partial.c_str(), snapshot.m_filename.c_str()) == 0);
+        }
+
+      lock.lock();
+      if (!ok)
+        {
+          m_errors.push_back(snapshot.m_filename);
+        }
+      m_pending.pop_front();
+      m_changed.notify_all();
+    }
+}
+
+#include "NamespaceFooter.H"
+
+#endif // CH_USE_HDF5
@@ -209,6 +209,23 @@ BRMeshRefine::makeBoxes(Vector<Box>&         a_mesh,
   for (int i=0; i<a_mesh.size(); ++i, ++it) a_mesh[i]=*it;
 }
 
+void
+BRMeshRefine::makeLocalBoxes(Vector<Box>&         a_mesh,
+                             IntVectSet&          a_tags,
+                             const IntVectSet&    a_pnd,
+                             const ProblemDomain& a_domain,
+                             const int            a_maxBoxSize,
+                             const int            a_totalBufferSize) const
+{
+  CH_TIME("BRMeshRefine::makeLocalBoxes");
+  std::list<Box> boxes;
+  makeBoxes(boxes, a_tags, a_pnd, a_domain, a_maxBoxSize, 0, a_totalBufferSize);
+
+  a_mesh.resize(boxes.size());
+  std::list<Box>::iterator it = boxes.begin();
+  for (int i=0; i<a_mesh.size(); ++i, ++it) a_mesh[i]=*it;
+}
+
 void
 BRMeshRefine::makeBoxes(std::list<Box>&      a_mesh,
                         IntVectSet&    a_tags,
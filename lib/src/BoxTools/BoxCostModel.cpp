@@ -0,0 +1,162 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include "BoxCostModel.H"
+#include "LayoutIterator.H"
+#include "CH_Timer.H"
+#include "SPMD.H"
+#ifdef CH_MPI
+#include "mpi.h"
+#endif
+#include "NamespaceHeader.H"
+
+// old boxes with their cost per cell, ordered by their low end in direction 0
+struct MeasuredBox
+{
+  Box  m_box;
+  Real m_density;
+
+  bool operator<(const MeasuredBox& a_rhs) const
+  {
+    return m_box.smallEnd(0) < a_rhs.m_box.smallEnd(0);
+  }
+};
+
+BoxCostModel::BoxCostModel()
+  :m_isDefined(false)
+{
+}
+
+BoxCostModel::BoxCostModel(const BoxLayout& a_grids)
+  :m_isDefined(false)
+{
+  define(a_grids);
+}
+
+void BoxCostModel::define(const BoxLayout& a_grids)
+{
+  CH_assert(a_grids.isClosed());
+  m_grids = a_grids;
+  m_time.resize(m_grids.size());
+  clearTime();
+  m_isDefined = true;
+}
+
+void BoxCostModel::clearTime()
+{
+  for (int i = 0; i < m_time.size(); i++)
+    {
+      m_time[i] = 0;
+    }
+}
+
+void BoxCostModel::accumulate(const TimedDataIterator& a_dit)
+{
+  CH_assert(m_isDefined);
+  const Vector<unsigned long long>& time = a_dit.getTime();
+  // nothing was timed if timing was never enabled
+  if (time.size() == 0) return;
+  CH_assert(time.size() == m_time.size());
+  for (int i = 0; i < m_time.size(); i++)
+    {
+      m_time[i] += time[i];
+    }
+}
+
+void BoxCostModel::addTime(const DataIndex& a_index, unsigned long long a_ticks)
+{
+  CH_assert(m_isDefined);
+  m_time[a_index.intCode()] += a_ticks;
+}
+
+void BoxCostModel::computeLoads(Vector<long long>& a_loads,
+                                const Vector<Box>& a_boxes) const
+{
+  CH_TIME("BoxCostModel::computeLoads");
+  const int numNew = a_boxes.size();
+  a_loads.resize(numNew);
+
+  Vector<unsigned long long> time(m_time);
+#ifdef CH_MPI
+  if (time.size() > 0)
+    {
+      MPI_Allreduce(&(m_time[0]), &(time[0]), time.size(),
+                    MPI_UNSIGNED_LONG_LONG, MPI_SUM, Chombo_MPI::comm);
+    }
+#endif
+
+  // cost per cell of the boxes that were measured
+  std::vector<MeasuredBox> measured;
+  Real totalTime = 0;
+  Real totalCells = 0;
+  int maxLength = 0;
+  if (m_isDefined)
+    {
+      LayoutIterator lit = m_grids.layoutIterator();
+      for (int i = 0; i < time.size(); i++)
+        {
+          if (time[i] == 0) continue;
+          MeasuredBox mb;
+          mb.m_box = m_grids[lit[i]];
+          mb.m_density = Real(time[i])/Real(mb.m_box.numPts());
+          measured.push_back(mb);
+          totalTime  += Real(time[i]);
+          totalCells += Real(mb.m_box.numPts());
+          maxLength = std::max(maxLength, mb.m_box.size(0));
+        }
+    }
+
+  if (measured.size() == 0)
+    {
+      for (int i = 0; i < numNew; i++)
+        {
+          a_loads[i] = a_boxes[i].numPts();
+        }
+      return;
+    }
+  std::sort(measured.begin(), measured.end());
+  const Real average = totalTime/totalCells;
+
+  Vector<Real> cost(numNew, 0.0);
+  Real maxCost = 0;
+  for (int i = 0; i < numNew; i++)
+    {
+      const Box& b = a_boxes[i];
+      // only old boxes whose low end is within maxLength below b's can overlap it
+      MeasuredBox lo;
+      lo.m_box = Box(IntVect::Zero, IntVect::Zero);
+      lo.m_box.shift(0, b.smallEnd(0) - maxLength + 1);
+      std::vector<MeasuredBox>::const_iterator it =
+        std::lower_bound(measured.begin(), measured.end(), lo);
+      Real covered = 0;
+      for (; it != measured.end() && it->m_box.smallEnd(0) <= b.bigEnd(0); ++it)
+        {
+          Box overlap = b & it->m_box;
+          if (overlap.isEmpty()) continue;
+          Real n = overlap.numPts();
+          cost[i] += n*it->m_density;
+          covered += n;
+        }
+      cost[i] += (Real(b.numPts()) - covered)*average;
+      maxCost = std::max(maxCost, cost[i]);
+    }
+
+  // the largest load is about 10^12, far enough from both the resolution
+  // of long long and its overflow
+  const Real scale = 1.0e12/maxCost;
+  for (int i = 0; i < numNew; i++)
+    {
+      a_loads[i] = std::max((long long)1, (long long)std::floor(cost[i]*scale + 0.5));
+    }
+}
+
+#include "NamespaceFooter.H"
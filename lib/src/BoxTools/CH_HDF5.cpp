@@ -12,7 +12,12 @@
 
 #include "CH_HDF5.H"
 #include "MayDay.H"
+#include "ParmParse.H"
 #include <cstdio>
+#include <cstring>
+#include <climits>
+#include <algorithm>
+#include <chrono>
 #include "parstream.H"
 #include "NamespaceHeader.H"
 using std::ostream;
@@ -254,7 +259,8 @@ int write(HDF5Handle& a_handle, const BoxLayout& a_layout, const std::string& na
   return 0;
 }
 
-int read(HDF5Handle& a_handle, Vector<Box>& boxes, const std::string& name)
+// the box dataset name, read by this processor
+static int readBoxDataset(HDF5Handle& a_handle, Vector<Box>& boxes, const std::string& name)
 {
 #ifdef H516
   hid_t  boxdataset = H5Dopen(a_handle.groupID(), name.c_str());
@@ -292,6 +298,26 @@ int read(HDF5Handle& a_handle, Vector<Box>& boxes, const std::string& name)
   return 0;
 }
 
+int read(HDF5Handle& a_handle, Vector<Box>& boxes, const std::string& name)
+{
+#ifdef CH_MPI
+  // slab reads: processor 0 reads the boxes for everyone
+  if (CH_HDF5::readsSlabs(a_handle))
+    {
+      int err = 0;
+      if (procID() == 0)
+        {
+          err = readBoxDataset(a_handle, boxes, name);
+        }
+      broadcast(err, 0);
+      if (err < 0) return err;
+      broadcast(boxes, 0);
+      return 0;
+    }
+#endif
+  return readBoxDataset(a_handle, boxes, name);
+}
+
 int readBoxes(HDF5Handle& a_handle, Vector<Vector<Box> >& boxes)
 {
   int error;
@@ -647,24 +673,56 @@ int HDF5Handle::open(
 
   m_mode = a_mode;
   m_filename = a_filename;
+  m_compression = HDF5Compression();
   if (!initialized) initialize();
   m_group    = "/";
 
   hid_t file_access = 0;
-  if (a_mode != CREATE_SERIAL)
+  if (a_mode == CREATE_IN_MEMORY)
+    {
+      // grow the image 64MB at a time, and never write it out
+      file_access = H5Pcreate (H5P_FILE_ACCESS);
+      H5Pset_fapl_core(file_access, 64*1024*1024, 0);
+    }
+  else if (a_mode != CREATE_SERIAL)
     {
 #ifdef CH_MPI
       file_access = H5Pcreate (H5P_FILE_ACCESS);
 
+      // MPI-IO hints for the aggregated collective writes of write()
+      MPI_Info info = MPI_INFO_NULL;
+      if (a_mode == CREATE &&
+          (CH_HDF5::writeAggregators() > 0 || CH_HDF5::writeAlignment() > 0))
+        {
+          char value[32];
+          MPI_Info_create(&info);
+          MPI_Info_set(info, (char*)"romio_cb_write", (char*)"enable");
+          if (CH_HDF5::writeAggregators() > 0)
+            {
+              sprintf(value, "%d", std::min(CH_HDF5::writeAggregators(), (int)numProc()));
+              MPI_Info_set(info, (char*)"cb_nodes", value);
+            }
+          if (CH_HDF5::writeAlignment() > 0)
+            {
+              sprintf(value, "%lld", CH_HDF5::writeAlignment());
+              MPI_Info_set(info, (char*)"striping_unit", value);
+            }
+        }
 #if ( H5_VERS_MAJOR == 1 && H5_VERS_MINOR <= 2 )
-      H5Pset_mpi(file_access,  Chombo_MPI::comm, MPI_INFO_NULL);
+      H5Pset_mpi(file_access,  Chombo_MPI::comm, info);
 #else
-      H5Pset_fapl_mpio(file_access,  Chombo_MPI::comm, MPI_INFO_NULL);
+      H5Pset_fapl_mpio(file_access,  Chombo_MPI::comm, info);
 #endif
+      if (info != MPI_INFO_NULL) MPI_Info_free(&info);
 #else
       file_access = H5P_DEFAULT;
 #endif
     }
+  if (a_mode == CREATE && CH_HDF5::writeAlignment() > 0)
+    {
+      if (file_access == H5P_DEFAULT) file_access = H5Pcreate (H5P_FILE_ACCESS);
+      H5Pset_alignment(file_access, CH_HDF5::writeAlignment()/2, CH_HDF5::writeAlignment());
+    }
 
   switch(a_mode)
   {
@@ -676,6 +734,10 @@ int HDF5Handle::open(
     m_fileID = H5Fcreate(a_filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
     if (m_fileID < 0) return m_fileID;
     break;
+  case CREATE_IN_MEMORY:
+    m_fileID = H5Fcreate(a_filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, file_access);
+    if (m_fileID < 0) return m_fileID;
+    break;
   case OPEN_RDONLY:
     m_fileID = H5Fopen(a_filename.c_str(), H5F_ACC_RDONLY, file_access);
     if (m_fileID < 0) return m_fileID;
@@ -705,6 +767,7 @@ int HDF5Handle::open(
   {
   case CREATE_SERIAL:
   case CREATE:
+  case CREATE_IN_MEMORY:
 #ifdef H516
     group = H5Gcreate(m_fileID, a_globalGroupName, 0);
 #else
@@ -898,6 +961,21 @@ void HDF5Handle::close()
   }
 }
 
+int HDF5Handle::getFileImage(std::vector<char>& a_image)
+{
+  CH_assert(m_isOpen);
+  H5Fflush(m_fileID, H5F_SCOPE_GLOBAL);
+  ssize_t size = H5Fget_file_image(m_fileID, NULL, 0);
+  if (size < 0) return size;
+  a_image.resize(size);
+  if (size > 0)
+    {
+      size = H5Fget_file_image(m_fileID, &(a_image[0]), size);
+      if (size < 0) return size;
+    }
+  return 0;
+}
+
 const std::string&  HDF5Handle::getGroup() const
 {
   return m_group;
@@ -1284,5 +1362,454 @@ void HDF5HeaderData::dump() const
   pout()<<*this<<std::endl;
 }
 
+//----------------------------------------------------------
+// aggregated writes of a BoxLayoutData
+
+static int       s_writeAggregators = -1;
+static long long s_writeAlignment = -1;
+static int       s_reportWriteBandwidth = -1;
+static double    s_lastWriteBandwidth = 0;
+
+void CH_HDF5::setWriteAggregators(int a_numAggregators)
+{
+  CH_assert(a_numAggregators >= 0);
+  s_writeAggregators = a_numAggregators;
+}
+
+int CH_HDF5::writeAggregators()
+{
+  if (s_writeAggregators < 0)
+    {
+      s_writeAggregators = 0;
+      ParmParse pp("hdf5");
+      pp.query("aggregators", s_writeAggregators);
+      if (s_writeAggregators < 0)
+        {
+          MayDay::Error("hdf5.aggregators must be >= 0");
+        }
+    }
+  return s_writeAggregators;
+}
+
+void CH_HDF5::setWriteAlignment(long long a_alignment)
+{
+  CH_assert(a_alignment >= 0);
+  s_writeAlignment = a_alignment;
+}
+
+long long CH_HDF5::writeAlignment()
+{
+  if (s_writeAlignment < 0)
+    {
+      int alignment = 0;
+      ParmParse pp("hdf5");
+      pp.query("alignment", alignment);
+      if (alignment < 0)
+        {
+          MayDay::Error("hdf5.alignment must be >= 0");
+        }
+      s_writeAlignment = alignment;
+    }
+  return s_writeAlignment;
+}
+
+void CH_HDF5::setReportWriteBandwidth(bool a_report)
+{
+  s_reportWriteBandwidth = a_report ? 1 : 0;
+}
+
+bool CH_HDF5::reportWriteBandwidth()
+{
+  if (s_reportWriteBandwidth < 0)
+    {
+      bool report = false;
+      ParmParse pp("hdf5");
+      pp.query("report_bandwidth", report);
+      s_reportWriteBandwidth = report ? 1 : 0;
+    }
+  return s_reportWriteBandwidth == 1;
+}
+
+double CH_HDF5::lastWriteBandwidth()
+{
+  return s_lastWriteBandwidth;
+}
+
+double CH_HDF5::wallClock()
+{
+#ifdef CH_MPI
+  return MPI_Wtime();
+#else
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// only files opened by every processor are written collectively
+static bool isParallelFile(const HDF5Handle& a_handle)
+{
+#ifdef CH_MPI
+  return a_handle.openMode() == HDF5Handle::CREATE ||
+         a_handle.openMode() == HDF5Handle::OPEN_RDWR;
+#else
+  return false;
+#endif
+}
+
+void CH_HDF5::recordWrite(const HDF5Handle& a_handle, const std::string& a_name,
+                          long long a_bytes, double a_startTime)
+{
+  double seconds = wallClock() - a_startTime;
+#ifdef CH_MPI
+  // the time of the slowest processor costs a collective, so only when
+  // the bandwidth is reported
+  if (reportWriteBandwidth() && isParallelFile(a_handle))
+    {
+      double mySeconds = seconds;
+      MPI_Allreduce(&mySeconds, &seconds, 1, MPI_DOUBLE, MPI_MAX, Chombo_MPI::comm);
+    }
+#endif
+  s_lastWriteBandwidth = (seconds > 0) ? a_bytes/seconds : 0;
+  if (reportWriteBandwidth())
+    {
+      pout() << "HDF5 write of " << a_name << " to " << a_handle.getFilename() << ": "
+             << a_bytes/1.0e6 << " MB in " << seconds << " s, "
+             << s_lastWriteBandwidth/1.0e6 << " MB/s" << endl;
+    }
+}
+
+//----------------------------------------------------------
+// slab reads of a LevelData
+
+static int s_slabRead = -1;
+
+void CH_HDF5::setSlabRead(bool a_slabRead)
+{
+  s_slabRead = a_slabRead ? 1 : 0;
+}
+
+bool CH_HDF5::slabRead()
+{
+  if (s_slabRead < 0)
+    {
+      bool slabRead = false;
+      ParmParse pp("hdf5");
+      pp.query("slab_read", slabRead);
+      s_slabRead = slabRead ? 1 : 0;
+    }
+  return s_slabRead == 1;
+}
+
+bool CH_HDF5::readsSlabs(const HDF5Handle& a_handle)
+{
+  return slabRead() && (a_handle.openMode() == HDF5Handle::OPEN_RDONLY ||
+                        a_handle.openMode() == HDF5Handle::OPEN_RDWR);
+}
+
+int CH_HDF5::readOffsets(const HDF5Handle& a_handle, const char* a_name,
+                         Vector<long long>& a_offsets)
+{
+  CH_TIME("CH_HDF5::readOffsets");
+  long long size = 0;
+  int err = 0;
+  if (procID() == 0)
+    {
+#ifdef H516
+      hid_t dataset = H5Dopen(a_handle.groupID(), a_name);
+#else
+      hid_t dataset = H5Dopen2(a_handle.groupID(), a_name, H5P_DEFAULT);
+#endif
+      if (dataset < 0)
+        {
+          err = dataset;
+        }
+      else
+        {
+          hid_t dataspace = H5Dget_space(dataset);
+          size = H5Sget_simple_extent_npoints(dataspace);
+          a_offsets.resize(size);
+          if (size > 0)
+            {
+              err = H5Dread(dataset, H5T_NATIVE_LLONG, H5S_ALL, H5S_ALL,
+                            H5P_DEFAULT, &(a_offsets[0]));
+            }
+          H5Sclose(dataspace);
+          H5Dclose(dataset);
+        }
+    }
+#ifdef CH_MPI
+  MPI_Bcast(&err, 1, MPI_INT, 0, Chombo_MPI::comm);
+  MPI_Bcast(&size, 1, MPI_LONG_LONG, 0, Chombo_MPI::comm);
+  a_offsets.resize(size);
+  if (err >= 0 && size > 0)
+    {
+      MPI_Bcast(&(a_offsets[0]), size, MPI_LONG_LONG, 0, Chombo_MPI::comm);
+    }
+#endif
+  return (err < 0) ? err : 0;
+}
+
+int CH_HDF5::readSlab(hid_t a_dataset, hid_t a_type, long long a_first,
+                      long long a_count, void* a_buffer)
+{
+  hsize_t count[1];
+  ch_offset_t offset[1];
+  count[0] = a_count;
+  offset[0] = a_first;
+  hsize_t memdims[1] = {count[0] > 0 ? count[0] : 1};
+  hid_t dataspace = H5Dget_space(a_dataset);
+  hid_t memdataspace = H5Screate_simple(1, memdims, NULL);
+  if (count[0] > 0)
+    {
+      H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, offset, NULL, count, NULL);
+    }
+  else // every processor takes part in the collective read
+    {
+      H5Sselect_none(dataspace);
+      H5Sselect_none(memdataspace);
+    }
+  hid_t DXPL = H5P_DEFAULT;
+#ifdef CH_MPI
+  DXPL = H5Pcreate(H5P_DATASET_XFER);
+  H5Pset_dxpl_mpio(DXPL, H5FD_MPIO_COLLECTIVE);
+#endif
+  herr_t err;
+  {
+    CH_TIME("H5Dread");
+    err = H5Dread(a_dataset, a_type, memdataspace, dataspace, DXPL, a_buffer);
+  }
+  if (DXPL != H5P_DEFAULT) H5Pclose(DXPL);
+  H5Sclose(memdataspace);
+  H5Sclose(dataspace);
+  return err;
+}
+
+static bool            s_plotCompressionSet = false;
+static HDF5Compression s_plotCompression;
+
+void CH_HDF5::setPlotCompression(const HDF5Compression& a_compression)
+{
+  s_plotCompression = a_compression;
+  s_plotCompressionSet = true;
+}
+
+const HDF5Compression& CH_HDF5::plotCompression()
+{
+  if (!s_plotCompressionSet)
+    {
+      ParmParse pp("hdf5");
+      pp.query("plot_deflate", s_plotCompression.m_deflate);
+      if (s_plotCompression.m_deflate < 0 || s_plotCompression.m_deflate > 9)
+        {
+          MayDay::Error("hdf5.plot_deflate must be in [0, 9]");
+        }
+      pp.query("plot_float", s_plotCompression.m_float);
+      int numBits = pp.countval("plot_mantissa_bits");
+      if (numBits > 0)
+        {
+          std::vector<int> bits;
+          pp.getarr("plot_mantissa_bits", bits, 0, numBits);
+          s_plotCompression.m_mantissaBits = Vector<int>(bits);
+        }
+      s_plotCompressionSet = true;
+    }
+  return s_plotCompression;
+}
+
+hid_t CH_HDF5::datasetProperties(const HDF5Compression& a_compression,
+                                 long long a_size, long long a_maxBox)
+{
+  if (a_compression.m_deflate <= 0 || a_size <= 0)
+    {
+      return H5P_DEFAULT;
+    }
+  // a box spans at most two chunks; chunks stay well below HDF5's 4GB limit
+  hsize_t chunk[1];
+  chunk[0] = std::max(std::min(std::min(a_maxBox, a_size), (long long)1 << 24),
+                      (long long)1);
+  hid_t properties = H5Pcreate(H5P_DATASET_CREATE);
+  H5Pset_chunk(properties, 1, chunk);
+  H5Pset_shuffle(properties);
+  H5Pset_deflate(properties, a_compression.m_deflate);
+  return properties;
+}
+
+void CH_HDF5::reducePrecision(void* a_buffer, long long a_count,
+                              long long a_numPoints, int a_numComps,
+                              const HDF5Compression& a_compression)
+{
+  CH_TIMELEAF("CH_HDF5::reducePrecision");
+  double* data = (double*)a_buffer;
+  // component c is a_numPoints doubles after component c-1, unless the
+  // data is laid out some other way
+  if (a_numPoints*a_numComps == a_count)
+    {
+      for (int c = 0; c < a_numComps; c++)
+        {
+          const int drop = 52 - a_compression.mantissaBits(c);
+          if (drop <= 0) continue;
+          const unsigned long long half = 1ULL << (drop - 1);
+          const unsigned long long mask = ~((1ULL << drop) - 1);
+          double* comp = data + c*a_numPoints;
+          for (long long i = 0; i < a_numPoints; i++)
+            {
+              unsigned long long bits;
+              memcpy(&bits, comp + i, sizeof(double));
+              // leave infinities and NaNs alone
+              if ((bits & 0x7ff0000000000000ULL) == 0x7ff0000000000000ULL) continue;
+              // round to nearest; a carry into the exponent is still right
+              bits = (bits + half) & mask;
+              memcpy(comp + i, &bits, sizeof(double));
+            }
+        }
+    }
+  if (a_compression.m_float)
+    {
+      // in place: float i goes in the bytes of double i/2, already read
+      char* bytes = (char*)a_buffer;
+      for (long long i = 0; i < a_count; i++)
+        {
+          double value;
+          memcpy(&value, bytes + i*sizeof(double), sizeof(double));
+          float single = (float)value;
+          memcpy(bytes + i*sizeof(float), &single, sizeof(float));
+        }
+    }
+}
+
+// bytes of the piece of a dataset of a_bytes that each of a_numAggregators
+// aggregators writes: a multiple of the alignment and of a_typeSize
+static long long aggregatePiece(long long a_bytes, int a_numAggregators, size_t a_typeSize)
+{
+  long long piece = (a_bytes + a_numAggregators - 1)/a_numAggregators;
+  long long alignment = CH_HDF5::writeAlignment();
+  if (alignment > 0)
+    {
+      piece = ((piece + alignment - 1)/alignment)*alignment;
+    }
+  piece = ((piece + a_typeSize - 1)/a_typeSize)*a_typeSize;
+  return piece > 0 ? piece : a_typeSize;
+}
+
+int CH_HDF5::writeAggregatorsFor(const HDF5Handle& a_handle,
+                                 const Vector<Vector<long long> >& a_offsets,
+                                 const Vector<size_t>& a_typeSize)
+{
+  int numAggregators = std::min(writeAggregators(), (int)numProc());
+  if (numProc() == 1 || !isParallelFile(a_handle))
+    {
+      return 0;
+    }
+  // parallel HDF5 only writes filtered datasets collectively
+  if (a_handle.compression().m_deflate > 0)
+    {
+      numAggregators = std::max(numAggregators, 1);
+    }
+  if (numAggregators <= 0)
+    {
+      return 0;
+    }
+  // MPI counts are ints: more aggregators, up to one per processor, when a
+  // piece would be too large; writeAggregated() writes in rounds when even
+  // that is not enough
+  for (int i = 0; i < a_offsets.size(); i++)
+    {
+      long long bytes = a_offsets[i][a_offsets[i].size()-1]*a_typeSize[i];
+      while (numAggregators < numProc() &&
+             aggregatePiece(bytes, numAggregators, a_typeSize[i]) > INT_MAX)
+        {
+          numAggregators++;
+        }
+    }
+  return numAggregators;
+}
+
+int CH_HDF5::writeAggregated(hid_t a_dataset, hid_t a_dataspace, hid_t a_type,
+                             const Vector<long long>& a_offsets,
+                             const Vector<int>& a_procs,
+                             const char* a_local, int a_numAggregators)
+{
+#ifdef CH_MPI
+  CH_TIME("CH_HDF5::writeAggregated");
+  const int numBoxes = a_procs.size();
+  const long long typeSize = H5Tget_size(a_type);
+  Vector<long long> byteOffsets(numBoxes + 1);
+  for (int b = 0; b <= numBoxes; b++)
+    {
+      byteOffsets[b] = a_offsets[b]*typeSize;
+    }
+  const long long total = byteOffsets[numBoxes];
+
+  // one round if no MPI count overflows, else rounds of at most INT_MAX
+  // bytes in all, so that no processor sends more than that in one
+  long long piece = aggregatePiece(total, a_numAggregators, typeSize);
+  Vector<long long> procBytes(numProc(), 0);
+  for (int b = 0; b < numBoxes; b++)
+    {
+      procBytes[a_procs[b]] += byteOffsets[b+1] - byteOffsets[b];
+    }
+  long long maxProcBytes = 0;
+  for (int p = 0; p < procBytes.size(); p++)
+    {
+      maxProcBytes = std::max(maxProcBytes, procBytes[p]);
+    }
+  if (piece > INT_MAX || maxProcBytes > INT_MAX)
+    {
+      piece = INT_MAX/a_numAggregators;
+      long long alignment = CH_HDF5::writeAlignment();
+      if (alignment > 0 && alignment <= piece)
+        {
+          piece = (piece/alignment)*alignment;
+        }
+      piece = std::max((piece/typeSize)*typeSize, typeSize);
+    }
+
+  herr_t err = 0;
+  hid_t DXPL = H5Pcreate(H5P_DATASET_XFER);
+  H5Pset_dxpl_mpio(DXPL, H5FD_MPIO_COLLECTIVE);
+  std::vector<char> contiguous;
+  // every processor makes the same number of collective writes
+  for (long long start = 0; start < total; start += a_numAggregators*piece)
+    {
+      long long lo, hi;
+      {
+        CH_TIME("gatherPieces");
+        gatherPieces(contiguous, lo, hi, a_local, byteOffsets, a_procs, piece,
+                     a_numAggregators, start);
+      }
+      contiguous.resize(hi - lo + 1);
+
+      hsize_t count[1];
+      ch_offset_t offset[1];
+      count[0] = (hi - lo)/typeSize;
+      offset[0] = lo/typeSize;
+      hsize_t memdims[1] = {count[0] > 0 ? count[0] : 1};
+      hid_t memdataspace = H5Screate_simple(1, memdims, NULL);
+      if (count[0] > 0)
+        {
+          herr_t selectErr = H5Sselect_hyperslab(a_dataspace, H5S_SELECT_SET,
+                                                 offset, NULL, count, NULL);
+          CH_assert(selectErr >= 0);
+        }
+      else // every processor takes part in the collective write
+        {
+          H5Sselect_none(a_dataspace);
+          H5Sselect_none(memdataspace);
+        }
+      {
+        CH_TIME("H5Dwrite");
+        herr_t roundErr = H5Dwrite(a_dataset, a_type, memdataspace, a_dataspace,
+                                   DXPL, &(contiguous[0]));
+        if (roundErr < 0) err = roundErr;
+      }
+      H5Sclose(memdataspace);
+    }
+  H5Pclose(DXPL);
+  return err;
+#else
+  MayDay::Error("CH_HDF5::writeAggregated needs MPI");
+  return -1;
+#endif
+}
+
 #include "NamespaceFooter.H"
 #endif // CH_USE_HDF5
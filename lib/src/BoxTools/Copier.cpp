@@ -14,20 +14,121 @@
 #include "MayDay.H"
 #include "LayoutIterator.H"
 #include "NeighborIterator.H"
+#include "RegridMap.H"
 #include "BoxIterator.H"
 #include "SPMD.H"
 #include "CH_Timer.H"
 #include "memtrack.H"
 #include "parstream.H"
+#include "ParmParse.H"
 #include <chrono>
+#include <climits>
 
 #include <vector>
+#include <map>
+#include <algorithm>
 #include "NamespaceHeader.H"
 
 using std::ostream;
 
 Pool Copier::s_motionItemPool(sizeof(MotionItem), "Copier::MotionItem", 500);
 
+bool CopierBuffer::s_persistentRequests = false;
+int  CopierBuffer::s_messageBackend = -1;
+int  CopierBuffer::s_sharedMemory = -1;
+
+#ifdef CH_MPI
+MPI_Win  CopierBuffer::s_sharedWin;
+MPI_Comm CopierBuffer::s_sharedComm = MPI_COMM_NULL;
+#endif
+
+#if defined(CH_MPI) && (MPI_VERSION >= 3)
+// processors sharing this node, and the node rank of each Chombo_MPI::comm
+// rank (-1 if it is on another node); built with the shared window
+static MPI_Comm         s_nodeComm = MPI_COMM_NULL;
+static std::vector<int> s_nodeRank;
+
+// our part of the shared window, and its free pieces (offset -> size)
+static char*                         s_sharedBase = NULL;
+static std::map<long long, long long> s_sharedFree;
+
+static void defineNodeComm()
+{
+  if (s_nodeComm != MPI_COMM_NULL) return;
+  MPI_Comm_split_type(Chombo_MPI::comm, MPI_COMM_TYPE_SHARED, 0,
+                      MPI_INFO_NULL, &s_nodeComm);
+  MPI_Group worldGroup, nodeGroup;
+  MPI_Comm_group(Chombo_MPI::comm, &worldGroup);
+  MPI_Comm_group(s_nodeComm, &nodeGroup);
+  std::vector<int> worldRanks(numProc());
+  for (int i = 0; i < numProc(); i++) worldRanks[i] = i;
+  s_nodeRank.resize(numProc());
+  MPI_Group_translate_ranks(worldGroup, numProc(), worldRanks.data(),
+                            nodeGroup, s_nodeRank.data());
+  for (int i = 0; i < numProc(); i++)
+    {
+      if (s_nodeRank[i] == MPI_UNDEFINED) s_nodeRank[i] = -1;
+    }
+  MPI_Group_free(&worldGroup);
+  MPI_Group_free(&nodeGroup);
+}
+
+// MPI_Finalize deletes the attributes of MPI_COMM_SELF first, on every
+// processor, which makes it the collective point to free the window
+static int freeSharedWindowAtFinalize(MPI_Comm a_comm, int a_keyval,
+                                      void* a_value, void* a_extra)
+{
+  MPI_Win_unlock_all(CopierBuffer::s_sharedWin);
+  MPI_Win_free(&CopierBuffer::s_sharedWin);
+  MPI_Comm_free(&CopierBuffer::s_sharedComm);
+  MPI_Comm_free(&s_nodeComm);
+  s_sharedBase = NULL;
+  s_sharedFree.clear();
+  return MPI_SUCCESS;
+}
+
+// first fit in our part of the window; -1 if there is no room
+static long long allocSharedSegment(long long a_size)
+{
+  std::map<long long, long long>::iterator it = s_sharedFree.begin();
+  for (; it != s_sharedFree.end(); ++it)
+    {
+      if (it->second >= a_size)
+        {
+          long long offset = it->first;
+          long long left   = it->second - a_size;
+          s_sharedFree.erase(it);
+          if (left > 0) s_sharedFree[offset + a_size] = left;
+          return offset;
+        }
+    }
+  return -1;
+}
+
+static void returnSharedSegment(long long a_offset, long long a_size)
+{
+  std::map<long long, long long>::iterator it =
+    s_sharedFree.insert(std::make_pair(a_offset, a_size)).first;
+  std::map<long long, long long>::iterator next = it;
+  ++next;
+  if (next != s_sharedFree.end() && it->first + it->second == next->first)
+    {
+      it->second += next->second;
+      s_sharedFree.erase(next);
+    }
+  if (it != s_sharedFree.begin())
+    {
+      std::map<long long, long long>::iterator prev = it;
+      --prev;
+      if (prev->first + prev->second == it->first)
+        {
+          prev->second += it->second;
+          s_sharedFree.erase(it);
+        }
+    }
+}
+#endif
+
 CopierBuffer::~CopierBuffer()
 {
   clear();
@@ -35,6 +136,10 @@ CopierBuffer::~CopierBuffer()
 
 void CopierBuffer::clear()
 {
+  freePersistentRequests();
+  freeNeighborGraph();
+  freeSharedSegment();
+  m_useShared = false;
   if (m_sendbuffer != NULL) freeMT(m_sendbuffer);
   if (m_recbuffer  != NULL) freeMT(m_recbuffer);
   m_sendbuffer = NULL;
@@ -42,6 +147,447 @@ void CopierBuffer::clear()
   m_sendcapacity = 0;
   m_reccapacity = 0;
   m_ncomps = 0;
+  m_toMeUnpack.resize(0);
+}
+
+void CopierBuffer::freePersistentRequests()
+{
+#ifdef CH_MPI
+  if (m_persistentSends.size() == 0 && m_persistentReceives.size() == 0 &&
+      !m_hasNeighborRequest) return;
+  // Copiers with static lifetime can outlive MPI_Finalize
+  int finalized = 0;
+  MPI_Finalized(&finalized);
+  if (!finalized)
+    {
+      if (m_hasNeighborRequest) MPI_Request_free(&m_neighborRequest);
+      for (unsigned int i = 0; i < m_persistentSends.size(); ++i)
+        {
+          MPI_Request_free(&(m_persistentSends[i]));
+        }
+      for (unsigned int i = 0; i < m_persistentReceives.size(); ++i)
+        {
+          MPI_Request_free(&(m_persistentReceives[i]));
+        }
+    }
+  m_persistentSends.resize(0);
+  m_persistentReceives.resize(0);
+  m_hasNeighborRequest = false;
+#endif
+}
+
+int CopierBuffer::messageBackend()
+{
+  if (s_messageBackend < 0)
+    {
+      s_messageBackend = POINT_TO_POINT;
+      ParmParse pp("copier");
+      if (pp.contains("message_backend"))
+        {
+          std::string backend;
+          pp.get("message_backend", backend);
+          if (backend == "neighbor_collective")
+            {
+              s_messageBackend = NEIGHBOR_COLLECTIVE;
+            }
+          else if (backend != "point_to_point")
+            {
+              MayDay::Error("copier.message_backend must be point_to_point or neighbor_collective");
+            }
+        }
+    }
+#if defined(CH_MPI) && (MPI_VERSION < 3)
+  return POINT_TO_POINT;
+#else
+  return s_messageBackend;
+#endif
+}
+
+#if defined(CH_MPI) && (MPI_VERSION >= 3)
+// graph communicators of cleared Copiers, waiting for releaseRetired()
+static std::vector<MPI_Comm> s_retiredGraphs;
+#endif
+
+// the distinct procIDs of a motion plan, in increasing order
+static std::vector<int> planProcs(const Vector<MotionItem*>& a_plan)
+{
+  std::vector<int> procs;
+  for (int i = 0; i < a_plan.size(); ++i)
+    {
+      procs.push_back(a_plan[i]->procID);
+    }
+  std::sort(procs.begin(), procs.end());
+  procs.erase(std::unique(procs.begin(), procs.end()), procs.end());
+  return procs;
+}
+
+void CopierBuffer::defineNeighborGraph(const Vector<MotionItem*>& a_fromPlan,
+                                       const Vector<MotionItem*>& a_toPlan)
+{
+#if defined(CH_MPI) && (MPI_VERSION >= 3)
+  CH_TIME("CopierBuffer::defineNeighborGraph");
+  freeNeighborGraph();
+  m_graphDests   = planProcs(a_fromPlan);
+  m_graphSources = planProcs(a_toPlan);
+
+  // no reordering: graph ranks must match Chombo_MPI::comm ranks
+  int result = MPI_Dist_graph_create_adjacent(Chombo_MPI::comm,
+                                              m_graphSources.size(), m_graphSources.data(),
+                                              MPI_UNWEIGHTED,
+                                              m_graphDests.size(), m_graphDests.data(),
+                                              MPI_UNWEIGHTED,
+                                              MPI_INFO_NULL, 0, &m_graphComm);
+  if (result != MPI_SUCCESS)
+    {
+      MayDay::Error("CopierBuffer: MPI_Dist_graph_create_adjacent failed");
+    }
+  m_ownsGraph = true;
+#else
+  MayDay::Error("CopierBuffer::defineNeighborGraph needs MPI-3");
+#endif
+}
+
+// counts and displacements of the messages in a_entries, one per neighbor
+// in a_procs; a_entries are sorted by procID and laid out contiguously in
+// the buffer at a_base, so each neighbor's message is a single block
+static void neighborCounts(const std::vector<CopierBuffer::bufEntry>& a_entries,
+                           const void* a_base, const std::vector<int>& a_procs,
+                           std::vector<int>& a_counts, std::vector<int>& a_displs)
+{
+  std::vector<long long> bytes(a_procs.size(), 0), offsets(a_procs.size(), 0);
+  unsigned int n = 0;
+  for (unsigned int i = 0; i < a_entries.size(); ++i)
+    {
+      const CopierBuffer::bufEntry& b = a_entries[i];
+      while (n < a_procs.size() && a_procs[n] < (int)b.procID) ++n;
+      CH_assert(n < a_procs.size() && a_procs[n] == (int)b.procID);
+      if (bytes[n] == 0)
+        {
+          offsets[n] = (const char*)b.bufPtr - (const char*)a_base;
+        }
+      bytes[n] += b.size;
+    }
+  a_counts.resize(a_procs.size());
+  a_displs.resize(a_procs.size());
+  for (unsigned int i = 0; i < a_procs.size(); ++i)
+    {
+      if (offsets[i] + bytes[i] > INT_MAX)
+        {
+          MayDay::Error("CopierBuffer: messages too large for neighbor_collective backend");
+        }
+      a_counts[i] = bytes[i];
+      a_displs[i] = offsets[i];
+    }
+}
+
+void CopierBuffer::defineNeighborCounts()
+{
+#ifdef CH_MPI
+  neighborCounts(m_fromMe, m_sendbuffer, m_graphDests,   m_sendCounts, m_sendDispls);
+  neighborCounts(m_toMe,   m_recbuffer,  m_graphSources, m_recvCounts, m_recvDispls);
+#endif
+}
+
+bool CopierBuffer::hasNeighborGraph() const
+{
+#ifdef CH_MPI
+  return m_graphComm != MPI_COMM_NULL;
+#else
+  return false;
+#endif
+}
+
+void CopierBuffer::freeNeighborGraph()
+{
+#ifdef CH_MPI
+  freePersistentRequests();
+  if (m_graphComm != MPI_COMM_NULL)
+    {
+#if MPI_VERSION >= 3
+      int finalized = 0;
+      MPI_Finalized(&finalized);
+      if (!finalized && m_ownsGraph) s_retiredGraphs.push_back(m_graphComm);
+#endif
+      m_graphComm = MPI_COMM_NULL;
+      m_ownsGraph = false;
+    }
+  m_graphDests.resize(0);
+  m_graphSources.resize(0);
+  m_sendCounts.resize(0);
+  m_sendDispls.resize(0);
+  m_recvCounts.resize(0);
+  m_recvDispls.resize(0);
+#endif
+}
+
+void CopierBuffer::shareCommunication(const CopierBuffer& a_owner)
+{
+#ifdef CH_MPI
+  freeNeighborGraph();
+  m_graphComm    = a_owner.m_graphComm;
+  m_graphDests   = a_owner.m_graphDests;
+  m_graphSources = a_owner.m_graphSources;
+  m_ownsGraph    = false;
+#endif
+  m_useShared = a_owner.m_useShared;
+}
+
+void CopierBuffer::releaseRetired()
+{
+#if defined(CH_MPI) && (MPI_VERSION >= 3)
+  for (unsigned int i = 0; i < s_retiredGraphs.size(); ++i)
+    {
+      MPI_Comm_free(&(s_retiredGraphs[i]));
+    }
+  s_retiredGraphs.resize(0);
+#endif
+}
+
+struct BufEntryDestLess
+{
+  bool operator()(const CopierBuffer::bufEntry& a, const CopierBuffer::bufEntry& b) const
+  {
+    return a.item->toIndex.intCode() < b.item->toIndex.intCode();
+  }
+};
+
+void CopierBuffer::defineUnpackGroups()
+{
+  std::vector<bufEntry> entries(m_toMe);
+  entries.insert(entries.end(), m_toMeShared.begin(), m_toMeShared.end());
+  std::stable_sort(entries.begin(), entries.end(), BufEntryDestLess());
+  m_toMeUnpack.resize(0);
+  for (unsigned int i = 0; i < entries.size(); ++i)
+    {
+      if (i == 0 || entries[i].item->toIndex.intCode() != entries[i-1].item->toIndex.intCode())
+        {
+          m_toMeUnpack.push_back(std::vector<bufEntry>());
+        }
+      m_toMeUnpack.back().push_back(entries[i]);
+    }
+}
+
+bool CopierBuffer::sharedMemory()
+{
+  if (s_sharedMemory < 0)
+    {
+      s_sharedMemory = 0;
+      ParmParse pp("copier");
+      bool shared = false;
+      pp.query("shared_memory", shared);
+      if (shared) s_sharedMemory = 1;
+    }
+#if defined(CH_MPI) && (MPI_VERSION >= 3)
+  return s_sharedMemory > 0;
+#else
+  return false;
+#endif
+}
+
+bool CopierBuffer::onNode(int a_procID)
+{
+#if defined(CH_MPI) && (MPI_VERSION >= 3)
+  CH_assert(s_nodeComm != MPI_COMM_NULL);
+  return s_nodeRank[a_procID] >= 0;
+#else
+  return false;
+#endif
+}
+
+void CopierBuffer::splitSharedEntries()
+{
+  m_fromMeShared.resize(0);
+  m_toMeShared.resize(0);
+  m_sharedDests.resize(0);
+  m_sharedSources.resize(0);
+  // the lists are sorted by procID; keep that order in both halves
+  std::vector<bufEntry> offNode;
+  for (unsigned int i = 0; i < m_fromMe.size(); ++i)
+    {
+      const bufEntry& b = m_fromMe[i];
+      if (onNode(b.procID))
+        {
+          if (m_sharedDests.size() == 0 || m_sharedDests.back() != (int)b.procID)
+            {
+              m_sharedDests.push_back(b.procID);
+            }
+          m_fromMeShared.push_back(b);
+        }
+      else
+        {
+          offNode.push_back(b);
+        }
+    }
+  m_fromMe.swap(offNode);
+  offNode.resize(0);
+  for (unsigned int i = 0; i < m_toMe.size(); ++i)
+    {
+      const bufEntry& b = m_toMe[i];
+      if (onNode(b.procID))
+        {
+          if (m_sharedSources.size() == 0 || m_sharedSources.back() != (int)b.procID)
+            {
+              m_sharedSources.push_back(b.procID);
+            }
+          m_toMeShared.push_back(b);
+        }
+      else
+        {
+          offNode.push_back(b);
+        }
+    }
+  m_toMe.swap(offNode);
+}
+
+void CopierBuffer::defineSharedWindow()
+{
+#if defined(CH_MPI) && (MPI_VERSION >= 3)
+  if (s_sharedComm != MPI_COMM_NULL) return;
+  CH_TIME("CopierBuffer::defineSharedWindow");
+  defineNodeComm();
+  MPI_Comm_dup(Chombo_MPI::comm, &s_sharedComm);
+
+  int megabytes = 64;
+  ParmParse pp("copier");
+  pp.query("shared_window_size", megabytes);
+  MPI_Aint windowSize = (MPI_Aint)megabytes*1024*1024;
+  // let each processor's part live in its own NUMA domain
+  MPI_Info info;
+  MPI_Info_create(&info);
+  MPI_Info_set(info, "alloc_shared_noncontig", "true");
+  int result = MPI_Win_allocate_shared(windowSize, 1, info, s_nodeComm,
+                                       &s_sharedBase, &s_sharedWin);
+  MPI_Info_free(&info);
+  if (result != MPI_SUCCESS)
+    {
+      MayDay::Error("CopierBuffer: MPI_Win_allocate_shared failed");
+    }
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, s_sharedWin);
+  s_sharedFree.clear();
+  if (windowSize > 0) s_sharedFree[0] = windowSize;
+
+  int keyval;
+  MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, freeSharedWindowAtFinalize,
+                         &keyval, NULL);
+  MPI_Comm_set_attr(MPI_COMM_SELF, keyval, NULL);
+#else
+  MayDay::Error("CopierBuffer::defineSharedWindow needs MPI-3");
+#endif
+}
+
+void CopierBuffer::defineSharedSegment()
+{
+#if defined(CH_MPI) && (MPI_VERSION >= 3)
+  CH_TIME("CopierBuffer::defineSharedSegment");
+  freeSharedSegment();
+
+  long long segmentSize = 0;
+  for (unsigned int i = 0; i < m_fromMeShared.size(); ++i)
+    {
+      segmentSize += m_fromMeShared[i].size;
+    }
+  // whole cache lines, so no two Copiers write the same one
+  segmentSize = (segmentSize + 63)/64*64;
+  bool fits = true;
+  if (segmentSize > 0)
+    {
+      m_segmentOffset = allocSharedSegment(segmentSize);
+      fits = (m_segmentOffset >= 0);
+      if (fits) m_segmentSize = segmentSize;
+    }
+
+  // lay out our on-node messages, and tell each destination where its
+  // message starts in our part of the window (-1: it comes as a message)
+  std::vector<long long> sendOffsets, recvOffsets(m_sharedSources.size());
+  char* nextFree = s_sharedBase + (fits ? m_segmentOffset : 0);
+  for (unsigned int i = 0; i < m_fromMeShared.size(); ++i)
+    {
+      bufEntry& b = m_fromMeShared[i];
+      if (i == 0 || m_fromMeShared[i-1].procID != b.procID)
+        {
+          sendOffsets.push_back(fits ? nextFree - s_sharedBase : -1);
+        }
+      b.bufPtr = nextFree;
+      nextFree += b.size;
+    }
+  std::vector<MPI_Request> requests(m_sharedDests.size() + m_sharedSources.size());
+  for (unsigned int i = 0; i < m_sharedSources.size(); ++i)
+    {
+      MPI_Irecv(&(recvOffsets[i]), 1, MPI_LONG_LONG, m_sharedSources[i],
+                SharedOffsetTag, s_sharedComm, &(requests[i]));
+    }
+  for (unsigned int i = 0; i < m_sharedDests.size(); ++i)
+    {
+      MPI_Isend(&(sendOffsets[i]), 1, MPI_LONG_LONG, m_sharedDests[i],
+                SharedOffsetTag, s_sharedComm,
+                &(requests[m_sharedSources.size() + i]));
+    }
+  if (requests.size() > 0)
+    {
+      MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+    }
+
+  if (!fits)
+    {
+      m_fromMe.insert(m_fromMe.end(), m_fromMeShared.begin(), m_fromMeShared.end());
+      std::sort(m_fromMe.begin(), m_fromMe.end());
+      m_fromMeShared.resize(0);
+      m_sharedDests.resize(0);
+    }
+
+  // point our on-node receives straight into the senders' segments
+  std::vector<bufEntry> shared;
+  std::vector<int> sources;
+  unsigned int next = 0;
+  bool moved = false;
+  for (unsigned int i = 0; i < m_sharedSources.size(); ++i)
+    {
+      char* ptr = NULL;
+      if (recvOffsets[i] >= 0)
+        {
+          MPI_Aint peerSize;
+          int      peerDisp;
+          char*    peerBase;
+          MPI_Win_shared_query(s_sharedWin, s_nodeRank[m_sharedSources[i]],
+                               &peerSize, &peerDisp, &peerBase);
+          ptr = peerBase + recvOffsets[i];
+          sources.push_back(m_sharedSources[i]);
+        }
+      for (; next < m_toMeShared.size() && (int)m_toMeShared[next].procID == m_sharedSources[i]; ++next)
+        {
+          bufEntry b = m_toMeShared[next];
+          if (ptr == NULL)
+            {
+              m_toMe.push_back(b);
+              moved = true;
+            }
+          else
+            {
+              b.bufPtr = ptr;
+              ptr += b.size;
+              shared.push_back(b);
+            }
+        }
+    }
+  m_toMeShared.swap(shared);
+  m_sharedSources.swap(sources);
+  if (moved) std::sort(m_toMe.begin(), m_toMe.end());
+#else
+  MayDay::Error("CopierBuffer::defineSharedSegment needs MPI-3");
+#endif
+}
+
+void CopierBuffer::freeSharedSegment()
+{
+#if defined(CH_MPI) && (MPI_VERSION >= 3)
+  // the window itself lives until MPI_Finalize; nothing collective here
+  if (m_segmentSize > 0 && s_sharedBase != NULL)
+    {
+      returnSharedSegment(m_segmentOffset, m_segmentSize);
+    }
+#endif
+  m_segmentOffset = -1;
+  m_segmentSize = 0;
 }
 
 Copier::Copier(const DisjointBoxLayout& a_level,
@@ -100,7 +646,10 @@ void Copier::clear()
   m_localMotionPlan.resize(0);
   m_fromMotionPlan.resize(0);
   m_toMotionPlan.resize(0);
+  m_localCopyGroups.resize(0);
+  m_hasLocalCopyGroups = false;
   m_isDefined = false;
+  m_packedBuffers.clear();
   m_buffers.clear();
 }
 
@@ -132,6 +681,7 @@ Copier& Copier::operator= (const Copier& b)
     }
 
   m_isDefined = true;
+  defineCommunication();
   return *this;
 }
 
@@ -160,14 +710,23 @@ void Copier::trimMotion(const DisjointBoxLayout& a_exchangedLayout, const IntVec
 ///
 void Copier::trimEdges(const DisjointBoxLayout& a_exchangedLayout, const IntVect& a_ghost)
 {
-  Copier oldCopier = *this;
+  // take the old plan rather than copying the Copier, which would build
+  // its MPI resources just to throw them away
+  Vector<MotionItem*> oldLocal, oldFrom, oldTo;
+  oldLocal.swap(m_localMotionPlan);
+  oldFrom.swap(m_fromMotionPlan);
+  oldTo.swap(m_toMotionPlan);
   clear();
 
-  trimMotion(a_exchangedLayout, a_ghost, oldCopier.m_localMotionPlan, m_localMotionPlan);
-  //   pout() << "old Copy operations:" << oldCopier.m_localMotionPlan.size() << "  "
+  trimMotion(a_exchangedLayout, a_ghost, oldLocal, m_localMotionPlan);
+  //   pout() << "old Copy operations:" << oldLocal.size() << "  "
   //         << "new Copy operations:" << m_localMotionPlan.size() << "\n";
-  trimMotion(a_exchangedLayout, a_ghost, oldCopier.m_fromMotionPlan, m_fromMotionPlan);
-  trimMotion(a_exchangedLayout, a_ghost, oldCopier.m_toMotionPlan, m_toMotionPlan);
+  trimMotion(a_exchangedLayout, a_ghost, oldFrom, m_fromMotionPlan);
+  trimMotion(a_exchangedLayout, a_ghost, oldTo, m_toMotionPlan);
+  for (int i = 0; i < oldLocal.size(); ++i) s_motionItemPool.returnPtr(oldLocal[i]);
+  for (int i = 0; i < oldFrom.size(); ++i)  s_motionItemPool.returnPtr(oldFrom[i]);
+  for (int i = 0; i < oldTo.size(); ++i)    s_motionItemPool.returnPtr(oldTo[i]);
+  defineCommunication();
 }
 
 void Copier::reverse()
@@ -185,7 +744,41 @@ void Copier::reverse()
       m_toMotionPlan[i]->reverse();
     }
   m_fromMotionPlan.swap(m_toMotionPlan);
+  m_localCopyGroups.resize(0);
+  m_hasLocalCopyGroups = false;
+  // the messages now go the other way
+  m_packedBuffers.clear();
+  m_buffers.clear();
+  defineCommunication();
+}
+
+CopierBuffer& Copier::buffers(int a_packing) const
+{
+  if (a_packing == 0) return (CopierBuffer&)m_buffers;
+  RefCountedPtr<CopierBuffer>& buffer = m_packedBuffers[a_packing];
+  if (buffer.isNull())
+    {
+      // no new MPI resources: the graph belongs to m_buffers
+      buffer = RefCountedPtr<CopierBuffer>(new CopierBuffer());
+      buffer->shareCommunication(m_buffers);
+    }
+  return *buffer;
+}
 
+void Copier::defineCommunication()
+{
+#ifdef CH_MPI
+  CopierBuffer::releaseRetired();
+  if (CopierBuffer::messageBackend() == CopierBuffer::NEIGHBOR_COLLECTIVE)
+    {
+      m_buffers.defineNeighborGraph(m_fromMotionPlan, m_toMotionPlan);
+    }
+  if (CopierBuffer::sharedMemory())
+    {
+      CopierBuffer::defineSharedWindow();
+      m_buffers.m_useShared = true;
+    }
+#endif
 }
 
 bool Copier::operator==(const Copier& rhs) const
@@ -221,7 +814,42 @@ void Copier::coarsen(int a_refRatio)
       m_toMotionPlan[i]->fromRegion.coarsen(a_refRatio);
       m_toMotionPlan[i]->toRegion.coarsen(a_refRatio);
     }
+  m_localCopyGroups.resize(0);
+  m_hasLocalCopyGroups = false;
+}
 
+// order by destination only, so a stable sort keeps the original order
+// of the items that write into the same destination
+struct MotionItemDestLess
+{
+  bool operator()(const MotionItem* a, const MotionItem* b) const
+  {
+    return a->toIndex.intCode() < b->toIndex.intCode();
+  }
+};
+
+const std::vector<std::vector<const MotionItem*> >& Copier::localCopyGroups() const
+{
+  if (!m_hasLocalCopyGroups)
+    {
+      std::vector<const MotionItem*> items(m_localMotionPlan.size());
+      for (int i = 0; i < m_localMotionPlan.size(); ++i)
+        {
+          items[i] = m_localMotionPlan[i];
+        }
+      std::stable_sort(items.begin(), items.end(), MotionItemDestLess());
+      m_localCopyGroups.resize(0);
+      for (unsigned int i = 0; i < items.size(); ++i)
+        {
+          if (i == 0 || items[i]->toIndex.intCode() != items[i-1]->toIndex.intCode())
+            {
+              m_localCopyGroups.push_back(std::vector<const MotionItem*>());
+            }
+          m_localCopyGroups.back().push_back(items[i]);
+        }
+      m_hasLocalCopyGroups = true;
+    }
+  return m_localCopyGroups;
 }
 void Copier::define(const DisjointBoxLayout& a_level,
                     const BoxLayout& a_dest,
@@ -275,6 +903,7 @@ void Copier::defineFixedBoxSize(const DisjointBoxLayout& a_src,
   if(dit.size() == 0)
     {
       // just go ahead and return, this processor owns no boxes, and thus will not participate in this Copier operation
+      defineCommunication();
       return;
     }
   IntVect origin = domainBox.smallEnd();
@@ -365,6 +994,7 @@ void Copier::defineFixedBoxSize(const DisjointBoxLayout& a_src,
     }
   auto t1 = ch_ticks();
   sort();
+  defineCommunication();
   auto t2 = ch_ticks();
   std::chrono::duration<double> diff = std::chrono::system_clock::now()-ts;
   double rate = diff.count()/(t2-t1);
@@ -396,6 +1026,7 @@ void Copier::defineFixedSizeNodesCollect(const DisjointBoxLayout& a_layout,
     {
       // just go ahead and return: this processor owns no boxes,
       // and thus will not participate in this Copier operation
+      defineCommunication();
       return;
     }
 
@@ -503,6 +1134,7 @@ void Copier::defineFixedSizeNodesCollect(const DisjointBoxLayout& a_layout,
         }
     }
   sort();
+  defineCommunication();
 }
 
 
@@ -1036,6 +1668,7 @@ void Copier::define(const BoxLayout& a_level,
 
     } // end if we need to do anything for periodicity
   sort();
+  defineCommunication();
 }
 
 void Copier::ghostDefine(const DisjointBoxLayout& a_src,
@@ -1118,6 +1751,160 @@ void Copier::exchangeDefine(const DisjointBoxLayout& a_grids,
 
     }
   sort();
+  defineCommunication();
+}
+
+void Copier::regridDefine(const RegridMap& a_map)
+{
+  CH_TIME("Copier::regridDefine");
+  clear();
+  m_isDefined = true;
+  buffersAllocated = false;
+
+  const DisjointBoxLayout& oldGrids = a_map.oldGrids();
+  const DisjointBoxLayout& created  = a_map.createdGrids();
+  const DisjointBoxLayout& newGrids = a_map.newGrids();
+  const int myprocID = procID();
+  const bool isSorted = oldGrids.isSorted() && created.isSorted();
+
+  LayoutIterator oldLit = oldGrids.layoutIterator();
+  LayoutIterator newLit = newGrids.layoutIterator();
+  for (int inew = 0; inew < newGrids.size(); inew++)
+    {
+      const LayoutIndex& todi = newLit[inew];
+      if (a_map.survived(todi)) continue;
+      const int toProcID = newGrids.procID(todi);
+      const Box& toBox = newGrids[todi];
+      for (int iold = 0; iold < oldGrids.size(); iold++)
+        {
+          const LayoutIndex& fromdi = oldLit[iold];
+          const int fromProcID = oldGrids.procID(fromdi);
+          if (toProcID != myprocID && fromProcID != myprocID) continue;
+          const Box& fromBox = oldGrids[fromdi];
+          if (isSorted && fromBox.bigEnd(0) < toBox.smallEnd(0)) continue;
+          if (isSorted && fromBox.smallEnd(0) > toBox.bigEnd(0)) break;
+          if (!fromBox.intersectsNotEmpty(toBox)) continue;
+
+          MotionItem* item = new (s_motionItemPool.getPtr())
+            MotionItem(DataIndex(fromdi), DataIndex(todi), fromBox & toBox);
+          if (fromProcID == myprocID && toProcID == myprocID)
+            {
+              m_localMotionPlan.push_back(item);
+            }
+          else if (toProcID == myprocID)
+            {
+              item->procID = fromProcID;
+              m_toMotionPlan.push_back(item);
+            }
+          else
+            {
+              item->procID = toProcID;
+              m_fromMotionPlan.push_back(item);
+            }
+        }
+    }
+  sort();
+  defineCommunication();
+}
+
+void Copier::regridExchangeDefine(const Copier&    a_oldExchange,
+                                  const RegridMap& a_map,
+                                  const IntVect&   a_ghost)
+{
+  CH_TIME("Copier::regridExchangeDefine");
+  const DisjointBoxLayout& newGrids = a_map.newGrids();
+  if (!a_oldExchange.isDefined() || newGrids.physDomain().isPeriodic())
+    {
+      define(newGrids, newGrids, a_ghost, true);
+      return;
+    }
+  clear();
+  m_isDefined = true;
+  buffersAllocated = false;
+
+  // the items between two surviving boxes
+  const Vector<MotionItem*>* oldPlans[3] = {&a_oldExchange.m_localMotionPlan,
+                                            &a_oldExchange.m_fromMotionPlan,
+                                            &a_oldExchange.m_toMotionPlan};
+  Vector<MotionItem*>* newPlans[3] = {&m_localMotionPlan, &m_fromMotionPlan, &m_toMotionPlan};
+  for (int iplan = 0; iplan < 3; iplan++)
+    {
+      const Vector<MotionItem*>& plan = *oldPlans[iplan];
+      for (int i = 0; i < plan.size(); i++)
+        {
+          const MotionItem& old = *plan[i];
+          if (a_map.kept(old.fromIndex) && a_map.kept(old.toIndex))
+            {
+              MotionItem* item = new (s_motionItemPool.getPtr())
+                MotionItem(a_map.newIndex(old.fromIndex), a_map.newIndex(old.toIndex),
+                           old.fromRegion, old.toRegion);
+              item->procID = old.procID;
+              newPlans[iplan]->push_back(item);
+            }
+        }
+    }
+
+  // the items with a created box at one end, found from that end
+  const int myprocID = procID();
+  const bool isSorted = newGrids.isSorted();
+  LayoutIterator lit = newGrids.layoutIterator();
+  const int numBoxes = newGrids.size();
+  for (int i = 0; i < numBoxes; i++)
+    {
+      const LayoutIndex& di = lit[i];
+      if (a_map.survived(di)) continue;
+      const int iProcID = newGrids.procID(di);
+      const Box& iBox = newGrids[di];
+      Box iGhost(iBox);
+      iGhost.grow(a_ghost);
+      for (int j = 0; j < numBoxes; j++)
+        {
+          if (j == i) continue;
+          const LayoutIndex& dj = lit[j];
+          // a pair of created boxes is seen from both ends; take it from the lower one
+          if (j < i && !a_map.survived(dj)) continue;
+          const int jProcID = newGrids.procID(dj);
+          if (iProcID != myprocID && jProcID != myprocID) continue;
+          const Box& jBox = newGrids[dj];
+          if (isSorted && jBox.bigEnd(0) < iGhost.smallEnd(0)) continue;
+          if (isSorted && jBox.smallEnd(0) > iGhost.bigEnd(0)) break;
+          Box jGhost(jBox);
+          jGhost.grow(a_ghost);
+
+          // from j into the ghost cells of i, and from i into those of j
+          for (int dir = 0; dir < 2; dir++)
+            {
+              const LayoutIndex& fromdi = (dir == 0) ? dj : di;
+              const LayoutIndex& todi   = (dir == 0) ? di : dj;
+              const int fromProcID = (dir == 0) ? jProcID : iProcID;
+              const int toProcID   = (dir == 0) ? iProcID : jProcID;
+              Box region = (dir == 0) ? (jBox & iGhost) : (iBox & jGhost);
+              if (region.isEmpty()) continue;
+              MotionItem* item = new (s_motionItemPool.getPtr())
+                MotionItem(DataIndex(fromdi), DataIndex(todi), region);
+              if (fromProcID == myprocID && toProcID == myprocID)
+                {
+                  m_localMotionPlan.push_back(item);
+                }
+              else if (toProcID == myprocID)
+                {
+                  item->procID = fromProcID;
+                  m_toMotionPlan.push_back(item);
+                }
+              else if (fromProcID == myprocID)
+                {
+                  item->procID = toProcID;
+                  m_fromMotionPlan.push_back(item);
+                }
+              else
+                {
+                  s_motionItemPool.returnPtr(item);
+                }
+            }
+        }
+    }
+  sort();
+  defineCommunication();
 }
 
 class MotionItemSorter
@@ -0,0 +1,354 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include <algorithm>
+#include <utility>
+#include "ExchangeGroup.H"
+#include "MayDay.H"
+#include "CH_Timer.H"
+#include "memtrack.H"
+#include "parstream.H"
+#include "NamespaceHeader.H"
+
+// well clear of the tags used by BoxLayoutData messaging, so aggregated
+// messages never match an outstanding exchange of one of the members
+int ExchangeGroup::s_tag = 4096;
+
+// sending and receiving processors must order the pieces of a message the
+// same way: by member, then as CopierBuffer::bufEntry orders the items
+struct ExchangeGroupEntryLess
+{
+  template <class E>
+  bool operator()(const E& a, const E& b) const
+  {
+    if (a.procID != b.procID) return a.procID < b.procID;
+    if (a.member != b.member) return a.member < b.member;
+    const Box& left  = a.item->toRegion;
+    const Box& right = b.item->toRegion;
+    if (left.smallEnd() == right.smallEnd())
+      {
+        return left.bigEnd().lexLT(right.bigEnd());
+      }
+    return left < right;
+  }
+};
+
+// orders m_toMe indices by member and destination only
+struct ExchangeGroupDestLess
+{
+  template <class E>
+  ExchangeGroupDestLess(const std::vector<E>& a_entries)
+  {
+    for (unsigned int i = 0; i < a_entries.size(); i++)
+      {
+        m_keys.push_back(std::make_pair(a_entries[i].member,
+                                        a_entries[i].item->toIndex.intCode()));
+      }
+  }
+  bool operator()(int a, int b) const
+  {
+    return m_keys[a] < m_keys[b];
+  }
+  std::vector<std::pair<int,int> > m_keys;
+};
+
+ExchangeGroup::ExchangeGroup()
+  :m_isDefined(false),
+   m_threadSafe(true),
+   m_pending(false),
+   m_numMessages(0),
+   m_sendbuffer(NULL),
+   m_sendcapacity(0),
+   m_recbuffer(NULL),
+   m_reccapacity(0)
+{
+}
+
+ExchangeGroup::~ExchangeGroup()
+{
+  clear();
+}
+
+void ExchangeGroup::clear()
+{
+  if (m_pending)
+    {
+      exchangeEnd();
+    }
+  for (int i = 0; i < m_members.size(); i++)
+    {
+      delete m_members[i];
+    }
+  m_members.resize(0);
+  m_fromMe.resize(0);
+  m_toMe.resize(0);
+  m_sends.resize(0);
+  m_receives.resize(0);
+  m_unpackGroups.resize(0);
+  freeBuffers();
+  m_isDefined = false;
+}
+
+void ExchangeGroup::freeBuffers()
+{
+  if (m_sendbuffer != NULL) freeMT(m_sendbuffer);
+  if (m_recbuffer  != NULL) freeMT(m_recbuffer);
+  m_sendbuffer = NULL;
+  m_recbuffer  = NULL;
+  m_sendcapacity = 0;
+  m_reccapacity  = 0;
+}
+
+void ExchangeGroup::defineMessages()
+{
+  CH_TIME("ExchangeGroup::defineMessages");
+  m_fromMe.resize(0);
+  m_toMe.resize(0);
+  m_threadSafe = true;
+  for (int m = 0; m < m_members.size(); m++)
+    {
+      const ExchangeGroupMember& member = *m_members[m];
+      if (!member.aggregatable()) continue;
+      m_threadSafe = m_threadSafe && member.threadSafe();
+      for (CopyIterator it(member.copier(), CopyIterator::FROM); it.ok(); ++it)
+        {
+          Entry e;
+          e.member = m;
+          e.item   = &(it());
+          e.size   = member.sendSize(it());
+          e.procID = it().procID;
+          m_fromMe.push_back(e);
+        }
+      for (CopyIterator it(member.copier(), CopyIterator::TO); it.ok(); ++it)
+        {
+          Entry e;
+          e.member = m;
+          e.item   = &(it());
+          e.size   = member.recvSize(it());
+          e.procID = it().procID;
+          m_toMe.push_back(e);
+        }
+    }
+  std::sort(m_fromMe.begin(), m_fromMe.end(), ExchangeGroupEntryLess());
+  std::sort(m_toMe.begin(),   m_toMe.end(),   ExchangeGroupEntryLess());
+
+  size_t sendBufferSize = 0;
+  size_t recBufferSize  = 0;
+  for (unsigned int i = 0; i < m_fromMe.size(); i++) sendBufferSize += m_fromMe[i].size;
+  for (unsigned int i = 0; i < m_toMe.size();   i++) recBufferSize  += m_toMe[i].size;
+
+  if (sendBufferSize > m_sendcapacity)
+    {
+      if (m_sendbuffer != NULL) freeMT(m_sendbuffer);
+      m_sendbuffer = mallocMT(sendBufferSize);
+      if (m_sendbuffer == NULL)
+        {
+          MayDay::Error("Out of memory in ExchangeGroup::defineMessages");
+        }
+      m_sendcapacity = sendBufferSize;
+    }
+  if (recBufferSize > m_reccapacity)
+    {
+      if (m_recbuffer != NULL) freeMT(m_recbuffer);
+      m_recbuffer = mallocMT(recBufferSize);
+      if (m_recbuffer == NULL)
+        {
+          MayDay::Error("Out of memory in ExchangeGroup::defineMessages");
+        }
+      m_reccapacity = recBufferSize;
+    }
+
+  // lay the pieces out contiguously; since the entries are sorted by
+  // procID, each processor's pieces form one message
+  m_sends.resize(0);
+  char* nextFree = (char*)m_sendbuffer;
+  for (unsigned int i = 0; i < m_fromMe.size(); i++)
+    {
+      Entry& e = m_fromMe[i];
+      e.bufPtr = nextFree;
+      nextFree += e.size;
+      if (m_sends.size() == 0 || m_sends.back().procID != e.procID)
+        {
+          Message msg;
+          msg.procID = e.procID;
+          msg.bufPtr = e.bufPtr;
+          msg.size   = 0;
+          m_sends.push_back(msg);
+        }
+      m_sends.back().size += e.size;
+    }
+
+  m_receives.resize(0);
+  nextFree = (char*)m_recbuffer;
+  for (unsigned int i = 0; i < m_toMe.size(); i++)
+    {
+      Entry& e = m_toMe[i];
+      e.bufPtr = nextFree;
+      nextFree += e.size;
+      if (m_receives.size() == 0 || m_receives.back().procID != e.procID)
+        {
+          Message msg;
+          msg.procID = e.procID;
+          msg.bufPtr = e.bufPtr;
+          msg.size   = 0;
+          m_receives.push_back(msg);
+        }
+      m_receives.back().size += e.size;
+    }
+
+  // pieces for one destination are unpacked in order by one thread
+  std::vector<int> order(m_toMe.size());
+  for (unsigned int i = 0; i < order.size(); i++) order[i] = i;
+  ExchangeGroupDestLess destLess(m_toMe);
+  std::stable_sort(order.begin(), order.end(), destLess);
+  m_unpackGroups.resize(0);
+  for (unsigned int i = 0; i < order.size(); i++)
+    {
+      if (i == 0 || destLess(order[i-1], order[i]))
+        {
+          m_unpackGroups.push_back(std::vector<int>());
+        }
+      m_unpackGroups.back().push_back(order[i]);
+    }
+
+  m_isDefined = true;
+}
+
+void ExchangeGroup::exchange()
+{
+  exchangeBegin();
+  exchangeEnd();
+}
+
+void ExchangeGroup::exchangeBegin()
+{
+  CH_TIME("ExchangeGroup::exchangeBegin");
+  CH_assert(!m_pending);
+  if (!m_isDefined)
+    {
+      defineMessages();
+    }
+
+  for (int m = 0; m < m_members.size(); m++)
+    {
+      if (!m_members[m]->aggregatable()) m_members[m]->exchangeBegin();
+    }
+
+  m_numMessages = 0;
+#ifdef CH_MPI
+  {
+    CH_TIME("post_Receives");
+    m_receiveRequests.resize(0);
+    for (unsigned int i = 0; i < m_receives.size(); i++)
+      {
+        char*  buffer = m_receives[i].bufPtr;
+        size_t bsize  = m_receives[i].size;
+        int tag = s_tag;
+        while (bsize > CH_MAX_MPI_MESSAGE_SIZE)
+          {
+            m_receiveRequests.push_back(MPI_Request());
+            MPI_Irecv(buffer, CH_MAX_MPI_MESSAGE_SIZE, MPI_BYTE, m_receives[i].procID,
+                      tag, Chombo_MPI::comm, &(m_receiveRequests.back()));
+            bsize  -= CH_MAX_MPI_MESSAGE_SIZE;
+            buffer += CH_MAX_MPI_MESSAGE_SIZE;
+            tag++;
+          }
+        m_receiveRequests.push_back(MPI_Request());
+        MPI_Irecv(buffer, bsize, MPI_BYTE, m_receives[i].procID,
+                  tag, Chombo_MPI::comm, &(m_receiveRequests.back()));
+      }
+  }
+
+  {
+    CH_TIME("write Data to buffers");
+    int isize = m_fromMe.size();
+#pragma omp parallel for if(m_threadSafe)
+    for (int i = 0; i < isize; i++)
+      {
+        const Entry& e = m_fromMe[i];
+        m_members[e.member]->linearOut(e.bufPtr, *(e.item));
+      }
+  }
+
+  {
+    CH_TIME("post_Sends");
+    m_sendRequests.resize(0);
+    for (unsigned int i = 0; i < m_sends.size(); i++)
+      {
+        char*  buffer = m_sends[i].bufPtr;
+        size_t bsize  = m_sends[i].size;
+        int tag = s_tag;
+        while (bsize > CH_MAX_MPI_MESSAGE_SIZE)
+          {
+            m_sendRequests.push_back(MPI_Request());
+            MPI_Isend(buffer, CH_MAX_MPI_MESSAGE_SIZE, MPI_BYTE, m_sends[i].procID,
+                      tag, Chombo_MPI::comm, &(m_sendRequests.back()));
+            bsize  -= CH_MAX_MPI_MESSAGE_SIZE;
+            buffer += CH_MAX_MPI_MESSAGE_SIZE;
+            tag++;
+          }
+        m_sendRequests.push_back(MPI_Request());
+        MPI_Isend(buffer, bsize, MPI_BYTE, m_sends[i].procID,
+                  tag, Chombo_MPI::comm, &(m_sendRequests.back()));
+      }
+    m_numMessages = m_sendRequests.size();
+  }
+#endif
+
+  {
+    CH_TIME("local copying");
+    for (int m = 0; m < m_members.size(); m++)
+      {
+        if (m_members[m]->aggregatable()) m_members[m]->localCopy();
+      }
+  }
+  m_pending = true;
+}
+
+void ExchangeGroup::exchangeEnd()
+{
+  CH_TIME("ExchangeGroup::exchangeEnd");
+  CH_assert(m_pending);
+#ifdef CH_MPI
+  if (m_receiveRequests.size() > 0)
+    {
+      CH_TIME("MPI_Waitall");
+      MPI_Waitall(m_receiveRequests.size(), &(m_receiveRequests[0]), MPI_STATUSES_IGNORE);
+    }
+  {
+    CH_TIME("unpack_messages");
+    int ngroups = m_unpackGroups.size();
+#pragma omp parallel for schedule(dynamic) if(m_threadSafe)
+    for (int g = 0; g < ngroups; g++)
+      {
+        for (unsigned int i = 0; i < m_unpackGroups[g].size(); i++)
+          {
+            const Entry& e = m_toMe[m_unpackGroups[g][i]];
+            m_members[e.member]->linearIn(e.bufPtr, *(e.item));
+          }
+      }
+  }
+  if (m_sendRequests.size() > 0)
+    {
+      CH_TIME("MPI_Waitall");
+      MPI_Waitall(m_sendRequests.size(), &(m_sendRequests[0]), MPI_STATUSES_IGNORE);
+    }
+  m_receiveRequests.resize(0);
+  m_sendRequests.resize(0);
+#endif
+
+  for (int m = 0; m < m_members.size(); m++)
+    {
+      if (!m_members[m]->aggregatable()) m_members[m]->exchangeEnd();
+    }
+  m_pending = false;
+}
+
+#include "NamespaceFooter.H"
@@ -15,6 +15,7 @@
 long int IntVectSet::count = 0;
 long int IntVectSet::peakcount = 0;
 int      IntVectSet::s_maxDense = 6400000;
+bool     IntVectSet::s_useTiles = false;
 
 IntVectSet::~IntVectSet()
 {
@@ -24,22 +25,37 @@ IntVectSet::~IntVectSet()
 void IntVectSet::define()
 {
   m_ivs.clear();
+  m_tiles.clear();
   m_dense = DenseIntVectSet();
   m_isdense = true;
+  m_istiled = false;
 }
 
 void IntVectSet::define(const DenseIntVectSet& a_dense)
 {
   m_ivs.clear();
+  m_tiles.clear();
   m_dense = a_dense;
   m_isdense = true;
+  m_istiled = false;
 }
 
 void IntVectSet::define(const TreeIntVectSet& a_tree)
 {
   m_ivs = a_tree;
+  m_tiles.clear();
   m_dense = DenseIntVectSet();
   m_isdense = false;
+  m_istiled = false;
+}
+
+void IntVectSet::define(const TiledIntVectSet& a_tiles)
+{
+  m_ivs.clear();
+  m_tiles = a_tiles;
+  m_dense = DenseIntVectSet();
+  m_isdense = false;
+  m_istiled = true;
 }
 
 IntVectSet::IntVectSet(const DenseIntVectSet& a_dense)
@@ -54,6 +70,12 @@ IntVectSet::IntVectSet(const TreeIntVectSet& a_tree)
   define(a_tree);
 }
 
+IntVectSet::IntVectSet(const TiledIntVectSet& a_tiles)
+{
+  count++;
+  define(a_tiles);
+}
+
 IntVectSet::IntVectSet(const IntVect& iv_in)
 {
   count++;
@@ -78,16 +100,34 @@ IntVectSet::setMaxDense(const int& a_maxDense)
 {
   s_maxDense = a_maxDense;
 }
+
+void
+IntVectSet::setUseTiles(bool a_useTiles)
+{
+  s_useTiles = a_useTiles;
+}
+
 void IntVectSet::define(const Box& b)
 {
+  m_istiled = false;
   if (b.numPts() < s_maxDense)
     {
       m_ivs.clear();
+      m_tiles.clear();
       m_isdense = true;
       m_dense = DenseIntVectSet(b);
     }
+  else if (s_useTiles)
+    {
+      m_ivs.clear();
+      m_dense = DenseIntVectSet();
+      m_isdense = false;
+      m_istiled = true;
+      m_tiles.define(b);
+    }
   else
     {
+      m_tiles.clear();
       m_isdense = false;
       m_ivs.define(b);
     }
@@ -177,13 +217,18 @@ IntVectSet& IntVectSet::operator|=(const IntVect& iv)
         if (!m_dense.box().contains(iv))
         {
           convert();
-          m_ivs |= iv;
+          if (m_istiled) m_tiles |= iv;
+          else          m_ivs   |= iv;
         }
         else
         {
           m_dense |= iv;
         }
   }
+  else if (m_istiled)
+  {
+        m_tiles |= iv;
+  }
   else
   {
         m_ivs |= iv;
@@ -198,13 +243,18 @@ IntVectSet& IntVectSet::operator|=(const Box& b)
         if (!m_dense.box().contains(b))
         {
           convert();
-          m_ivs |= b;
+          if (m_istiled) m_tiles |= b;
+          else          m_ivs   |= b;
         }
         else
         {
           m_dense |= b;
         }
   }
+  else if (m_istiled)
+  {
+        m_tiles |= b;
+  }
   else
   {
         m_ivs |= b;
@@ -225,15 +275,11 @@ IntVectSet& IntVectSet::operator|=(const IntVectSet& ivs)
               m_dense |= ivs.m_dense;
               return *this;
             }
-          ivs.convert();
         }
-      convert();
-    }
-  else if (ivs.m_isdense)
-    {
-      ivs.convert();
     }
-  m_ivs |= ivs.m_ivs;
+  matchSparse(ivs);
+  if (m_istiled) m_tiles |= ivs.m_tiles;
+  else          m_ivs   |= ivs.m_ivs;
   return *this;
 }
 
@@ -266,17 +312,28 @@ IntVectSet& IntVectSet::operator-=(const IntVectSet& ivs)
       if (ivs.m_isdense) m_dense-=ivs.m_dense;
       else
         {
-          for (TreeIntVectSetIterator it(ivs.m_ivs); it.ok(); ++it) m_dense -= it();
+          for (IVSIterator it(ivs); it.ok(); ++it) m_dense -= it();
         }
     }
   else
     {
       if (ivs.m_isdense)
         {
-          for (DenseIntVectSetIterator it(ivs.m_dense);it.ok(); ++it) m_ivs -= it();
+          if (m_istiled)
+            {
+              for (DenseIntVectSetIterator it(ivs.m_dense);it.ok(); ++it) m_tiles -= it();
+            }
+          else
+            {
+              for (DenseIntVectSetIterator it(ivs.m_dense);it.ok(); ++it) m_ivs -= it();
+            }
         }
       else
-        m_ivs -= ivs.m_ivs;
+        {
+          matchSparse(ivs);
+          if (m_istiled) m_tiles -= ivs.m_tiles;
+          else          m_ivs   -= ivs.m_ivs;
+        }
     }
 
   return *this;
@@ -290,6 +347,8 @@ bool IntVectSet::operator==(const IntVectSet& a_lhs) const
     return m_dense == a_lhs.m_dense;
   }
   if (a_lhs.m_isdense) return false;
+  if (m_istiled != a_lhs.m_istiled) return false;
+  if (m_istiled) return m_tiles == a_lhs.m_tiles;
   return m_ivs == a_lhs.m_ivs;
 }
 
@@ -308,6 +367,14 @@ bool IntVectSet::operator<(const IntVectSet& a_ivs) const
   {
     if ( !a_ivs.m_isdense )
     {
+      if ( m_istiled != a_ivs.m_istiled )
+      {
+        return a_ivs.m_istiled;
+      }
+      if ( m_istiled )
+      {
+        return m_tiles < a_ivs.m_tiles;
+      }
       return m_ivs < a_ivs.m_ivs;
     } else
     {
@@ -319,6 +386,7 @@ bool IntVectSet::operator<(const IntVectSet& a_ivs) const
 int IntVectSet::linearSize() const
 {
   if (m_isdense) return m_dense.linearSize() + sizeof(int);
+  if (m_istiled) return m_tiles.linearSize() + sizeof(int);
   return m_ivs.linearSize() + sizeof(int);
 }
 
@@ -330,11 +398,19 @@ void IntVectSet::linearIn(const void* const inBuf)
   if (*b == 0)
   {
     m_isdense = true;
+    m_istiled = false;
     m_dense.linearIn(buf);
   }
+  else if (*b == 2)
+  {
+    m_isdense = false;
+    m_istiled = true;
+    m_tiles.linearIn(buf);
+  }
   else
   {
     m_isdense = false;
+    m_istiled = false;
     m_ivs.linearIn(buf);
   }
 }
@@ -348,6 +424,11 @@ void IntVectSet::linearOut(void* const a_outBuf) const
     *b=0;
     m_dense.linearOut(buf);
   }
+  else if (m_istiled)
+  {
+    *b=2;
+    m_tiles.linearOut(buf);
+  }
   else
   {
     *b=1;
@@ -357,15 +438,17 @@ void IntVectSet::linearOut(void* const a_outBuf) const
 
 IntVectSet& IntVectSet::operator-=(const IntVect& iv)
 {
-  if (m_isdense) m_dense -= iv;
-  else          m_ivs   -= iv;
+  if (m_isdense)      m_dense -= iv;
+  else if (m_istiled) m_tiles -= iv;
+  else               m_ivs   -= iv;
   return *this;
 }
 
 IntVectSet& IntVectSet::operator-=(const Box& b)
 {
-  if (m_isdense) m_dense -= b;
-  else          m_ivs   -= b;
+  if (m_isdense)      m_dense -= b;
+  else if (m_istiled) m_tiles -= b;
+  else               m_ivs   -= b;
   return *this;
 }
 
@@ -392,15 +475,17 @@ IntVectSet operator&(const Box& b, const IntVectSet& ivs)
 
 IntVectSet& IntVectSet::operator&=(const Box& b)
 {
-  if (m_isdense) m_dense &= b;
-  else          m_ivs   &= b;
+  if (m_isdense)      m_dense &= b;
+  else if (m_istiled) m_tiles &= b;
+  else               m_ivs   &= b;
   return *this;
 }
 
 IntVectSet& IntVectSet::operator&=(const ProblemDomain& d)
 {
-  if (m_isdense) m_dense &= d;
-  else          m_ivs   &= d;
+  if (m_isdense)      m_dense &= d;
+  else if (m_istiled) m_tiles &= d;
+  else               m_ivs   &= d;
   return *this;
 }
 
@@ -409,23 +494,21 @@ IntVectSet& IntVectSet::operator&=(const IntVectSet& ivs)
   if (!(minBox().intersects(ivs.minBox())))
     {
       m_ivs.clear();
+      m_tiles.clear();
       m_isdense = true;
+      m_istiled = false;
       m_dense = DenseIntVectSet();
       return *this;
     }
-  if (m_isdense)
+  if (m_isdense && ivs.m_isdense)
     {
-      if (ivs.m_isdense) m_dense&=ivs.m_dense;
-      else
-        {
-          convert();
-          m_ivs &= ivs.m_ivs;
-        }
+      m_dense&=ivs.m_dense;
     }
   else
     {
-      if (ivs.m_isdense) ivs.convert();
-        m_ivs &= ivs.m_ivs;
+      matchSparse(ivs);
+      if (m_istiled) m_tiles &= ivs.m_tiles;
+      else          m_ivs   &= ivs.m_ivs;
     }
 
   return *this;
@@ -440,42 +523,48 @@ IntVectSet grow(const IntVectSet& ivs, int igrow)
 
 void IntVectSet::grow(int igrow)
 {
-  if (m_isdense) m_dense.grow(igrow);
-  else          m_ivs.grow(igrow);
+  if (m_isdense)      m_dense.grow(igrow);
+  else if (m_istiled) m_tiles.grow(igrow);
+  else               m_ivs.grow(igrow);
   //  return *this;
 }
 
 void IntVectSet::nestingRegion(int radius, const Box& domain, int granularity)
 {
-  if (m_isdense) m_dense.nestingRegion(radius, domain);
-  else          m_ivs.nestingRegion(radius, domain, granularity);
+  if (m_isdense)      m_dense.nestingRegion(radius, domain);
+  else if (m_istiled) m_tiles.nestingRegion(radius, domain, granularity);
+  else               m_ivs.nestingRegion(radius, domain, granularity);
 }
 
 void IntVectSet::nestingRegion(int radius, const ProblemDomain& domain, int granularity)
 {
-  if (m_isdense) m_dense.nestingRegion(radius, domain);
-  else          m_ivs.nestingRegion(radius, domain, granularity);
+  if (m_isdense)      m_dense.nestingRegion(radius, domain);
+  else if (m_istiled) m_tiles.nestingRegion(radius, domain, granularity);
+  else               m_ivs.nestingRegion(radius, domain, granularity);
 }
 
 IntVectSet& IntVectSet::grow(int idir, int igrow)
 {
   CH_assert(idir >= 0);
   CH_assert(idir < SpaceDim);
-  if (m_isdense) m_dense.grow(idir, igrow);
-  else          m_ivs.grow(idir, igrow);
+  if (m_isdense)      m_dense.grow(idir, igrow);
+  else if (m_istiled) m_tiles.grow(idir, igrow);
+  else               m_ivs.grow(idir, igrow);
   return *this;
 }
 
 void IntVectSet::growHi()
 {
-  if (m_isdense) m_dense.growHi();
-  else          m_ivs.growHi();
+  if (m_isdense)      m_dense.growHi();
+  else if (m_istiled) m_tiles.growHi();
+  else               m_ivs.growHi();
 }
 
 void IntVectSet::growHi(const int a_dir)
 {
-  if (m_isdense) m_dense.growHi(a_dir);
-  else          m_ivs.growHi(a_dir);
+  if (m_isdense)      m_dense.growHi(a_dir);
+  else if (m_istiled) m_tiles.growHi(a_dir);
+  else               m_ivs.growHi(a_dir);
 }
 
 IntVectSet refine(const IntVectSet& ivs, int iref)
@@ -487,8 +576,9 @@ IntVectSet refine(const IntVectSet& ivs, int iref)
 
 IntVectSet& IntVectSet::refine(int iref)
 {
-  if (m_isdense) m_dense.refine(iref);
-  else          m_ivs.refine(iref);
+  if (m_isdense)      m_dense.refine(iref);
+  else if (m_istiled) m_tiles.refine(iref);
+  else               m_ivs.refine(iref);
   return *this;
 }
 
@@ -501,33 +591,37 @@ IntVectSet coarsen(const IntVectSet& ivs, int iref)
 
 IntVectSet& IntVectSet::coarsen(int iref)
 {
-  if (m_isdense) m_dense.coarsen(iref);
-  else          m_ivs.coarsen(iref);
+  if (m_isdense)      m_dense.coarsen(iref);
+  else if (m_istiled) m_tiles.coarsen(iref);
+  else               m_ivs.coarsen(iref);
   return *this;
 }
 
 void IntVectSet::shift(const IntVect& iv)
 {
-  if (m_isdense) m_dense.shift(iv);
-  else          m_ivs.shift(iv);
+  if (m_isdense)      m_dense.shift(iv);
+  else if (m_istiled) m_tiles.shift(iv);
+  else               m_ivs.shift(iv);
 }
 
 void IntVectSet::makeEmpty()
 {
-  if (m_isdense) m_dense = DenseIntVectSet();
-  else          m_ivs.clear();
+  if (m_isdense)      m_dense = DenseIntVectSet();
+  else if (m_istiled) m_tiles.clear();
+  else               m_ivs.clear();
 }
 
 void IntVectSet::makeEmptyBits()
 {
-  if (m_isdense) m_dense.makeEmptyBits();
-  else          m_ivs.clear();
+  if (m_isdense)      m_dense.makeEmptyBits();
+  else if (m_istiled) m_tiles.clear();
+  else               m_ivs.clear();
 }
 
 void IntVectSet::compact() const
 {
-  if (m_isdense) m_dense.compact();
-  else          m_ivs.compact();
+  if (m_isdense)      m_dense.compact();
+  else if (!m_istiled) m_ivs.compact();
 }
 
 IntVectSet IntVectSet::chop(int dir, int chop_pnt)
@@ -538,6 +632,12 @@ IntVectSet IntVectSet::chop(int dir, int chop_pnt)
         IntVectSet rtn(r);
         return rtn;
   }
+  else if (m_istiled)
+  {
+        TiledIntVectSet t = m_tiles.chop(dir, chop_pnt);
+        IntVectSet rtn(t);
+        return rtn;
+  }
   else
   {
         TreeIntVectSet t = m_ivs.chop(dir, chop_pnt);
@@ -549,18 +649,20 @@ IntVectSet IntVectSet::chop(int dir, int chop_pnt)
 
 void IntVectSet::chop(int dir, int chop_pnt, IntVectSet& a_hi)
 {
-  if (m_isdense)
+  if (m_isdense || m_istiled)
     a_hi = chop(dir, chop_pnt);
   else
     {
       m_ivs.chop(dir, chop_pnt, a_hi.m_ivs);
       a_hi.m_isdense = false;
+      a_hi.m_istiled = false;
     }
 
 }
 const Box& IntVectSet::minBox() const
 {
   if (m_isdense) return m_dense.mBox();
+  if (m_istiled) return m_tiles.minBox();
   m_ivs.recalcMinBox();
   return m_ivs.minBox();
 }
@@ -569,6 +671,8 @@ void IntVectSet::recalcMinBox() const
 {
    if (m_isdense)
      m_dense.recalcMinBox();
+   else if (m_istiled)
+     m_tiles.recalcMinBox();
    else
      m_ivs.recalcMinBox();
 }
@@ -576,24 +680,28 @@ void IntVectSet::recalcMinBox() const
 bool IntVectSet::isEmpty() const
 {
   if (m_isdense) return m_dense.isEmpty();
+  if (m_istiled) return m_tiles.isEmpty();
   return m_ivs.isEmpty();
 }
 
 int IntVectSet::numPts() const
 {
   if (m_isdense) return m_dense.numPts();
+  if (m_istiled) return m_tiles.numPts();
   return m_ivs.numPts();
 }
 
 bool IntVectSet::contains(const IntVect& iv) const
 {
   if (m_isdense) return m_dense[iv];
+  if (m_istiled) return m_tiles.contains(iv);
   return m_ivs.contains(iv);
 }
 
 bool IntVectSet::contains(const IntVectSet& ivs) const
 {
   if (&ivs == this) return true;
+  if (isTiled() && ivs.isTiled()) return m_tiles.contains(ivs.m_tiles);
   for (IVSIterator ivsit(ivs); ivsit.ok(); ++ivsit)
     {
       if (!contains(ivsit()))
@@ -606,12 +714,14 @@ bool IntVectSet::contains(const IntVectSet& ivs) const
 bool IntVectSet::contains(const Box& box) const
 {
   if (m_isdense) return m_dense.contains(box);
+  if (m_istiled) return m_tiles.contains(box);
   return m_ivs.contains(box);
 }
 
 Vector<Box> IntVectSet::boxes() const
 {
   if (m_isdense) return m_dense.createBoxes();
+  if (m_istiled) return m_tiles.createBoxes();
   return m_ivs.createBoxes();
 }
 
@@ -630,24 +740,80 @@ std::ostream& operator<<(std::ostream& os, const IntVectSet& ivs)
 void IntVectSet::convert() const
 {
   if (!m_isdense) return; //already converted
-  if (m_dense.isEmpty())
-  {
-    // do nothing
-  }
-  else if (m_dense.isFull())
+  convertTo(s_useTiles);
+}
+
+void IntVectSet::convertTo(bool a_tiled) const
+{
+  if (!m_isdense && m_istiled == a_tiled) return; //already converted
+  TreeIntVectSet&  tree  = (TreeIntVectSet&)m_ivs;
+  TiledIntVectSet& tiles = (TiledIntVectSet&)m_tiles;
+  if (m_isdense && !a_tiled)
     {
-      ((TreeIntVectSet&)m_ivs).define(m_dense.box());
+      if (m_dense.isEmpty())
+        {
+          // do nothing
+        }
+      else if (m_dense.isFull())
+        {
+          tree.define(m_dense.box());
+        }
+      else
+        {
+          DenseIntVectSetIterator it(m_dense);
+          for (it.begin(); it.ok(); ++it)
+            {
+              tree |= it();
+            }
+          m_ivs.compact();
+        }
     }
-  else
+  else if (m_isdense)
     {
-      DenseIntVectSetIterator it(m_dense);
-      for (it.begin(); it.ok(); ++it)
+      if (m_dense.isEmpty())
+        {
+          tiles.clear();
+        }
+      else if (m_dense.isFull())
+        {
+          tiles.define(m_dense.box());
+        }
+      else
         {
-          ((TreeIntVectSet&)m_ivs) |= it();
+          tiles.clear();
+          for (DenseIntVectSetIterator it(m_dense); it.ok(); ++it)
+            {
+              tiles |= it();
+            }
         }
-      m_ivs.compact();
+      (DenseIntVectSet&)m_dense = DenseIntVectSet();
+    }
+  else if (a_tiled)
+    {
+      tiles.clear();
+      Vector<Box> b = tree.createBoxes();
+      for (int i = 0; i < b.size(); ++i) tiles |= b[i];
+      tree.clear();
+    }
+  else
+    {
+      tree.clear();
+      Vector<Box> b = tiles.createBoxes();
+      for (int i = 0; i < b.size(); ++i) tree |= b[i];
+      tiles.clear();
     }
   (bool&)m_isdense = false;
+  (bool&)m_istiled = a_tiled;
+}
+
+void IntVectSet::matchSparse(const IntVectSet& a_ivs) const
+{
+  bool tiled;
+  if (!m_isdense)            tiled = m_istiled;
+  else if (!a_ivs.m_isdense) tiled = a_ivs.m_istiled;
+  else                       tiled = s_useTiles;
+  convertTo(tiled);
+  a_ivs.convertTo(tiled);
 }
 
 // if you are in this function, you better really
@@ -672,11 +838,18 @@ IVSIterator::IVSIterator(const IntVectSet& ivs)
 
 void IVSIterator::define(const IntVectSet& ivs)
 {
+  m_istiled = false;
   if (ivs.m_isdense)
     {
       m_isdense = true;
       m_dense.define(ivs.m_dense);
     }
+  else if (ivs.m_istiled)
+    {
+      m_isdense = false;
+      m_istiled = true;
+      m_tiled.define(ivs.m_tiles);
+    }
   else
     {
       m_isdense = false;
@@ -11,6 +11,7 @@
 #include <iostream>
 #include <list>
 #include <set>
+#include <map>
 using std::cout;
 
 #include "parstream.H"
@@ -21,6 +22,9 @@ using std::cout;
 #include "LoadBalance.H"
 #include "LayoutIterator.H"
 #include "CH_Timer.H"
+#include "ParmParse.H"
+#include <algorithm>
+#include <climits>
 
 // Write a text file per call to LoadBalance()
 //#define PRINT_EXTRA_LB_FILE
@@ -218,6 +222,13 @@ int LoadBalance(Vector<int>&             a_procAssignments,
                 const int                a_LBnumProc)
 {
   CH_TIME("LoadBalance:VectorBoxSimple");
+  int method = loadBalanceMethod();
+  if (method != KnapsackLoadBalance && a_boxes.size() == a_computeLoads.size())
+    {
+      return SFCLoadBalance(a_procAssignments, a_computeLoads, a_boxes,
+                            method, a_LBnumProc);
+    }
+
   // Phase 1  modified knapsack algorithm.  this one doesn't use
   // load sorting followed by round robin.  This one does bin packing
   // first by finding vector divisors, then does regular knapsack
@@ -899,6 +910,224 @@ int basicLoadBalance(Vector<int>& a_procAssignments, int a_numBoxes, int a_numPr
   return 0;
 }
       
+int incrementalLoadBalance(Vector<int>&       a_procAssignments,
+                           const Vector<Box>& a_boxes,
+                           const BoxLayout&   a_oldGrids,
+                           const int          a_LBnumProc)
+{
+  CH_TIME("incrementalLoadBalance");
+  std::map<Box, int> oldProcs;
+  for (LayoutIterator lit = a_oldGrids.layoutIterator(); lit.ok(); ++lit)
+    {
+      oldProcs[a_oldGrids[lit()]] = a_oldGrids.procID(lit());
+    }
+
+  const int numBoxes = a_boxes.size();
+  a_procAssignments.resize(numBoxes);
+  Vector<long long> loads(a_LBnumProc, 0);
+  std::vector<std::pair<long long, int> > created;
+  for (int i = 0; i < numBoxes; i++)
+    {
+      std::map<Box, int>::const_iterator it = oldProcs.find(a_boxes[i]);
+      if (it != oldProcs.end() && it->second < a_LBnumProc)
+        {
+          a_procAssignments[i] = it->second;
+          loads[it->second] += a_boxes[i].numPts();
+        }
+      else
+        {
+          created.push_back(std::make_pair(-(long long)a_boxes[i].numPts(), i));
+        }
+    }
+  if ((int)created.size() == numBoxes)
+    {
+      return LoadBalance(a_procAssignments, a_boxes, a_LBnumProc);
+    }
+
+  // largest first, ties in the order of a_boxes, so every processor
+  // makes the same choices
+  std::sort(created.begin(), created.end());
+  for (int n = 0; n < (int)created.size(); n++)
+    {
+      int iproc = 0;
+      for (int p = 1; p < a_LBnumProc; p++)
+        {
+          if (loads[p] < loads[iproc]) iproc = p;
+        }
+      a_procAssignments[created[n].second] = iproc;
+      loads[iproc] -= created[n].first;
+    }
+  return 0;
+}
+
+static int s_loadBalanceMethod = -1;
+
+void setLoadBalanceMethod(int a_method)
+{
+  CH_assert(a_method >= KnapsackLoadBalance && a_method <= HilbertLoadBalance);
+  s_loadBalanceMethod = a_method;
+}
+
+int loadBalanceMethod()
+{
+  if (s_loadBalanceMethod < 0)
+    {
+      s_loadBalanceMethod = KnapsackLoadBalance;
+      ParmParse pp("loadbalance");
+      std::string method;
+      if (pp.query("method", method))
+        {
+          if      (method == "knapsack") s_loadBalanceMethod = KnapsackLoadBalance;
+          else if (method == "morton")   s_loadBalanceMethod = MortonLoadBalance;
+          else if (method == "hilbert")  s_loadBalanceMethod = HilbertLoadBalance;
+          else MayDay::Error("loadbalance.method must be knapsack, morton or hilbert");
+        }
+    }
+  return s_loadBalanceMethod;
+}
+
+// Skilling's algorithm: turns the a_bits-bit coordinates a_x into the
+// "transposed" Hilbert index, whose bits interleaved give the index
+static void hilbertTranspose(unsigned int* a_x, int a_bits)
+{
+  const int n = SpaceDim;
+  unsigned int m = 1u << (a_bits-1);
+  for (unsigned int q = m; q > 1; q >>= 1)
+    {
+      unsigned int p = q - 1;
+      for (int i = 0; i < n; i++)
+        {
+          if (a_x[i] & q)
+            {
+              a_x[0] ^= p;
+            }
+          else
+            {
+              unsigned int t = (a_x[0] ^ a_x[i]) & p;
+              a_x[0] ^= t;
+              a_x[i] ^= t;
+            }
+        }
+    }
+  // Gray encode
+  for (int i = 1; i < n; i++) a_x[i] ^= a_x[i-1];
+  unsigned int t = 0;
+  for (unsigned int q = m; q > 1; q >>= 1)
+    {
+      if (a_x[n-1] & q) t ^= q - 1;
+    }
+  for (int i = 0; i < n; i++) a_x[i] ^= t;
+}
+
+// interleave the bits of a_x, most significant first
+static unsigned long long interleaveBits(const unsigned int* a_x, int a_bits)
+{
+  unsigned long long key = 0;
+  for (int b = a_bits-1; b >= 0; b--)
+    {
+      for (int i = 0; i < SpaceDim; i++)
+        {
+          key = (key << 1) | ((a_x[i] >> b) & 1);
+        }
+    }
+  return key;
+}
+
+int SFCLoadBalance(Vector<int>&             a_procAssignments,
+                   const Vector<long long>& a_computeLoads,
+                   const Vector<Box>&       a_boxes,
+                   int                      a_method,
+                   const int                a_LBnumProc)
+{
+  CH_TIME("SFCLoadBalance");
+  CH_assert(a_boxes.size() == a_computeLoads.size());
+  const int nboxes = a_boxes.size();
+  a_procAssignments.resize(0);
+  a_procAssignments.resize(nboxes, 0);
+  if (a_LBnumProc == 1 || nboxes <= 1)
+    {
+      return 0;
+    }
+
+  // positions along the curve are those of the box centers
+  IntVect lo = IntVect(D_DECL6(INT_MAX, INT_MAX, INT_MAX, INT_MAX, INT_MAX, INT_MAX));
+  IntVect hi = IntVect(D_DECL6(INT_MIN, INT_MIN, INT_MIN, INT_MIN, INT_MIN, INT_MIN));
+  Vector<IntVect> centers(nboxes);
+  for (int i = 0; i < nboxes; i++)
+    {
+      const Box& b = a_boxes[i];
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          // floor of the midpoint, without overflow
+          centers[i][idir] = b.smallEnd(idir) + (b.bigEnd(idir) - b.smallEnd(idir))/2;
+        }
+      lo.min(centers[i]);
+      hi.max(centers[i]);
+    }
+
+  // scale the centers down to at most maxBits bits each, so the keys fit in 64 bits
+  int maxBits = 64/SpaceDim;
+  if (maxBits > 31) maxBits = 31;
+  long long range = 1;
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      range = Max(range, (long long)hi[idir] - lo[idir] + 1);
+    }
+  int bits = 1;
+  while (bits < 62 && ((long long)1 << bits) < range) bits++;
+  int shift = Max(0, bits - maxBits);
+  bits -= shift;
+
+  std::vector<std::pair<unsigned long long, int> > keys(nboxes);
+#pragma omp parallel for
+  for (int i = 0; i < nboxes; i++)
+    {
+      unsigned int x[SpaceDim];
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          x[idir] = (unsigned int)(((long long)centers[i][idir] - lo[idir]) >> shift);
+        }
+      unsigned long long key;
+      if (a_method == HilbertLoadBalance)
+        {
+          hilbertTranspose(x, bits);
+          key = interleaveBits(x, bits);
+        }
+      else
+        {
+          key = interleaveBits(x, bits);
+        }
+      keys[i] = std::make_pair(key, i);
+    }
+  std::sort(keys.begin(), keys.end());
+
+  // cut the curve where the cumulative load crosses multiples of the
+  // average, moving to the next processor at most once per box and
+  // keeping at least one box for each processor still to be served
+  double totalLoad = 0;
+  for (int i = 0; i < nboxes; i++) totalLoad += a_computeLoads[i];
+  const double goal = totalLoad/a_LBnumProc;
+  double cumulative = 0;
+  int proc = 0;
+  int boxesOnProc = 0;
+  for (int k = 0; k < nboxes; k++)
+    {
+      int ibox = keys[k].second;
+      double load = a_computeLoads[ibox];
+      if (proc < a_LBnumProc-1 && boxesOnProc > 0 &&
+          (cumulative + 0.5*load > (proc+1)*goal ||
+           nboxes - k <= a_LBnumProc - 1 - proc))
+        {
+          proc++;
+          boxesOnProc = 0;
+        }
+      a_procAssignments[ibox] = proc;
+      boxesOnProc++;
+      cumulative += load;
+    }
+  return 0;
+}
+
 ////////////////////////////////////////////////////////////////
 //                utility functions                           //
 ////////////////////////////////////////////////////////////////
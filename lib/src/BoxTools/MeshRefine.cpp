@@ -10,6 +10,8 @@
 
 #include <fstream>
 #include <iostream>
+#include <algorithm>
+#include <map>
 
 #include "MeshRefine.H"
 #include "BoxIterator.H"
@@ -280,7 +282,7 @@ using std::endl;
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-MeshRefine::MeshRefine() : m_isDefined(false), m_granularity(1)
+MeshRefine::MeshRefine() : m_isDefined(false), m_granularity(1), m_clusterTileSize(0)
 {
 }
 
@@ -294,7 +296,8 @@ MeshRefine::MeshRefine(const Box& a_baseDomain,
                        const int a_blockFactor,
                        const int a_bufferSize,
                        const int a_maxBoxSize)
-  :m_granularity(1)
+  :m_granularity(1),
+   m_clusterTileSize(0)
 {
   ProblemDomain crseDom(a_baseDomain);
   define(crseDom, a_refRatios, a_fillRatio, a_blockFactor,
@@ -307,7 +310,8 @@ MeshRefine::MeshRefine(const ProblemDomain& a_baseDomain,
                        const int a_blockFactor,
                        const int a_bufferSize,
                        const int a_maxBoxSize)
-  :m_granularity(1)
+  :m_granularity(1),
+   m_clusterTileSize(0)
 {
   define(a_baseDomain, a_refRatios, a_fillRatio, a_blockFactor,
          a_bufferSize, a_maxBoxSize);
@@ -602,54 +606,62 @@ MeshRefine::regrid(Vector<Vector<Box> >&   a_newmeshes,
           for ( int lvl = TopLevel ; lvl >= a_baseLevel ; lvl-- )
           {
             // make a new mesh at the same level as the tags
-
-            const int dest_proc = uniqueProc(SerialTask::compute);
-
-            Vector<IntVectSet> all_tags;
-            gather(all_tags, modifiedTags[lvl], dest_proc);
-
-            if (procID() == dest_proc)
-              {
-                for (int i = 0; i < all_tags.size(); ++i)
-                  {
-                     modifiedTags[lvl] |= all_tags[i];
-                    //**FIXME -- revert to above line when IVS is fixed.
-                    //**The following works around a bug in IVS that appears if
-                    //**the above line is used.  This bug is observed when there
-                    //**is a coarsening of an IVS containing only IntVect::Zero
-                    //**followed by an IVS |= IVS.
-                   // for (IVSIterator ivsit(all_tags[i]); ivsit.ok(); ++ivsit)
-                   //   {
-                   //     modifiedTags[lvl] |= ivsit();
-                   //   }
-                    //**FIXME -- hopefully fixed (BVS 10/30/2015)
-                    // Regain memory used (BVS,NDK 6/30/2008)
-                    all_tags[i].makeEmpty();
-                  }
-              }
-
-            broadcast( modifiedTags[lvl] , dest_proc);
-
-            // Move this union _after_ the above gather/broadcast to
-            // reduce memory -- shouldn't have other effects. (BVS,NDK 6/30/2008)
-            // Union the meshes from the previous level with the tags on this
-            // level to guarantee that proper nesting is satisfied.  On the
-            // first iteration this is a no-op because \var{lvlboxes} is empty.
-            // [NOTE: for every iteration after the first, \var{lvlboxes} will
-            //        already be coarsened by \var{BlockFactor} so it will be
-            //        at the same refinement level as \var{tags[lvl]}, which
-            //        has also been coarsened]
-            // this is simple in the non-periodic case, more complicated
-            // in the periodic case
             ProblemDomain lvldomain = Domains[lvl]; // domain of this level
-            buildSupport(lvldomain, lvlboxes, modifiedTags[lvl]);
 
             // this is the maximum allowable box size at this resolution
             // which will result in satisfying the maxSize restriction when
             // everything is refined up to the new level
             const int maxBoxSizeLevel = m_maxSize/(m_level_blockfactors[lvl]*m_nRefVect[lvl]);
-            makeBoxes(lvlboxes, modifiedTags[lvl], m_pnds[lvl],
-                      lvldomain, maxBoxSizeLevel, totalBufferSize[lvl]);
+
+            if (m_clusterTileSize > 0 && numProc() > 1)
+              {
+                makeBoxesDistributed(lvlboxes, modifiedTags[lvl], m_pnds[lvl],
+                                     lvldomain, maxBoxSizeLevel, totalBufferSize[lvl]);
+              }
+            else
+              {
+                const int dest_proc = uniqueProc(SerialTask::compute);
+
+                Vector<IntVectSet> all_tags;
+                gather(all_tags, modifiedTags[lvl], dest_proc);
+
+                if (procID() == dest_proc)
+                  {
+                    for (int i = 0; i < all_tags.size(); ++i)
+                      {
+                         modifiedTags[lvl] |= all_tags[i];
+                        //**FIXME -- revert to above line when IVS is fixed.
+                        //**The following works around a bug in IVS that appears if
+                        //**the above line is used.  This bug is observed when there
+                        //**is a coarsening of an IVS containing only IntVect::Zero
+                        //**followed by an IVS |= IVS.
+                       // for (IVSIterator ivsit(all_tags[i]); ivsit.ok(); ++ivsit)
+                       //   {
+                       //     modifiedTags[lvl] |= ivsit();
+                       //   }
+                        //**FIXME -- hopefully fixed (BVS 10/30/2015)
+                        // Regain memory used (BVS,NDK 6/30/2008)
+                        all_tags[i].makeEmpty();
+                      }
+                  }
+
+                broadcast( modifiedTags[lvl] , dest_proc);
+
+                // Move this union _after_ the above gather/broadcast to
+                // reduce memory -- shouldn't have other effects. (BVS,NDK 6/30/2008)
+                // Union the meshes from the previous level with the tags on this
+                // level to guarantee that proper nesting is satisfied.  On the
+                // first iteration this is a no-op because \var{lvlboxes} is empty.
+                // [NOTE: for every iteration after the first, \var{lvlboxes} will
+                //        already be coarsened by \var{BlockFactor} so it will be
+                //        at the same refinement level as \var{tags[lvl]}, which
+                //        has also been coarsened]
+                // this is simple in the non-periodic case, more complicated
+                // in the periodic case
+                buildSupport(lvldomain, lvlboxes, modifiedTags[lvl]);
+                makeBoxes(lvlboxes, modifiedTags[lvl], m_pnds[lvl],
+                          lvldomain, maxBoxSizeLevel, totalBufferSize[lvl]);
+              }
             // After change to reduce memory, this may now be needed.
             // Previously, there were a_tags.makeEmpty() calls in BRMesh.cpp, and now,
             // if there are a few tags leftover here, they will get added onto the mix -- which is not
@@ -1198,4 +1210,212 @@ MeshRefine::restrictUnrefined(IntVectSet& a_ivs) const
     }
 }
 
+void MeshRefine::setDistributedClustering(int a_tileSize)
+{
+  CH_assert(a_tileSize >= 0);
+  m_clusterTileSize = a_tileSize;
+}
+
+void
+MeshRefine::makeLocalBoxes(Vector<Box>&         a_mesh,
+                           IntVectSet&          a_tags,
+                           const IntVectSet&    a_pnd,
+                           const ProblemDomain& a_domain,
+                           const int            a_maxSize,
+                           const int            a_totalBufferSize) const
+{
+  makeBoxes(a_mesh, a_tags, a_pnd, a_domain, a_maxSize, a_totalBufferSize);
+}
+
+// orders boxes by their extent in the directions other than m_dir,
+// then by their low end in m_dir, so boxes that could be joined in
+// m_dir are next to each other
+struct AbuttingBoxLess
+{
+  AbuttingBoxLess(int a_dir) : m_dir(a_dir)
+  {
+  }
+  bool operator()(const Box& a, const Box& b) const
+  {
+    for (int idir = 0; idir < SpaceDim; idir++)
+      {
+        if (idir == m_dir) continue;
+        if (a.smallEnd(idir) != b.smallEnd(idir)) return a.smallEnd(idir) < b.smallEnd(idir);
+        if (a.bigEnd(idir)   != b.bigEnd(idir))   return a.bigEnd(idir)   < b.bigEnd(idir);
+      }
+    return a.smallEnd(m_dir) < b.smallEnd(m_dir);
+  }
+  int m_dir;
+};
+
+// joins boxes that abut in some direction and have the same extent in
+// the others, as long as the result is no longer than a_maxSize
+static void mergeAbuttingBoxes(Vector<Box>& a_boxes, int a_maxSize)
+{
+  std::vector<Box>& boxes = a_boxes.stdVector();
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      std::sort(boxes.begin(), boxes.end(), AbuttingBoxLess(idir));
+      std::vector<Box> merged;
+      for (unsigned int i = 0; i < boxes.size(); i++)
+        {
+          if (merged.size() > 0)
+            {
+              Box& last = merged.back();
+              const Box& b = boxes[i];
+              bool join = (last.bigEnd(idir) + 1 == b.smallEnd(idir));
+              for (int jdir = 0; jdir < SpaceDim && join; jdir++)
+                {
+                  if (jdir == idir) continue;
+                  join = (last.smallEnd(jdir) == b.smallEnd(jdir) &&
+                          last.bigEnd(jdir)   == b.bigEnd(jdir));
+                }
+              if (join && (a_maxSize <= 0 ||
+                           b.bigEnd(idir) - last.smallEnd(idir) + 1 <= a_maxSize))
+                {
+                  last.minBox(b);
+                  continue;
+                }
+            }
+          merged.push_back(boxes[i]);
+        }
+      boxes.swap(merged);
+    }
+  std::sort(boxes.begin(), boxes.end());
+}
+
+#ifdef CH_MPI
+// index of the clustering tile that holds a_iv; tags that stray outside
+// the domain (e.g. from buffering) go to the nearest tile
+static long long tileIndex(const IntVect& a_iv, const Box& a_domainBox,
+                           int a_tile, const IntVect& a_ntiles)
+{
+  long long index = 0;
+  for (int idir = SpaceDim-1; idir >= 0; idir--)
+    {
+      int t = (a_iv[idir] - a_domainBox.smallEnd(idir))/a_tile;
+      if (a_iv[idir] < a_domainBox.smallEnd(idir)) t = 0;
+      t = Min(t, a_ntiles[idir] - 1);
+      index = index*a_ntiles[idir] + t;
+    }
+  CH_assert(index >= 0);
+  return index;
+}
+#endif
+
+void
+MeshRefine::makeBoxesDistributed(Vector<Box>&         a_lvlboxes,
+                                 IntVectSet&          a_tags,
+                                 const IntVectSet&    a_pnd,
+                                 const ProblemDomain& a_domain,
+                                 const int            a_maxSize,
+                                 const int            a_totalBufferSize)
+{
+  CH_TIME("MeshRefine::makeBoxesDistributed");
+#ifdef CH_MPI
+  const int nproc = numProc();
+  const int rank  = procID();
+
+  // each processor adds its share of the support of the finer level
+  Vector<Box> support;
+  for (int i = rank; i < a_lvlboxes.size(); i += nproc)
+    {
+      support.push_back(a_lvlboxes[i]);
+    }
+  buildSupport(a_domain, support, a_tags);
+
+  // tiles of the domain, dealt out to the processors in turn
+  const Box& domainBox = a_domain.domainBox();
+  const int tile = m_clusterTileSize;
+  IntVect ntiles;
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      ntiles[idir] = (domainBox.size(idir) + tile - 1)/tile;
+    }
+
+  // send each tag to the owner of its tile
+  const int ivBytes = linearSize(IntVect::Zero);
+  std::vector<std::vector<char> > sendTags(nproc);
+  {
+    CH_TIME("route_tags");
+    for (IVSIterator it(a_tags); it.ok(); ++it)
+      {
+        const IntVect& iv = it();
+        std::vector<char>& buf = sendTags[tileIndex(iv, domainBox, tile, ntiles) % nproc];
+        buf.resize(buf.size() + ivBytes);
+        linearOut(&(buf[buf.size() - ivBytes]), iv);
+      }
+    a_tags.makeEmpty();
+  }
+
+  std::vector<int> sendCounts(nproc), recvCounts(nproc);
+  std::vector<int> sendDispls(nproc, 0), recvDispls(nproc, 0);
+  for (int p = 0; p < nproc; p++) sendCounts[p] = sendTags[p].size();
+  MPI_Alltoall(&(sendCounts[0]), 1, MPI_INT, &(recvCounts[0]), 1, MPI_INT, Chombo_MPI::comm);
+  for (int p = 1; p < nproc; p++)
+    {
+      sendDispls[p] = sendDispls[p-1] + sendCounts[p-1];
+      recvDispls[p] = recvDispls[p-1] + recvCounts[p-1];
+    }
+  std::vector<char> sendBuf(sendDispls[nproc-1] + sendCounts[nproc-1] + 1);
+  std::vector<char> recvBuf(recvDispls[nproc-1] + recvCounts[nproc-1] + 1);
+  for (int p = 0; p < nproc; p++)
+    {
+      std::copy(sendTags[p].begin(), sendTags[p].end(), sendBuf.begin() + sendDispls[p]);
+      std::vector<char>().swap(sendTags[p]);
+    }
+  MPI_Alltoallv(&(sendBuf[0]), &(sendCounts[0]), &(sendDispls[0]), MPI_BYTE,
+                &(recvBuf[0]), &(recvCounts[0]), &(recvDispls[0]), MPI_BYTE,
+                Chombo_MPI::comm);
+  std::vector<char>().swap(sendBuf);
+
+  // cluster the tags of each of my tiles on its own, so boxes from
+  // different tiles (and processors) cannot overlap
+  std::map<long long, IntVectSet> tileTags;
+  const int nrecv = recvDispls[nproc-1] + recvCounts[nproc-1];
+  for (int i = 0; i < nrecv; i += ivBytes)
+    {
+      IntVect iv;
+      linearIn(iv, &(recvBuf[i]));
+      tileTags[tileIndex(iv, domainBox, tile, ntiles)] |= iv;
+    }
+  std::vector<char>().swap(recvBuf);
+
+  std::vector<Box> myBoxes;
+  {
+    CH_TIME("local_clustering");
+    for (std::map<long long, IntVectSet>::iterator it = tileTags.begin();
+         it != tileTags.end(); ++it)
+      {
+        Vector<Box> boxes;
+        makeLocalBoxes(boxes, it->second, a_pnd, a_domain, a_maxSize, a_totalBufferSize);
+        for (int i = 0; i < boxes.size(); i++) myBoxes.push_back(boxes[i]);
+        it->second.makeEmpty();
+      }
+  }
+
+  // every processor needs the whole new level
+  const int boxBytes = linearSize(Box());
+  int myBytes = myBoxes.size()*boxBytes;
+  std::vector<char> sendBoxes(myBytes + 1);
+  for (int i = 0; i < myBoxes.size(); i++) linearOut(&(sendBoxes[i*boxBytes]), myBoxes[i]);
+  std::vector<int> byteCounts(nproc), byteDispls(nproc, 0);
+  MPI_Allgather(&myBytes, 1, MPI_INT, &(byteCounts[0]), 1, MPI_INT, Chombo_MPI::comm);
+  for (int p = 1; p < nproc; p++) byteDispls[p] = byteDispls[p-1] + byteCounts[p-1];
+  int nboxes = (byteDispls[nproc-1] + byteCounts[nproc-1])/boxBytes;
+  std::vector<char> recvBoxes(nboxes*boxBytes + 1);
+  MPI_Allgatherv(&(sendBoxes[0]), myBytes, MPI_BYTE,
+                 &(recvBoxes[0]), &(byteCounts[0]), &(byteDispls[0]), MPI_BYTE,
+                 Chombo_MPI::comm);
+  a_lvlboxes.resize(nboxes);
+  for (int i = 0; i < nboxes; i++) linearIn(a_lvlboxes[i], &(recvBoxes[i*boxBytes]));
+
+  // fix up: undo the cuts at tile boundaries where the boxes line up
+  mergeAbuttingBoxes(a_lvlboxes, a_maxSize);
+#else
+  buildSupport(a_domain, a_lvlboxes, a_tags);
+  makeBoxes(a_lvlboxes, a_tags, a_pnd, a_domain, a_maxSize, a_totalBufferSize);
+#endif
+}
+
 #include "NamespaceFooter.H"
@@ -967,6 +967,7 @@ void ReductionCopier::define(const BoxLayout& a_level,
 
     } // end if we need to do anything for periodicity
   sort();
+  defineCommunication();
 }
 
 void ReductionCopier::reverse()
@@ -0,0 +1,114 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include <map>
+#include "RegridMap.H"
+#include "CH_Timer.H"
+#include "NamespaceHeader.H"
+
+RegridMap::RegridMap()
+  :m_isDefined(false),
+   m_numSurvived(0)
+{
+}
+
+RegridMap::RegridMap(const DisjointBoxLayout& a_oldGrids,
+                     const DisjointBoxLayout& a_newGrids)
+  :m_isDefined(false),
+   m_numSurvived(0)
+{
+  define(a_oldGrids, a_newGrids);
+}
+
+void RegridMap::define(const DisjointBoxLayout& a_oldGrids,
+                       const DisjointBoxLayout& a_newGrids)
+{
+  CH_TIME("RegridMap::define");
+  CH_assert(a_oldGrids.isClosed());
+  CH_assert(a_newGrids.isClosed());
+
+  m_oldGrids = a_oldGrids;
+  m_newGrids = a_newGrids;
+  m_oldLit = m_oldGrids.layoutIterator();
+  m_newLit = m_newGrids.layoutIterator();
+
+  const int numOld = m_oldGrids.size();
+  const int numNew = m_newGrids.size();
+  m_oldOfNew.assign(numNew, -1);
+  m_newOfOld.assign(numOld, -1);
+  m_createdOfNew.assign(numNew, -1);
+  m_numSurvived = 0;
+
+  // the boxes of a DisjointBoxLayout are disjoint, so a Box identifies a
+  // position in it
+  std::map<Box, int> oldPosition;
+  for (int i = 0; i < numOld; i++)
+    {
+      oldPosition[m_oldGrids[m_oldLit[i]]] = i;
+    }
+
+  Vector<Box> createdBoxes;
+  Vector<int> createdProcs;
+  for (int i = 0; i < numNew; i++)
+    {
+      const LayoutIndex& newIndex = m_newLit[i];
+      const Box& b = m_newGrids[newIndex];
+      std::map<Box, int>::const_iterator it = oldPosition.find(b);
+      if (it != oldPosition.end() &&
+          m_oldGrids.procID(m_oldLit[it->second]) == m_newGrids.procID(newIndex))
+        {
+          m_oldOfNew[i] = it->second;
+          m_newOfOld[it->second] = i;
+          m_numSurvived++;
+        }
+      else
+        {
+          createdBoxes.push_back(b);
+          createdProcs.push_back(m_newGrids.procID(newIndex));
+        }
+    }
+
+  m_createdGrids = DisjointBoxLayout(createdBoxes, createdProcs, m_newGrids.physDomain());
+  m_createdLit = m_createdGrids.layoutIterator();
+  std::map<Box, int> createdPosition;
+  for (int i = 0; i < m_createdGrids.size(); i++)
+    {
+      createdPosition[m_createdGrids[m_createdLit[i]]] = i;
+    }
+  for (int i = 0; i < numNew; i++)
+    {
+      if (m_oldOfNew[i] < 0)
+        {
+          m_createdOfNew[i] = createdPosition[m_newGrids[m_newLit[i]]];
+        }
+    }
+
+  m_isDefined = true;
+}
+
+DataIndex RegridMap::oldIndex(const LayoutIndex& a_newIndex) const
+{
+  CH_assert(survived(a_newIndex));
+  return DataIndex(m_oldLit[m_oldOfNew[a_newIndex.intCode()]]);
+}
+
+DataIndex RegridMap::newIndex(const LayoutIndex& a_oldIndex) const
+{
+  CH_assert(kept(a_oldIndex));
+  return DataIndex(m_newLit[m_newOfOld[a_oldIndex.intCode()]]);
+}
+
+DataIndex RegridMap::createdIndex(const LayoutIndex& a_newIndex) const
+{
+  CH_assert(!survived(a_newIndex));
+  return DataIndex(m_createdLit[m_createdOfNew[a_newIndex.intCode()]]);
+}
+
+#include "NamespaceFooter.H"
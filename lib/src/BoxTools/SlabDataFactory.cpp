@@ -0,0 +1,108 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include <cstdlib>
+#include "SlabDataFactory.H"
+#include "MayDay.H"
+#include "CH_Timer.H"
+#include "NamespaceHeader.H"
+
+FABSlab::FABSlab(size_t a_size, int a_refs)
+  :m_data(NULL),
+   m_size(a_size),
+   m_refs(a_refs)
+{
+  if (m_size > 0)
+    {
+      // the pages are left untouched, to be placed by whoever first writes them
+      void* data = NULL;
+      if (posix_memalign(&data, 64, m_size*sizeof(Real)) != 0 || data == NULL)
+        {
+          MayDay::Error("Out of memory in FABSlab");
+        }
+      m_data = (Real*)data;
+    }
+}
+
+FABSlab::~FABSlab()
+{
+  if (m_data != NULL) free(m_data);
+}
+
+void FABSlab::release()
+{
+  int refs;
+#pragma omp atomic capture
+  refs = --m_refs;
+  if (refs == 0)
+    {
+      delete this;
+    }
+}
+
+SlabDataFactory::SlabDataFactory(const DisjointBoxLayout& a_grids,
+                                 int                      a_ncomps,
+                                 const IntVect&           a_ghost)
+  :m_ncomps(a_ncomps)
+{
+  m_offsets.define(a_grids);
+  size_t size = 0;
+  DataIterator dit = a_grids.dataIterator();
+  for (dit.begin(); dit.ok(); ++dit)
+    {
+      m_offsets[dit] = size;
+      Box b = grow(a_grids[dit], a_ghost);
+      size += b.numPts()*a_ncomps;
+    }
+  // one reference per FAB, and one for the factory
+  m_slab = new FABSlab(size, dit.size() + 1);
+}
+
+SlabDataFactory::~SlabDataFactory()
+{
+  m_slab->release();
+}
+
+FArrayBox* SlabDataFactory::create(const Box& a_box, int a_ncomps, const DataIndex& a_datInd) const
+{
+  CH_assert(a_ncomps == m_ncomps);
+  return new SlabFArrayBox(a_box, a_ncomps, m_slab->dataPtr() + m_offsets[a_datInd], m_slab);
+}
+
+bool defineContiguous(LevelData<FArrayBox>&    a_data,
+                      const DisjointBoxLayout& a_grids,
+                      int                      a_ncomps,
+                      const IntVect&           a_ghost)
+{
+  CH_TIME("defineContiguous");
+  SlabDataFactory factory(a_grids, a_ncomps, a_ghost);
+  a_data.define(a_grids, a_ncomps, a_ghost, factory);
+  return true;
+}
+
+Real* contiguousData(const LevelData<FArrayBox>& a_data, size_t& a_size)
+{
+  a_size = 0;
+  DataIterator dit = a_data.dataIterator();
+  int nbox = dit.size();
+  if (nbox == 0) return NULL;
+  Real* start = const_cast<Real*>(a_data[dit[0]].dataPtr());
+  Real* next  = start;
+  for (int i = 0; i < nbox; i++)
+    {
+      const FArrayBox& fab = a_data[dit[i]];
+      if (fab.dataPtr() != next) return NULL;
+      next += fab.box().numPts()*fab.nComp();
+    }
+  a_size = next - start;
+  return start;
+}
+
+#include "NamespaceFooter.H"
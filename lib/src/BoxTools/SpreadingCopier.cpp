@@ -941,6 +941,7 @@ void SpreadingCopier::define(const BoxLayout& a_level,
       
     } // end if we need to do anything for periodicity
   sort();
+  defineCommunication();
 }
 
 void SpreadingCopier::reverse()
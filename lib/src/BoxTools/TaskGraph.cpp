@@ -0,0 +1,168 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include "TaskGraph.H"
+#include "CH_Timer.H"
+#include "CH_Thread.H"
+#include "NamespaceHeader.H"
+
+TaskGraph::TaskGraph(int a_numThreads)
+  :m_numDone(0),
+   m_stop(false)
+{
+  CH_assert(a_numThreads > 0);
+  for (int i = 1; i < a_numThreads; i++)
+    {
+      m_workers.push_back(std::thread(&TaskGraph::work, this));
+    }
+}
+
+TaskGraph::~TaskGraph()
+{
+  waitAll();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_changed.notify_all();
+  for (int i = 0; i < m_workers.size(); i++)
+    {
+      m_workers[i].join();
+    }
+}
+
+int TaskGraph::addTask(const Function&    a_function,
+                       const Vector<int>& a_after,
+                       bool               a_communicating)
+{
+  int task;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    task = m_tasks.size();
+    m_tasks.push_back(Task());
+    Task& t = m_tasks.back();
+    t.m_function = a_function;
+    t.m_waitingFor = 0;
+    t.m_communicating = a_communicating;
+    t.m_done = false;
+    for (int i = 0; i < a_after.size(); i++)
+      {
+        int after = a_after[i];
+        CH_assert(after < task);
+        if (after < 0 || m_tasks[after].m_done) continue;
+        m_tasks[after].m_next.push_back(task);
+        t.m_waitingFor++;
+      }
+    if (a_communicating)
+      {
+        m_communicating.push_back(task);
+      }
+    else if (t.m_waitingFor == 0)
+      {
+        m_ready.push_back(task);
+      }
+  }
+  m_changed.notify_all();
+  return task;
+}
+
+bool TaskGraph::runOne(std::unique_lock<std::mutex>& a_lock, bool a_communicating)
+{
+  int task = -1;
+  if (a_communicating && !m_communicating.empty() &&
+      m_tasks[m_communicating.front()].m_waitingFor == 0)
+    {
+      task = m_communicating.front();
+      m_communicating.pop_front();
+    }
+  else if (!m_ready.empty())
+    {
+      task = m_ready.front();
+      m_ready.pop_front();
+    }
+  if (task < 0) return false;
+
+  // the task does not move, and nobody else touches its function
+  Task& t = m_tasks[task];
+  a_lock.unlock();
+  t.m_function();
+  a_lock.lock();
+  t.m_function = Function();
+  finish(task);
+  return true;
+}
+
+void TaskGraph::finish(int a_task)
+{
+  Task& t = m_tasks[a_task];
+  t.m_done = true;
+  m_numDone++;
+  for (int i = 0; i < t.m_next.size(); i++)
+    {
+      Task& next = m_tasks[t.m_next[i]];
+      next.m_waitingFor--;
+      if (next.m_waitingFor == 0 && !next.m_communicating)
+        {
+          m_ready.push_back(t.m_next[i]);
+        }
+    }
+  m_changed.notify_all();
+}
+
+void TaskGraph::wait(int a_task)
+{
+  CH_TIME("TaskGraph::wait");
+  std::unique_lock<std::mutex> lock(m_mutex);
+  CH_assert(a_task < (int)m_tasks.size());
+  while (a_task >= 0 && !m_tasks[a_task].m_done)
+    {
+      if (!runOne(lock, true))
+        {
+          m_changed.wait(lock);
+        }
+    }
+}
+
+void TaskGraph::waitAll()
+{
+  CH_TIME("TaskGraph::waitAll");
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (m_numDone < (int)m_tasks.size())
+    {
+      if (!runOne(lock, true))
+        {
+          m_changed.wait(lock);
+        }
+    }
+  m_tasks.clear();
+  m_numDone = 0;
+}
+
+int TaskGraph::numTasks()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_tasks.size();
+}
+
+void TaskGraph::work()
+{
+  // the timers are not thread safe
+  setNotThread0();
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (!m_stop)
+    {
+      if (!runOne(lock, false))
+        {
+          m_changed.wait(lock);
+        }
+    }
+}
+
+#include "NamespaceFooter.H"
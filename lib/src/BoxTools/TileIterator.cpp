@@ -0,0 +1,97 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include "TileIterator.H"
+#include "DataIterator.H"
+#include "BoxIterator.H"
+#include "ParmParse.H"
+#include "NamespaceHeader.H"
+
+static bool    s_tileSizeSet = false;
+static IntVect s_defaultTileSize;
+
+void TileIterator::setDefaultTileSize(const IntVect& a_tileSize)
+{
+  s_defaultTileSize = a_tileSize;
+  s_tileSizeSet = true;
+}
+
+const IntVect& TileIterator::defaultTileSize()
+{
+  if (!s_tileSizeSet)
+    {
+      s_defaultTileSize = 16*IntVect::Unit;
+      s_defaultTileSize[0] = 1024;
+      ParmParse pp("tile");
+      if (pp.contains("size"))
+        {
+          Vector<int> size;
+          pp.getarr("size", size, 0, SpaceDim);
+          for (int idir = 0; idir < SpaceDim; idir++)
+            {
+              s_defaultTileSize[idir] = size[idir];
+            }
+        }
+      s_tileSizeSet = true;
+    }
+  return s_defaultTileSize;
+}
+
+TileIterator::TileIterator()
+  :m_tileSize(IntVect::Zero),
+   m_current(0)
+{
+}
+
+TileIterator::TileIterator(const BoxLayout& a_layout,
+                           const IntVect&   a_tileSize,
+                           const IntVect&   a_ghost)
+{
+  define(a_layout, a_tileSize, a_ghost);
+}
+
+void TileIterator::define(const BoxLayout& a_layout,
+                          const IntVect&   a_tileSize,
+                          const IntVect&   a_ghost)
+{
+  m_tileSize = a_tileSize;
+  m_tiles.resize(0);
+  m_indices.resize(0);
+  m_current = 0;
+
+  for (DataIterator dit = a_layout.dataIterator(); dit.ok(); ++dit)
+    {
+      const Box box = grow(a_layout[dit], a_ghost);
+      if (box.isEmpty()) continue;
+
+      // the tile with index i starts at box.smallEnd() + i*size
+      IntVect size;
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          size[idir] = (m_tileSize[idir] > 0) ? m_tileSize[idir] : box.size(idir);
+        }
+      IntVect numTiles;
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          numTiles[idir] = (box.size(idir) + size[idir] - 1)/size[idir];
+        }
+      Box tileIndices(IntVect::Zero, numTiles - IntVect::Unit);
+      for (BoxIterator bit(tileIndices); bit.ok(); ++bit)
+        {
+          IntVect lo = box.smallEnd() + bit()*size;
+          Box tile(lo, lo + size - IntVect::Unit, box.type());
+          tile &= box;
+          m_tiles.push_back(tile);
+          m_indices.push_back(dit());
+        }
+    }
+}
+
+#include "NamespaceFooter.H"
@@ -0,0 +1,998 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "TiledIntVectSet.H"
+#include "BoxIterator.H"
+#include "MayDay.H"
+#include "NamespaceHeader.H"
+
+const int TiledIntVectSet::NumRows;
+const int TiledIntVectSet::NumWords;
+
+// a_byte in every byte of a word
+static inline uint64_t byteMask(unsigned int a_byte)
+{
+  return a_byte*0x0101010101010101ULL;
+}
+
+// steps a_offset through the rows a_lo to a_hi of a tile; false at the end
+static inline bool nextRow(IntVect& a_offset, const IntVect& a_lo, const IntVect& a_hi)
+{
+  for (int idir = 1; idir < SpaceDim; idir++)
+    {
+      if (++a_offset[idir] <= a_hi[idir]) return true;
+      a_offset[idir] = a_lo[idir];
+    }
+  return false;
+}
+
+// orders boxes by their extent in the directions other than m_dir, then
+// by their low end in m_dir, so boxes that could be joined in m_dir are
+// next to each other
+struct TiledBoxLess
+{
+  TiledBoxLess(int a_dir) : m_dir(a_dir)
+  {
+  }
+  bool operator()(const Box& a, const Box& b) const
+  {
+    for (int idir = 0; idir < SpaceDim; idir++)
+      {
+        if (idir == m_dir) continue;
+        if (a.smallEnd(idir) != b.smallEnd(idir)) return a.smallEnd(idir) < b.smallEnd(idir);
+        if (a.bigEnd(idir)   != b.bigEnd(idir))   return a.bigEnd(idir)   < b.bigEnd(idir);
+      }
+    return a.smallEnd(m_dir) < b.smallEnd(m_dir);
+  }
+  int m_dir;
+};
+
+// joins boxes that abut in a direction and have the same extent in the others
+static void mergeBoxes(std::vector<Box>& a_boxes)
+{
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      std::sort(a_boxes.begin(), a_boxes.end(), TiledBoxLess(idir));
+      unsigned int n = 0;
+      for (unsigned int i = 0; i < a_boxes.size(); i++)
+        {
+          if (n > 0)
+            {
+              Box& last = a_boxes[n-1];
+              const Box& b = a_boxes[i];
+              bool join = (last.bigEnd(idir) + 1 == b.smallEnd(idir));
+              for (int jdir = 0; jdir < SpaceDim && join; jdir++)
+                {
+                  if (jdir == idir) continue;
+                  join = (last.smallEnd(jdir) == b.smallEnd(jdir) &&
+                          last.bigEnd(jdir)   == b.bigEnd(jdir));
+                }
+              if (join)
+                {
+                  last.setBig(idir, b.bigEnd(idir));
+                  continue;
+                }
+            }
+          a_boxes[n++] = a_boxes[i];
+        }
+      a_boxes.resize(n);
+    }
+}
+
+struct TiledKeyLess
+{
+  template <class P>
+  bool operator()(const P& a, const P& b) const
+  {
+    return a->first.lexLT(b->first);
+  }
+};
+
+TiledIntVectSet::TiledIntVectSet(const Box& a_box)
+  :m_minBoxValid(true)
+{
+  define(a_box);
+}
+
+void TiledIntVectSet::define(const Box& a_box)
+{
+  clear();
+  *this |= a_box;
+}
+
+void TiledIntVectSet::clear()
+{
+  m_tiles.clear();
+  m_minBox = Box();
+  m_minBoxValid = true;
+}
+
+TiledIntVectSet& TiledIntVectSet::operator|=(const IntVect& a_iv)
+{
+  IntVect key = tileKey(a_iv);
+  IntVect offset = a_iv - key*TileSize;
+  m_tiles[key].rows()[rowIndex(offset)] |= (unsigned char)(1 << offset[0]);
+  if (m_minBoxValid)
+    {
+      if (m_minBox.isEmpty()) m_minBox = Box(a_iv, a_iv);
+      else                    m_minBox.minBox(Box(a_iv, a_iv));
+    }
+  return *this;
+}
+
+TiledIntVectSet& TiledIntVectSet::operator-=(const IntVect& a_iv)
+{
+  IntVect key = tileKey(a_iv);
+  TileMap::iterator it = m_tiles.find(key);
+  if (it != m_tiles.end())
+    {
+      IntVect offset = a_iv - key*TileSize;
+      it->second.rows()[rowIndex(offset)] &= (unsigned char)~(1 << offset[0]);
+      if (it->second.isEmpty()) m_tiles.erase(it);
+      invalidate();
+    }
+  return *this;
+}
+
+TiledIntVectSet& TiledIntVectSet::operator|=(const Box& a_box)
+{
+  applyBox(a_box, 0);
+  return *this;
+}
+
+TiledIntVectSet& TiledIntVectSet::operator-=(const Box& a_box)
+{
+  applyBox(a_box, 1);
+  return *this;
+}
+
+// a_op 0 sets the cells of a_box, 1 clears them
+void TiledIntVectSet::applyBox(const Box& a_box, int a_op)
+{
+  if (a_box.isEmpty()) return;
+  if (a_op == 1 && isEmpty()) return;
+  invalidate();
+  Box keys(tileKey(a_box.smallEnd()), tileKey(a_box.bigEnd()));
+  for (BoxIterator kit(keys); kit.ok(); ++kit)
+    {
+      const IntVect& key = kit();
+      Box tb = tileBox(key);
+      Tile* tile;
+      if (a_op == 0)
+        {
+          tile = &(m_tiles[key]);
+        }
+      else
+        {
+          TileMap::iterator it = m_tiles.find(key);
+          if (it == m_tiles.end()) continue;
+          if (a_box.contains(tb))
+            {
+              m_tiles.erase(it);
+              continue;
+            }
+          tile = &(it->second);
+        }
+      unsigned char* rows = tile->rows();
+      if (a_op == 0 && a_box.contains(tb))
+        {
+          for (int r = 0; r < NumRows; r++) rows[r] = 0xFF;
+          continue;
+        }
+      tb &= a_box;
+      IntVect lo = tb.smallEnd() - key*TileSize;
+      IntVect hi = tb.bigEnd()   - key*TileSize;
+      unsigned char mask = rowMask(lo[0], hi[0]);
+      IntVect offset = lo;
+      do
+        {
+          if (a_op == 0) rows[rowIndex(offset)] |= mask;
+          else           rows[rowIndex(offset)] &= (unsigned char)~mask;
+        }
+      while (nextRow(offset, lo, hi));
+      if (a_op == 1 && tile->isEmpty()) m_tiles.erase(key);
+    }
+}
+
+TiledIntVectSet& TiledIntVectSet::operator&=(const Box& a_box)
+{
+  invalidate();
+  for (TileMap::iterator it = m_tiles.begin(); it != m_tiles.end();)
+    {
+      const IntVect& key = it->first;
+      Box tb = tileBox(key);
+      if (a_box.contains(tb))
+        {
+          ++it;
+          continue;
+        }
+      tb &= a_box;
+      if (tb.isEmpty())
+        {
+          it = m_tiles.erase(it);
+          continue;
+        }
+      IntVect lo = tb.smallEnd() - key*TileSize;
+      IntVect hi = tb.bigEnd()   - key*TileSize;
+      unsigned char mask = rowMask(lo[0], hi[0]);
+      unsigned char* rows = it->second.rows();
+      IntVect offset = IntVect::Zero;
+      for (int r = 0; r < NumRows; r++)
+        {
+          rowOffset(r, offset);
+          bool inside = true;
+          for (int idir = 1; idir < SpaceDim; idir++)
+            {
+              inside = inside && offset[idir] >= lo[idir] && offset[idir] <= hi[idir];
+            }
+          rows[r] = inside ? (rows[r] & mask) : 0;
+        }
+      if (it->second.isEmpty()) it = m_tiles.erase(it);
+      else                      ++it;
+    }
+  return *this;
+}
+
+TiledIntVectSet& TiledIntVectSet::operator&=(const ProblemDomain& a_domain)
+{
+  if (isEmpty()) return *this;
+  const Box& mb = minBox();
+  if (a_domain.domainBox().contains(mb)) return *this;
+
+  IntVect chopSml = a_domain.domainBox().smallEnd();
+  IntVect chopBig = a_domain.domainBox().bigEnd();
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      if (a_domain.isPeriodic(idir))
+        {
+          chopSml[idir] = std::min(chopSml[idir], mb.smallEnd(idir));
+          chopBig[idir] = std::max(chopBig[idir], mb.bigEnd(idir));
+        }
+    }
+  return *this &= Box(chopSml, chopBig);
+}
+
+TiledIntVectSet& TiledIntVectSet::operator|=(const TiledIntVectSet& a_ivs)
+{
+  if (&a_ivs == this) return *this;
+  for (TileMap::const_iterator it = a_ivs.m_tiles.begin(); it != a_ivs.m_tiles.end(); ++it)
+    {
+      Tile& tile = m_tiles[it->first];
+      for (int i = 0; i < NumWords; i++) tile.w[i] |= it->second.w[i];
+    }
+  if (m_minBoxValid && a_ivs.m_minBoxValid)
+    {
+      if (m_minBox.isEmpty()) m_minBox = a_ivs.m_minBox;
+      else if (!a_ivs.m_minBox.isEmpty()) m_minBox.minBox(a_ivs.m_minBox);
+    }
+  else
+    {
+      invalidate();
+    }
+  return *this;
+}
+
+TiledIntVectSet& TiledIntVectSet::operator-=(const TiledIntVectSet& a_ivs)
+{
+  if (&a_ivs == this)
+    {
+      clear();
+      return *this;
+    }
+  invalidate();
+  for (TileMap::const_iterator it = a_ivs.m_tiles.begin(); it != a_ivs.m_tiles.end(); ++it)
+    {
+      TileMap::iterator mine = m_tiles.find(it->first);
+      if (mine == m_tiles.end()) continue;
+      Tile& tile = mine->second;
+      for (int i = 0; i < NumWords; i++) tile.w[i] &= ~(it->second.w[i]);
+      if (tile.isEmpty()) m_tiles.erase(mine);
+    }
+  return *this;
+}
+
+TiledIntVectSet& TiledIntVectSet::operator&=(const TiledIntVectSet& a_ivs)
+{
+  if (&a_ivs == this) return *this;
+  invalidate();
+  for (TileMap::iterator it = m_tiles.begin(); it != m_tiles.end();)
+    {
+      TileMap::const_iterator other = a_ivs.m_tiles.find(it->first);
+      if (other == a_ivs.m_tiles.end())
+        {
+          it = m_tiles.erase(it);
+          continue;
+        }
+      Tile& tile = it->second;
+      for (int i = 0; i < NumWords; i++) tile.w[i] &= other->second.w[i];
+      if (tile.isEmpty()) it = m_tiles.erase(it);
+      else                ++it;
+    }
+  return *this;
+}
+
+bool TiledIntVectSet::contains(const IntVect& a_iv) const
+{
+  IntVect key = tileKey(a_iv);
+  TileMap::const_iterator it = m_tiles.find(key);
+  if (it == m_tiles.end()) return false;
+  IntVect offset = a_iv - key*TileSize;
+  return (it->second.rows()[rowIndex(offset)] >> offset[0]) & 1;
+}
+
+bool TiledIntVectSet::contains(const Box& a_box) const
+{
+  if (a_box.isEmpty()) return true;
+  Box keys(tileKey(a_box.smallEnd()), tileKey(a_box.bigEnd()));
+  for (BoxIterator kit(keys); kit.ok(); ++kit)
+    {
+      const IntVect& key = kit();
+      TileMap::const_iterator it = m_tiles.find(key);
+      if (it == m_tiles.end()) return false;
+      Box tb = tileBox(key) & a_box;
+      IntVect lo = tb.smallEnd() - key*TileSize;
+      IntVect hi = tb.bigEnd()   - key*TileSize;
+      unsigned char mask = rowMask(lo[0], hi[0]);
+      const unsigned char* rows = it->second.rows();
+      IntVect offset = lo;
+      do
+        {
+          if ((rows[rowIndex(offset)] & mask) != mask) return false;
+        }
+      while (nextRow(offset, lo, hi));
+    }
+  return true;
+}
+
+bool TiledIntVectSet::contains(const TiledIntVectSet& a_ivs) const
+{
+  for (TileMap::const_iterator it = a_ivs.m_tiles.begin(); it != a_ivs.m_tiles.end(); ++it)
+    {
+      TileMap::const_iterator mine = m_tiles.find(it->first);
+      if (mine == m_tiles.end()) return false;
+      for (int i = 0; i < NumWords; i++)
+        {
+          if ((it->second.w[i] & ~(mine->second.w[i])) != 0) return false;
+        }
+    }
+  return true;
+}
+
+// ORs a_in, shifted by a_shift (|a_shift| < TileSize) in a_dir, into a_out;
+// what leaves the tile is dropped
+void TiledIntVectSet::orShifted(Tile& a_out, const Tile& a_in, int a_dir, int a_shift)
+{
+  if (a_shift >= TileSize || a_shift <= -TileSize) return;
+  if (a_dir == 0)
+    {
+      // rows are bytes: shift the words and mask off what crossed a byte
+      if (a_shift > 0)
+        {
+          uint64_t mask = byteMask((0xFF << a_shift) & 0xFF);
+          for (int i = 0; i < NumWords; i++) a_out.w[i] |= (a_in.w[i] << a_shift) & mask;
+        }
+      else if (a_shift < 0)
+        {
+          uint64_t mask = byteMask(0xFF >> -a_shift);
+          for (int i = 0; i < NumWords; i++) a_out.w[i] |= (a_in.w[i] >> -a_shift) & mask;
+        }
+      else
+        {
+          for (int i = 0; i < NumWords; i++) a_out.w[i] |= a_in.w[i];
+        }
+    }
+  else
+    {
+      // move whole rows: stride rows per step in a_dir
+      int stride = 1;
+      for (int idir = 1; idir < a_dir; idir++) stride *= TileSize;
+      const int block = stride*TileSize;
+      const int jlo = std::max(0, -a_shift);
+      const int jhi = std::min((int)TileSize, TileSize - a_shift);
+      const unsigned char* src = a_in.rows();
+      unsigned char*       dst = a_out.rows();
+      for (int c = 0; c < NumRows; c += block)
+        {
+          for (int j = jlo; j < jhi; j++)
+            {
+              const unsigned char* from = src + c + j*stride;
+              unsigned char*       to   = dst + c + (j + a_shift)*stride;
+              for (int a = 0; a < stride; a++) to[a] |= from[a];
+            }
+        }
+    }
+}
+
+void TiledIntVectSet::shift(int a_dir, int a_shift)
+{
+  if (a_shift == 0 || isEmpty()) return;
+  const int q = tileIndex(a_shift);
+  const int r = a_shift - q*TileSize;
+  TileMap shifted;
+  shifted.reserve(m_tiles.size());
+  for (TileMap::const_iterator it = m_tiles.begin(); it != m_tiles.end(); ++it)
+    {
+      IntVect key = it->first;
+      key[a_dir] += q;
+      if (r == 0)
+        {
+          shifted[key] = it->second;
+          continue;
+        }
+      Tile lo, hi;
+      orShifted(lo, it->second, a_dir, r);
+      orShifted(hi, it->second, a_dir, r - TileSize);
+      if (!lo.isEmpty()) orShifted(shifted[key], lo, 0, 0);
+      key[a_dir] += 1;
+      if (!hi.isEmpty()) orShifted(shifted[key], hi, 0, 0);
+    }
+  m_tiles.swap(shifted);
+}
+
+void TiledIntVectSet::shift(const IntVect& a_iv)
+{
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      shift(idir, a_iv[idir]);
+    }
+  if (m_minBoxValid && !m_minBox.isEmpty()) m_minBox.shift(a_iv);
+}
+
+// adds every cell within a_radius in a_dir of a cell of the set
+void TiledIntVectSet::dilate(int a_dir, int a_radius)
+{
+  while (a_radius > 0 && !isEmpty())
+    {
+      const int m = std::min(a_radius, (int)TileSize-1);
+      a_radius -= m;
+      TileMap grown(m_tiles);
+      for (TileMap::const_iterator it = m_tiles.begin(); it != m_tiles.end(); ++it)
+        {
+          const Tile& tile = it->second;
+          Tile center, up, down;
+          for (int s = 1; s <= m; s++)
+            {
+              orShifted(center, tile, a_dir,  s);
+              orShifted(center, tile, a_dir, -s);
+              orShifted(up,     tile, a_dir,  s - TileSize);
+              orShifted(down,   tile, a_dir,  TileSize - s);
+            }
+          IntVect key = it->first;
+          orShifted(grown[key], center, 0, 0);
+          if (!up.isEmpty())
+            {
+              key[a_dir] += 1;
+              orShifted(grown[key], up, 0, 0);
+              key[a_dir] -= 1;
+            }
+          if (!down.isEmpty())
+            {
+              key[a_dir] -= 1;
+              orShifted(grown[key], down, 0, 0);
+            }
+        }
+      m_tiles.swap(grown);
+    }
+}
+
+void TiledIntVectSet::grow(int a_igrow)
+{
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      grow(idir, a_igrow);
+    }
+}
+
+void TiledIntVectSet::grow(int a_idir, int a_igrow)
+{
+  CH_assert(a_idir >= 0);
+  CH_assert(a_idir < SpaceDim);
+  if (a_igrow == 0) return;
+  invalidate();
+  if (a_igrow > 0)
+    {
+      dilate(a_idir, a_igrow);
+    }
+  else
+    {
+      // same as DenseIntVectSet::grow(int, int)
+      TiledIntVectSet plus(*this);
+      TiledIntVectSet minus(*this);
+      plus.shift(a_idir, a_igrow);
+      minus.shift(a_idir, -a_igrow);
+      *this &= plus;
+      *this &= minus;
+    }
+}
+
+void TiledIntVectSet::growHi()
+{
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      growHi(idir);
+    }
+}
+
+void TiledIntVectSet::growHi(int a_dir)
+{
+  TiledIntVectSet shifted(*this);
+  shifted.shift(a_dir, 1);
+  *this |= shifted;
+  invalidate();
+}
+
+void TiledIntVectSet::refine(int a_iref)
+{
+  CH_assert(a_iref >= 1);
+  if (a_iref == 1 || isEmpty()) return;
+  invalidate();
+
+  // bit f of lut[t*256 + b] is bit (t*TileSize + f)/a_iref of b: row b of
+  // a coarse tile, expanded into the t-th of the a_iref fine rows covering it
+  std::vector<unsigned char> lut(a_iref*256);
+  for (int t = 0; t < a_iref; t++)
+    {
+      for (int b = 0; b < 256; b++)
+        {
+          unsigned char out = 0;
+          for (int f = 0; f < TileSize; f++)
+            {
+              if ((b >> ((t*TileSize + f)/a_iref)) & 1) out |= (unsigned char)(1 << f);
+            }
+          lut[t*256 + b] = out;
+        }
+    }
+
+  // each coarse tile becomes a_iref^SpaceDim fine tiles
+  Box fineTiles(IntVect::Zero, (a_iref-1)*IntVect::Unit);
+  TileMap refined;
+  refined.reserve(m_tiles.size()*fineTiles.numPts());
+  IntVect fineOffset = IntVect::Zero;
+  IntVect crseOffset = IntVect::Zero;
+  for (TileMap::const_iterator it = m_tiles.begin(); it != m_tiles.end(); ++it)
+    {
+      const unsigned char* crse = it->second.rows();
+      for (BoxIterator bit(fineTiles); bit.ok(); ++bit)
+        {
+          const IntVect& t = bit();
+          Tile fine;
+          unsigned char* rows = fine.rows();
+          const unsigned char* row_lut = &(lut[t[0]*256]);
+          for (int r = 0; r < NumRows; r++)
+            {
+              rowOffset(r, fineOffset);
+              for (int idir = 1; idir < SpaceDim; idir++)
+                {
+                  crseOffset[idir] = (t[idir]*TileSize + fineOffset[idir])/a_iref;
+                }
+              rows[r] = row_lut[crse[rowIndex(crseOffset)]];
+            }
+          if (!fine.isEmpty()) refined[it->first*a_iref + t] = fine;
+        }
+    }
+  m_tiles.swap(refined);
+}
+
+void TiledIntVectSet::coarsen(int a_iref)
+{
+  CH_assert(a_iref >= 1);
+  if (a_iref == 1 || isEmpty()) return;
+  invalidate();
+  TileMap coarsened;
+  if (TileSize % a_iref != 0)
+    {
+      for (TiledIntVectSetIterator it(*this); it.ok(); ++it)
+        {
+          IntVect iv = it();
+          iv.coarsen(a_iref);
+          IntVect key = tileKey(iv);
+          IntVect offset = iv - key*TileSize;
+          coarsened[key].rows()[rowIndex(offset)] |= (unsigned char)(1 << offset[0]);
+        }
+      m_tiles.swap(coarsened);
+      return;
+    }
+
+  // bit i of lut[b] is set if any of bits i*a_iref to (i+1)*a_iref-1 of b is
+  const int groupMask = (1 << a_iref) - 1;
+  unsigned char lut[256];
+  for (int b = 0; b < 256; b++)
+    {
+      lut[b] = 0;
+      for (int i = 0; i < TileSize/a_iref; i++)
+        {
+          if ((b >> (i*a_iref)) & groupMask) lut[b] |= (unsigned char)(1 << i);
+        }
+    }
+
+  // a fine tile lands in a block of one coarse tile
+  IntVect fineOffset = IntVect::Zero;
+  IntVect crseOffset = IntVect::Zero;
+  for (TileMap::const_iterator it = m_tiles.begin(); it != m_tiles.end(); ++it)
+    {
+      IntVect origin = it->first*(TileSize/a_iref);
+      IntVect key = tileKey(origin);
+      origin -= key*TileSize;
+      Tile& crse = coarsened[key];
+      unsigned char* rows = crse.rows();
+      const unsigned char* fine = it->second.rows();
+      for (int r = 0; r < NumRows; r++)
+        {
+          if (fine[r] == 0) continue;
+          rowOffset(r, fineOffset);
+          for (int idir = 1; idir < SpaceDim; idir++)
+            {
+              crseOffset[idir] = origin[idir] + fineOffset[idir]/a_iref;
+            }
+          rows[rowIndex(crseOffset)] |= (unsigned char)(lut[fine[r]] << origin[0]);
+        }
+    }
+  m_tiles.swap(coarsened);
+}
+
+TiledIntVectSet TiledIntVectSet::chop(int a_dir, int a_chopPnt)
+{
+  TiledIntVectSet rtn;
+  if (isEmpty()) return rtn;
+  const Box& mb = minBox();
+  if (mb.smallEnd(a_dir) >= a_chopPnt)
+    {
+      rtn.m_tiles.swap(m_tiles);
+      rtn.m_minBox = m_minBox;
+      clear();
+      return rtn;
+    }
+  if (mb.bigEnd(a_dir) < a_chopPnt)
+    {
+      return rtn;
+    }
+  Box hi = mb;
+  hi.setSmall(a_dir, a_chopPnt);
+  rtn = *this;
+  rtn &= hi;
+  *this -= hi;
+  return rtn;
+}
+
+// keeps the coarse cells whose every fine cell is in the set
+void TiledIntVectSet::trimCoarsen(int a_iref)
+{
+  TiledIntVectSet crse(*this);
+  crse.coarsen(a_iref);
+  TiledIntVectSet missing(crse);
+  missing.refine(a_iref);
+  missing -= *this;
+  missing.coarsen(a_iref);
+  crse -= missing;
+  *this = crse;
+}
+
+// a_images is a superset of this set; removes every IntVect of the set
+// within a_radius of a cell of a_region that is not in a_images.
+// Erosion by a box is done as erosions by a segment in each direction in
+// turn, counting cells beyond a_region in that direction as present.
+void TiledIntVectSet::erode(int a_radius, const Box& a_region, const TiledIntVectSet& a_images)
+{
+  TiledIntVectSet eroded(a_images);
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      TiledIntVectSet current(eroded);
+      const Box& mb = current.minBox();
+      for (int s = -a_radius; s <= a_radius; s++)
+        {
+          if (s == 0) continue;
+          TiledIntVectSet neighbors(current);
+          neighbors.shift(idir, -s);
+          // cells whose neighbor s away is beyond the region
+          int lo = mb.smallEnd(idir);
+          int hi = mb.bigEnd(idir);
+          if (s > 0) lo = std::max(lo, a_region.bigEnd(idir) - s + 1);
+          else       hi = std::min(hi, a_region.smallEnd(idir) - s - 1);
+          TiledIntVectSet edge;
+          if (lo <= hi)
+            {
+              Box beyond = mb;
+              beyond.setRange(idir, lo, hi - lo + 1);
+              edge = eroded;
+              edge &= beyond;
+            }
+          eroded &= neighbors;
+          eroded |= edge;
+        }
+    }
+  *this &= eroded;
+}
+
+void TiledIntVectSet::nestingRegion(int a_radius, const Box& a_domain, int a_granularity)
+{
+  CH_assert(a_radius >= 0);
+  if (a_radius == 0 || isEmpty()) return;
+
+  Box domain = a_domain;
+  int radius = a_radius;
+  if (a_granularity != 1)
+    {
+      radius = (a_radius + a_granularity - 1)/a_granularity;
+      trimCoarsen(a_granularity);
+      domain.coarsen(a_granularity);
+    }
+
+  TiledIntVectSet images(*this);
+  erode(radius, domain, images);
+
+  if (a_granularity != 1)
+    {
+      refine(a_granularity);
+    }
+}
+
+void TiledIntVectSet::nestingRegion(int a_radius, const ProblemDomain& a_domain, int a_granularity)
+{
+  CH_assert(a_radius >= 0);
+  if (a_radius == 0 || isEmpty()) return;
+
+  ProblemDomain domain = a_domain;
+  int radius = a_radius;
+  if (a_granularity != 1)
+    {
+      radius = (a_radius + a_granularity - 1)/a_granularity;
+      trimCoarsen(a_granularity);
+      domain.coarsen(a_granularity);
+    }
+  const Box& domainBox = domain.domainBox();
+
+  // periodic images within radius of the domain count as in the set
+  TiledIntVectSet images(*this);
+  Box region = domainBox;
+  if (domain.isPeriodic())
+    {
+      Box interior = domainBox;
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          if (domain.isPeriodic(idir))
+            {
+              region.grow(idir, radius);
+              interior.grow(idir, -radius);
+            }
+        }
+      TiledIntVectSet nearBoundary(*this);
+      nearBoundary -= interior;
+      IntVect shiftMult(domainBox.size());
+      for (ShiftIterator shiftIt = domain.shiftIterator(); shiftIt.ok(); ++shiftIt)
+        {
+          TiledIntVectSet image(nearBoundary);
+          image.shift(shiftMult*shiftIt());
+          image &= region;
+          images |= image;
+        }
+    }
+  erode(radius, region, images);
+
+  if (a_granularity != 1)
+    {
+      refine(a_granularity);
+    }
+}
+
+int TiledIntVectSet::numPts() const
+{
+  long long n = 0;
+  for (TileMap::const_iterator it = m_tiles.begin(); it != m_tiles.end(); ++it)
+    {
+      for (int i = 0; i < NumWords; i++) n += __builtin_popcountll(it->second.w[i]);
+    }
+  return n;
+}
+
+// the minimum box of one tile
+void TiledIntVectSet::boxOfTile(const IntVect& a_key, const Tile& a_tile, Box& a_box)
+{
+  const unsigned char* rows = a_tile.rows();
+  IntVect lo =  TileSize*IntVect::Unit;
+  IntVect hi = -IntVect::Unit;
+  IntVect offset = IntVect::Zero;
+  unsigned int any = 0;
+  for (int r = 0; r < NumRows; r++)
+    {
+      if (rows[r] == 0) continue;
+      any |= rows[r];
+      rowOffset(r, offset);
+      lo.min(offset);
+      hi.max(offset);
+    }
+  lo[0] = __builtin_ctz(any);
+  hi[0] = 31 - __builtin_clz(any);
+  a_box = Box(a_key*TileSize + lo, a_key*TileSize + hi);
+}
+
+const Box& TiledIntVectSet::minBox() const
+{
+  if (!m_minBoxValid) recalcMinBox();
+  return m_minBox;
+}
+
+void TiledIntVectSet::recalcMinBox() const
+{
+  m_minBox = Box();
+  Box b;
+  for (TileMap::const_iterator it = m_tiles.begin(); it != m_tiles.end(); ++it)
+    {
+      boxOfTile(it->first, it->second, b);
+      if (m_minBox.isEmpty()) m_minBox = b;
+      else                    m_minBox.minBox(b);
+    }
+  m_minBoxValid = true;
+}
+
+Vector<Box> TiledIntVectSet::createBoxes() const
+{
+  // runs of cells along each row, then joined across rows and tiles
+  std::vector<Box> boxes;
+  IntVect offset = IntVect::Zero;
+  for (TileMap::const_iterator it = m_tiles.begin(); it != m_tiles.end(); ++it)
+    {
+      const IntVect base = it->first*TileSize;
+      const unsigned char* rows = it->second.rows();
+      bool full = true;
+      for (int r = 0; r < NumRows && full; r++) full = (rows[r] == 0xFF);
+      if (full)
+        {
+          boxes.push_back(tileBox(it->first));
+          continue;
+        }
+      for (int r = 0; r < NumRows; r++)
+        {
+          unsigned int bits = rows[r];
+          if (bits == 0) continue;
+          rowOffset(r, offset);
+          offset[0] = 0;
+          while (bits != 0)
+            {
+              int first = __builtin_ctz(bits);
+              int len   = __builtin_ctz(~(bits >> first));
+              IntVect lo = base + offset;
+              lo[0] += first;
+              IntVect hi = lo;
+              hi[0] += len - 1;
+              boxes.push_back(Box(lo, hi));
+              bits &= ~(((1u << len) - 1) << first);
+            }
+        }
+    }
+  mergeBoxes(boxes);
+  Vector<Box> rtn(boxes);
+  return rtn;
+}
+
+bool TiledIntVectSet::operator==(const TiledIntVectSet& a_ivs) const
+{
+  if (m_tiles.size() != a_ivs.m_tiles.size()) return false;
+  for (TileMap::const_iterator it = m_tiles.begin(); it != m_tiles.end(); ++it)
+    {
+      TileMap::const_iterator other = a_ivs.m_tiles.find(it->first);
+      if (other == a_ivs.m_tiles.end()) return false;
+      for (int i = 0; i < NumWords; i++)
+        {
+          if (it->second.w[i] != other->second.w[i]) return false;
+        }
+    }
+  return true;
+}
+
+bool TiledIntVectSet::operator<(const TiledIntVectSet& a_ivs) const
+{
+  if (m_tiles.size() != a_ivs.m_tiles.size()) return m_tiles.size() < a_ivs.m_tiles.size();
+
+  std::vector<TileMap::const_iterator> mine, other;
+  for (TileMap::const_iterator it = m_tiles.begin(); it != m_tiles.end(); ++it) mine.push_back(it);
+  for (TileMap::const_iterator it = a_ivs.m_tiles.begin(); it != a_ivs.m_tiles.end(); ++it) other.push_back(it);
+  std::sort(mine.begin(),  mine.end(),  TiledKeyLess());
+  std::sort(other.begin(), other.end(), TiledKeyLess());
+  for (unsigned int i = 0; i < mine.size(); i++)
+    {
+      if (mine[i]->first != other[i]->first) return mine[i]->first.lexLT(other[i]->first);
+      for (int j = 0; j < NumWords; j++)
+        {
+          if (mine[i]->second.w[j] != other[i]->second.w[j])
+            {
+              return mine[i]->second.w[j] < other[i]->second.w[j];
+            }
+        }
+    }
+  return false;
+}
+
+int TiledIntVectSet::linearSize() const
+{
+  return sizeof(int) + m_tiles.size()*(SpaceDim*sizeof(int) + NumWords*sizeof(uint64_t));
+}
+
+void TiledIntVectSet::linearOut(void* const a_outBuf) const
+{
+  char* buf = (char*)a_outBuf;
+  int n = m_tiles.size();
+  memcpy(buf, &n, sizeof(int));
+  buf += sizeof(int);
+  for (TileMap::const_iterator it = m_tiles.begin(); it != m_tiles.end(); ++it)
+    {
+      memcpy(buf, it->first.dataPtr(), SpaceDim*sizeof(int));
+      buf += SpaceDim*sizeof(int);
+      memcpy(buf, it->second.w, NumWords*sizeof(uint64_t));
+      buf += NumWords*sizeof(uint64_t);
+    }
+}
+
+void TiledIntVectSet::linearIn(const void* const a_inBuf)
+{
+  clear();
+  const char* buf = (const char*)a_inBuf;
+  int n;
+  memcpy(&n, buf, sizeof(int));
+  buf += sizeof(int);
+  m_tiles.reserve(n);
+  for (int i = 0; i < n; i++)
+    {
+      IntVect key;
+      memcpy(key.dataPtr(), buf, SpaceDim*sizeof(int));
+      buf += SpaceDim*sizeof(int);
+      memcpy(m_tiles[key].w, buf, NumWords*sizeof(uint64_t));
+      buf += NumWords*sizeof(uint64_t);
+    }
+  invalidate();
+}
+
+//====================================================================
+
+void TiledIntVectSetIterator::begin()
+{
+  if (m_ivs == NULL) return;
+  m_it  = m_ivs->m_tiles.begin();
+  m_row = 0;
+  findNext();
+}
+
+// moves to the first IntVect at or after row m_row of the current tile
+void TiledIntVectSetIterator::findNext()
+{
+  const int numRows = TiledIntVectSet::NumRows;
+  while (m_it != m_ivs->m_tiles.end())
+    {
+      const TiledIntVectSet::Tile& tile = m_it->second;
+      const unsigned char* rows = tile.rows();
+      while (m_row < numRows)
+        {
+          // skip empty words
+          if ((m_row & 7) == 0 && m_row + 8 <= numRows && tile.w[m_row >> 3] == 0)
+            {
+              m_row += 8;
+              continue;
+            }
+          if (rows[m_row] != 0)
+            {
+              m_bits = rows[m_row];
+              m_base = m_it->first*TiledIntVectSet::TileSize;
+              IntVect offset = IntVect::Zero;
+              TiledIntVectSet::rowOffset(m_row, offset);
+              m_base += offset;
+              m_current = m_base;
+              m_current[0] += __builtin_ctz(m_bits);
+              return;
+            }
+          m_row++;
+        }
+      ++m_it;
+      m_row = 0;
+    }
+}
+
+#include "NamespaceFooter.H"
@@ -44,6 +44,7 @@
 int  EBAMRGodunov::s_NewPlotFile = 0;
 bool EBAMRGodunov::s_isLoadBalanceSet = false;
 LoadBalanceFunc EBAMRGodunov::s_loadBalance  = NULL;
+bool EBAMRGodunov::s_useMeasuredCost = false;
 IntVect ivdebamrg(D_DECL(16, 5, 0));
 int debuglevel = 1;
 
@@ -808,6 +809,13 @@ void EBAMRGodunov::regrid(const Vector<Box>& a_new_grids)
     {
       s_loadBalance(proc_map,a_new_grids, m_domainBox, false);
     }
+  else if (s_useMeasuredCost && m_costModel.isDefined())
+    {
+      // balance the time the old boxes took, not their number of cells
+      Vector<long long> loads;
+      m_costModel.computeLoads(loads, a_new_grids);
+      LoadBalance(proc_map, loads, a_new_grids);
+    }
   else
     {
       LoadBalance(proc_map,a_new_grids);
@@ -1182,6 +1190,12 @@ EBAMRGodunov::levelSetup()
   m_hasCoarser = (coarPtr != NULL);
   m_hasFiner   = (finePtr != NULL);
   pout() << "for level " << m_level << endl;
+  if (s_useMeasuredCost)
+    {
+      // start measuring the new boxes
+      m_costModel.define(m_grids);
+      m_ebLevelGodunov.setCostModel(&m_costModel);
+    }
   if (m_hasCoarser)
     {
       int nRefCrse = m_coarser_level_ptr->refRatio();
@@ -30,6 +30,7 @@ EBLevelGodunov::EBLevelGodunov()
 {
   m_isDefined = false;
   m_ebPatchGodunovSP = NULL;
+  m_costModel = NULL;
 }
 
 /*****************************/
@@ -361,43 +362,48 @@ doRegularUpdate(EBFluxRegister&               a_fineFluxRegister,
   //int ibox = 0;
   Interval consInterv(0, m_nCons-1);
   Interval fluxInterv(0, m_nFlux-1);
-  DataIterator dit = m_thisGrids.dataIterator();
-  int nbox=dit.size();
-  for (int jbox=0; jbox <nbox; jbox++)
+  // time each box for the load balancer if asked to
+  TimedDataIterator dit = m_thisGrids.timedDataIterator();
+  if (m_costModel != NULL)
     {
-      const Box& cellBox = m_thisGrids.get(dit[jbox]);
-      const EBISBox& ebisBox = m_thisEBISL[dit[jbox]];
+      dit.clearTime();
+      dit.enableTime();
+    }
+  for (dit.begin(); dit.ok(); ++dit)
+    {
+      const Box& cellBox = m_thisGrids.get(dit());
+      const EBISBox& ebisBox = m_thisEBISL[dit()];
       if (!ebisBox.isAllCovered())
         {
-          //const IntVectSet& cfivs = m_cfIVS[dit[jbox]];
+          //const IntVectSet& cfivs = m_cfIVS[dit()];
 
-          EBCellFAB& consState = a_consState[dit[jbox]];
-          //          m_ebPatchGodunov[dit[jbox]]->setValidBox(cellBox, ebisBox, cfivs, a_time, a_dt);
-          m_ebPatchGodunov[dit[jbox]]->setTimeAndDt(a_time, a_dt);
+          EBCellFAB& consState = a_consState[dit()];
+          //          m_ebPatchGodunov[dit()]->setValidBox(cellBox, ebisBox, cfivs, a_time, a_dt);
+          m_ebPatchGodunov[dit()]->setTimeAndDt(a_time, a_dt);
 
           EBCellFAB source;
           if (m_hasSourceTerm)
             {
               const Box& bigBox = consState.box();
-              int nPrim = m_ebPatchGodunov[dit[jbox]]->numPrimitives();
+              int nPrim = m_ebPatchGodunov[dit()]->numPrimitives();
               source.define(ebisBox, bigBox, nPrim);
               //this setval is important
               source.setVal(0.);
-              m_ebPatchGodunov[dit[jbox]]->setSource(source, consState, bigBox);
+              m_ebPatchGodunov[dit()]->setSource(source, consState, bigBox);
             }
 
           EBFluxFAB flux(ebisBox, cellBox, m_nFlux);
-          BaseIVFAB<Real>& nonConsDiv    = m_nonConsDivergence[dit[jbox]];
-          BaseIVFAB<Real>& ebIrregFlux   = m_ebIrregFaceFlux[dit[jbox]];
+          BaseIVFAB<Real>& nonConsDiv    = m_nonConsDivergence[dit()];
+          BaseIVFAB<Real>& ebIrregFlux   = m_ebIrregFaceFlux[dit()];
           flux.setVal(7.89);
           ebIrregFlux.setVal(7.89);
-          const IntVectSet& ivsIrreg     = m_irregSetsSmall[dit[jbox]];
-          const EBCellFAB& flatteningFAB = m_flattening[dit[jbox]];
+          const IntVectSet& ivsIrreg     = m_irregSetsSmall[dit()];
+          const EBCellFAB& flatteningFAB = m_flattening[dit()];
 
-          m_ebPatchGodunov[dit[jbox]]->regularUpdate(consState, flux, ebIrregFlux,
-                                          nonConsDiv,flatteningFAB,
-                                          source, cellBox, ivsIrreg,
-                                          dit[jbox],verbose);
+          m_ebPatchGodunov[dit()]->regularUpdate(consState, flux, ebIrregFlux,
+                                      nonConsDiv,flatteningFAB,
+                                      source, cellBox, ivsIrreg,
+                                      dit(),verbose);
 
           //do fluxregister cha-cha
           /*
@@ -415,12 +421,12 @@ doRegularUpdate(EBFluxRegister&               a_fineFluxRegister,
                 {
                   //gather fluxes into flux-register compatible form
                   fluxRegFlux.define(ebisBox, cellBox, idir, m_nCons);
-                  m_ebPatchGodunov[dit[jbox]]->assembleFluxReg(fluxRegFlux, flux[idir],
-                                                    idir, cellBox);
+                  m_ebPatchGodunov[dit()]->assembleFluxReg(fluxRegFlux, flux[idir],
+                                                idir, cellBox);
                 }
               if (m_hasFiner)
                 {
-                  a_fineFluxRegister.incrementCoarseRegular(flux[idir], scale,dit[jbox],
+                  a_fineFluxRegister.incrementCoarseRegular(flux[idir], scale,dit(),
                                                             consInterv, idir);
                 }
 
@@ -428,7 +434,7 @@ doRegularUpdate(EBFluxRegister&               a_fineFluxRegister,
                 {
                   for (SideIterator sit; sit.ok(); ++sit)
                     {
-                      a_coarFluxRegister.incrementFineRegular(flux[idir],scale, dit[jbox],
+                      a_coarFluxRegister.incrementFineRegular(flux[idir],scale, dit(),
                                                               consInterv, idir,sit());
                     }
                 }
@@ -437,11 +443,11 @@ doRegularUpdate(EBFluxRegister&               a_fineFluxRegister,
           //copy fluxes into sparse interpolant
           for (int faceDir = 0; faceDir < SpaceDim; faceDir++)
             {
-              IntVectSet ivsIrregGrown = m_irregSetsGrown[faceDir][dit[jbox]];
+              IntVectSet ivsIrregGrown = m_irregSetsGrown[faceDir][dit()];
               ivsIrregGrown &= cellBox;
               FaceStop::WhichFaces stopCrit = FaceStop::SurroundingWithBoundary;
 
-              BaseIFFAB<Real>& interpol = m_fluxInterpolants[faceDir][dit[jbox]];
+              BaseIFFAB<Real>& interpol = m_fluxInterpolants[faceDir][dit()];
               interpol.setVal(7.7777e7);
               EBFaceFAB& fluxDir = flux[faceDir];
               for (FaceIterator faceit(ivsIrregGrown, ebisBox.getEBGraph(),
@@ -457,6 +463,10 @@ doRegularUpdate(EBFluxRegister&               a_fineFluxRegister,
             }
         }
     }
+  if (m_costModel != NULL)
+    {
+      m_costModel->accumulate(dit);
+    }
 
   for (int faceDir = 0; faceDir < SpaceDim; faceDir++)
     {
@@ -477,47 +487,51 @@ doIrregularUpdate(EBFluxRegister&               a_fineFluxRegister,
   int ibox = 0;
   Interval consInterv(0, m_nCons-1);
   Interval fluxInterv(0, m_nFlux-1);
-  DataIterator dit = m_thisGrids.dataIterator();
-  int nbox=dit.size();
-  for (int jbox=0; jbox <nbox; jbox++, ibox++)
-    //  for (DataIterator dit = m_thisGrids.dataIterator(); dit.ok(); ++dit, ibox++)
+  // time each box for the load balancer if asked to
+  TimedDataIterator dit = m_thisGrids.timedDataIterator();
+  if (m_costModel != NULL)
     {
-      const Box& cellBox = m_thisGrids.get(dit[jbox]);
-      const EBISBox& ebisBox = m_thisEBISL[dit[jbox]];
+      dit.clearTime();
+      dit.enableTime();
+    }
+  for (dit.begin(); dit.ok(); ++dit, ibox++)
+    {
+      const Box& cellBox = m_thisGrids.get(dit());
+      const EBISBox& ebisBox = m_thisEBISL[dit()];
       if (!ebisBox.isAllCovered())
         {
-          //const IntVectSet& cfivs = m_cfIVS[dit[jbox]];
+          //const IntVectSet& cfivs = m_cfIVS[dit()];
 
-          EBCellFAB& consState = a_consState[dit[jbox]];
-          BaseIVFAB<Real>& redMass = a_massDiff[dit[jbox]];
+          EBCellFAB& consState = a_consState[dit()];
+          BaseIVFAB<Real>& redMass = a_massDiff[dit()];
 
-          //          m_ebPatchGodunov[dit[jbox]]->setValidBox(cellBox, ebisBox, cfivs, a_time, a_dt);
-          m_ebPatchGodunov[dit[jbox]]->setTimeAndDt(a_time, a_dt);
+          //          m_ebPatchGodunov[dit()]->setValidBox(cellBox, ebisBox, cfivs, a_time, a_dt);
+          m_ebPatchGodunov[dit()]->setTimeAndDt(a_time, a_dt);
 
           BaseIFFAB<Real> centroidFlux[SpaceDim];
           const BaseIFFAB<Real>* interpolantGrid[SpaceDim];
-          const IntVectSet& ivsIrregSmall = m_irregSetsSmall[dit[jbox]];
+          const IntVectSet& ivsIrregSmall = m_irregSetsSmall[dit()];
           for (int idir = 0; idir < SpaceDim; idir++)
             {
-              const BaseIFFAB<Real>& interpol = m_fluxInterpolants[idir][dit[jbox]];
+              const BaseIFFAB<Real>& interpol = m_fluxInterpolants[idir][dit()];
               interpolantGrid[idir] = &interpol;
               BaseIFFAB<Real>& fluxDir= centroidFlux[idir];
               fluxDir.define(ivsIrregSmall, ebisBox.getEBGraph(), idir, m_nFlux);
             }
-          m_ebPatchGodunov[dit[jbox]]->interpolateFluxToCentroids(centroidFlux,
-                                                       interpolantGrid,
-                                                       ivsIrregSmall);
+          m_ebPatchGodunov[dit()]->interpolateFluxToCentroids(centroidFlux,
+                                                   interpolantGrid,
+                                                   ivsIrregSmall);
 
           Real maxWaveSpeedGrid = 0.0;
           //update the state and interpolate the flux
-          const BaseIVFAB<Real>& nonConsDiv = m_nonConsDivergence[dit[jbox]];
-          const BaseIVFAB<Real>& ebIrregFlux = m_ebIrregFaceFlux[dit[jbox]];
-          m_ebPatchGodunov[dit[jbox]]->irregularUpdate(consState,
-                                            maxWaveSpeedGrid, redMass,
-                                            centroidFlux, ebIrregFlux, nonConsDiv,
-                                            cellBox, ivsIrregSmall);
-
-          m_ebLevelRedist.increment(redMass, dit[jbox], consInterv);
+          const BaseIVFAB<Real>& nonConsDiv = m_nonConsDivergence[dit()];
+          const BaseIVFAB<Real>& ebIrregFlux = m_ebIrregFaceFlux[dit()];
+          m_ebPatchGodunov[dit()]->irregularUpdate(consState,
+                                        maxWaveSpeedGrid, redMass,
+                                        centroidFlux, ebIrregFlux, nonConsDiv,
+                                        cellBox, ivsIrregSmall);
+
+          m_ebLevelRedist.increment(redMass, dit(), consInterv);
           maxWaveSpeed = Max(maxWaveSpeed, maxWaveSpeedGrid);
 
           //do fluxregister mambo
@@ -536,14 +550,14 @@ doIrregularUpdate(EBFluxRegister&               a_fineFluxRegister,
                 {
                   //gather fluxes into flux-register compatible form
                   fluxRegFlux.define(ivsIrregSmall, ebisBox.getEBGraph(), idir, m_nCons);
-                  m_ebPatchGodunov[dit[jbox]]->assembleFluxIrr(fluxRegFlux, centroidFlux[idir],
-                                                    idir,  cellBox, ivsIrregSmall);
+                  m_ebPatchGodunov[dit()]->assembleFluxIrr(fluxRegFlux, centroidFlux[idir],
+                                                idir,  cellBox, ivsIrregSmall);
                 }
 
               if (m_hasFiner)
                 {
                   a_fineFluxRegister.incrementCoarseIrregular(centroidFlux[idir],
-                                                              scale,dit[jbox],
+                                                              scale,dit(),
                                                               consInterv, idir);
                 }
 
@@ -552,13 +566,17 @@ doIrregularUpdate(EBFluxRegister&               a_fineFluxRegister,
                   for (SideIterator sit; sit.ok(); ++sit)
                     {
                       a_coarFluxRegister.incrementFineIrregular(centroidFlux[idir],
-                                                                scale, dit[jbox],
+                                                                scale, dit(),
                                                                 consInterv, idir,sit());
                     }
                 }
             }
         }
     }// end of loop over grids.
+  if (m_costModel != NULL)
+    {
+      m_costModel->accumulate(dit);
+    }
   a_consState.exchange(consInterv);
   return maxWaveSpeed;
 }
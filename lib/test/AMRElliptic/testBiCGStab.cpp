@@ -22,7 +22,10 @@ using std::endl;
 #include "AMRPoissonOp.H"
 #include "BCFunc.H"
 #include "BiCGStabSolver.H"
+#include "PipelinedBiCGStabSolver.H"
+#include "PipelinedGMRESSolver.H"
 #include "RelaxSolver.H"
+#include "SlabDataFactory.H"
 
 #include "UsingNamespace.H"
 
@@ -269,6 +272,7 @@ testBiCGStab()
 {
 
   ProblemDomain regularDomain(domain);
+  Real levelError = 0;
   pout()<<"\n GSRB unigrid solver \n";
   // GSRB single grid solver test
   {
@@ -469,6 +473,7 @@ testBiCGStab()
         enorm = amrop.norm(error, 0);
         pout()<<indent<<"residual norm "<<rnorm<<"   Error max norm = "<<enorm<<std::endl;
        }
+    levelError = enorm;
     amrop.scale(phi, 0.0);
     amrop.residual(residual, phi, rhs, false);
     pout()<<indent2<<"RelaxSolver\n";
@@ -484,5 +489,134 @@ testBiCGStab()
 
   }
 
+  pout()<<"\n contiguous level solver \n";
+  //  Level solve with each LevelData in one slab
+  {
+    DisjointBoxLayout  dbl;
+
+    makeGrids(dbl, domain);
+
+    dbl.close();
+
+    LevelData<FArrayBox> phi, phi_exact, error, rhs, residual;
+    defineContiguous(phi, dbl, 1, IntVect::Unit);
+    defineContiguous(phi_exact, dbl, 1, IntVect::Zero);
+    defineContiguous(error, dbl, 1, IntVect::Zero);
+    defineContiguous(rhs, dbl, 1, IntVect::Zero);
+    defineContiguous(residual, dbl, 1, IntVect::Zero);
+
+    size_t size;
+    long numPts = 0;
+    for (DataIterator dit(dbl); dit.ok(); ++dit) numPts += dbl[dit].numPts();
+    if (contiguousData(rhs, size) == NULL || size != numPts)
+      {
+        pout()<<indent<<"rhs is not one slab"<<std::endl;
+        return 1;
+      }
+
+    setvalue::val = 2*CH_SPACEDIM;
+    rhs.apply(setvalue::setFunc);
+    phi_exact.apply(parabola);
+
+    RealVect pos(IntVect::Unit);
+    pos*=dx;
+
+    AMRPoissonOp amrop;
+
+    amrop.define(dbl, pos[0], regularDomain, DirParabolaBC);
+
+    // the solver's work vectors are contiguous too
+    LevelDataOps<FArrayBox>::s_contiguous = true;
+
+    BiCGStabSolver<LevelData<FArrayBox> > bsolver;
+    bsolver.define(&amrop, false);
+
+    amrop.setToZero(phi);
+    bsolver.solve(phi, rhs);
+    amrop.axby(error, phi, phi_exact, 1, -1);
+    amrop.residual(residual, phi, rhs, false);
+    Real rnorm = amrop.norm(residual, 2);
+    Real enorm = amrop.norm(error, 0);
+    pout()<<indent<<"residual norm "<<rnorm<<"   Error max norm = "<<enorm<<std::endl;
+
+    LevelDataOps<FArrayBox>::s_contiguous = false;
+
+    if (Abs(enorm - levelError) > 1.0e-3*levelError)
+      {
+        pout()<<indent<<"contiguous solve error "<<enorm
+              <<" differs from "<<levelError<<std::endl;
+        return 2;
+      }
+  }
+
+  pout()<<"\n pipelined level solvers \n";
+  //  Level solve with the solvers that overlap their reductions
+  {
+    DisjointBoxLayout  dbl;
+
+    makeGrids(dbl, domain);
+
+    dbl.close();
+
+    LevelData<FArrayBox> phi(dbl, 1, IntVect::Unit);
+    LevelData<FArrayBox> phi_exact(dbl, 1);
+    LevelData<FArrayBox> error(dbl, 1);
+    LevelData<FArrayBox> rhs(dbl, 1);
+    LevelData<FArrayBox> residual(dbl, 1);
+
+    setvalue::val = 2*CH_SPACEDIM;
+    rhs.apply(setvalue::setFunc);
+    phi_exact.apply(parabola);
+
+    RealVect pos(IntVect::Unit);
+    pos*=dx;
+
+    AMRPoissonOp amrop;
+
+    amrop.define(dbl, pos[0], regularDomain, DirParabolaBC);
+
+    // both solve to a tight tolerance, so they reach the same discrete solution
+    PipelinedBiCGStabSolver<LevelData<FArrayBox> > psolver;
+    PipelinedGMRESSolver<LevelData<FArrayBox> > gsolver;
+    psolver.define(&amrop, false);
+    gsolver.define(&amrop, false);
+    psolver.m_eps = 1.0e-10;
+    psolver.m_imax = 400;
+    gsolver.m_reps = 1.0e-10;
+
+    amrop.setToZero(phi);
+    amrop.residual(residual, phi, rhs, false);
+    const Real rnorm0 = amrop.norm(residual, 2);
+
+    LinearSolver<LevelData<FArrayBox> >* solvers[2] = {&psolver, &gsolver};
+    const char* names[2] = {"PipelinedBiCGStab", "PipelinedGMRES"};
+    Real errors[2];
+    for (int isolver = 0; isolver < 2; isolver++)
+      {
+        pout()<<indent2<<names[isolver]<<"\n";
+        amrop.setToZero(phi);
+        solvers[isolver]->solve(phi, rhs);
+        amrop.axby(error, phi, phi_exact, 1, -1);
+        amrop.residual(residual, phi, rhs, false);
+        Real rnorm = amrop.norm(residual, 2);
+        errors[isolver] = amrop.norm(error, 0);
+        pout()<<indent<<"residual norm "<<rnorm<<"   Error max norm = "<<errors[isolver]<<std::endl;
+
+        if (rnorm > 1.0e-8*rnorm0)
+          {
+            pout()<<indent<<names[isolver]<<" residual "<<rnorm
+                  <<" not reduced from "<<rnorm0<<std::endl;
+            return 3;
+          }
+      }
+    if (psolver.m_exitStatus != 1 || gsolver.m_exitStatus != 1 ||
+        Abs(errors[0] - errors[1]) > 1.0e-3*errors[1])
+      {
+        pout()<<indent<<"pipelined solvers disagree, status "
+              <<psolver.m_exitStatus<<" "<<gsolver.m_exitStatus<<std::endl;
+        return 4;
+      }
+  }
+
   return 0;
 }
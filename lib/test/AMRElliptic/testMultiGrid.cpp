@@ -21,8 +21,13 @@ using std::endl;
 
 #include "NewPoissonOp.H"
 #include "AMRPoissonOp.H"
+#include "VCAMRPoissonOp2.H"
+#include "ViscousTensorOp.H"
 #include "BCFunc.H"
 #include "BiCGStabSolver.H"
+#include "PipelinedBiCGStabSolver.H"
+#include "MGAgglomeration.H"
+#include "MixedPrecisionSolver.H"
 #include "CH_Timer.H"
 
 #include "UsingNamespace.H"
@@ -131,6 +136,21 @@ main(int argc ,char* argv[])
     pout() << indent << pgmname << " failed with return code " << status << endl ;
   }
 
+  // same solves, with the AMRPoissonOp exchanges overlapped with
+  // the operator evaluation on the box interiors
+  AMRPoissonOp::s_exchangeMode = 2;
+  status = testMultiGrid();
+
+  if ( status == 0 )
+  {
+    pout() << indent << pgmname << " passed." << endl ;
+  }
+  else
+  {
+    overallStatus = 1;
+    pout() << indent << pgmname << " failed with return code " << status << endl ;
+  }
+
 
 #ifdef CH_MPI
   MPI_Finalize ();
@@ -195,6 +215,33 @@ extern "C"
       }
   }
 
+  // homogeneous Dirichlet conditions on the faces of valid on the
+  // domain boundary only
+  void DomainDiriBC(FArrayBox& a_state,
+                    const Box& valid,
+                    const ProblemDomain& a_domain,
+                    Real a_dx,
+                    bool a_homogeneous)
+  {
+
+    for (int i=0; i<CH_SPACEDIM; ++i)
+      {
+        for (SideIterator sit; sit.ok(); ++sit)
+          {
+            if (!a_domain.domainBox().contains(adjCellBox(valid, i, sit(), 1)))
+              {
+                DiriBC(a_state,
+                       valid,
+                       dx,
+                       a_homogeneous,
+                       Parabola_diri,
+                       i,
+                       sit());
+              }
+          }
+      }
+  }
+
   void NeumParabolaBC(FArrayBox& a_state,
                       const Box& valid,
                       const ProblemDomain& a_domain,
@@ -396,38 +443,331 @@ testMultiGrid()
     opFactory.define(regularDomain, dbl, pos[0], DirParabolaBC, 1);
     AMRLevelOpFactory<LevelData<FArrayBox> >& castFact  =
       (AMRLevelOpFactory<LevelData<FArrayBox> >&)opFactory;
-    MultiGrid<LevelData<FArrayBox> > solver;
-    BiCGStabSolver<LevelData<FArrayBox> > bottomSolver;
+    // the same cycles with a BiCGStab and a pipelined BiCGStab bottom
+    // solver, then with the coarse levels agglomerated onto one processor,
+    // then with the Chebyshev smoother
+    BiCGStabSolver<LevelData<FArrayBox> > bicgstab;
+    PipelinedBiCGStabSolver<LevelData<FArrayBox> > pipelined;
+    bicgstab.m_verbosity = 0;
+    pipelined.m_verbosity = 0;
+    LinearSolver<LevelData<FArrayBox> >* bottomSolvers[4] = {&bicgstab, &pipelined, &bicgstab, &bicgstab};
+    const char* names[4] = {"BiCGStab", "PipelinedBiCGStab", "agglomerated BiCGStab", "Chebyshev smoother, BiCGStab"};
+    Real finalNorm[4];
+    Real initialNorm = 0;
 
     MGLevelOp<LevelData<FArrayBox> >* op = castFact.MGnewOp(regularDomain,0);
 
-    solver.define(castFact, &bottomSolver, regularDomain);
+    const int relaxMode = AMRPoissonOp::s_relaxMode;
+    for (int ibottom = 0; ibottom < 4; ibottom++)
+      {
+        setMGAgglomerationCells(ibottom == 2 ? 1000000 : 0);
+        AMRPoissonOp::s_relaxMode = (ibottom == 3) ? 6 : relaxMode;
+        opFactory.define(regularDomain, dbl, pos[0], DirParabolaBC, 1);
+        MultiGrid<LevelData<FArrayBox> > solver;
+        solver.define(castFact, bottomSolvers[ibottom], regularDomain);
+
+        int iter = 3;
+        op->scale(phi, 0.0);
+        op->axby(error, phi, phi_exact, 1, -1);
+        op->residual(residual, phi, rhs, false);
+        Real rnorm = op->norm(residual, 2);
+        Real enorm = op->norm(error, 0);
+
+        pout()<< "homogeneous solver mode : solver.oneCycle(correction, residual)\n";
+        pout()<< names[ibottom] << " bottom solver\n";
+
+        pout()<<"\nInitial residual norm "<<rnorm<<" Error max norm "<<enorm<<"\n\n";
+        initialNorm = rnorm;
+        solver.init(correction, residual);
+        for (int i=0; i<iter; ++i)
+          {
+            op->scale(correction, 0.0);
+            solver.oneCycle(correction, residual);
+            op->incr(phi, correction, 1.0);
+            op->axby(error, phi, phi_exact, 1, -1);
+            op->residual(residual, phi, rhs, false);
+            rnorm = op->norm(residual, 2);
+            enorm = op->norm(error, 0);
+            pout()<<indent<<"residual norm "<<rnorm<<"   Error max norm = "<<enorm<<std::endl;
+          }
+        finalNorm[ibottom] = rnorm;
+      }
+
+    setMGAgglomerationCells(0);
+    AMRPoissonOp::s_relaxMode = relaxMode;
 
-    bottomSolver.m_verbosity = 0;
-    int iter = 3;
+    if (finalNorm[1] > 1.1*finalNorm[0])
+      {
+        pout()<<indent<<"pipelined bottom solver residual "<<finalNorm[1]
+              <<" is larger than "<<finalNorm[0]<<std::endl;
+        delete op;
+        return 1;
+      }
+    if (Abs(finalNorm[2] - finalNorm[0]) > 1.0e-3*finalNorm[0])
+      {
+        pout()<<indent<<"agglomerated residual "<<finalNorm[2]
+              <<" differs from "<<finalNorm[0]<<std::endl;
+        delete op;
+        return 2;
+      }
+    if (finalNorm[3] > 1.0e-3*initialNorm)
+      {
+        pout()<<indent<<"Chebyshev smoother residual "<<finalNorm[3]
+              <<" is not below 1e-3 times "<<initialNorm<<std::endl;
+        delete op;
+        return 3;
+      }
+
+    // single precision V-cycles inside double precision iterative
+    // refinement must reach a tolerance beyond float round-off
+    pout()<< "\nmixed precision solver\n";
+    FloatPoissonOpFactory floatFactory;
+    floatFactory.define(dbl, pos[0], regularDomain, DirParabolaBC, 0.0, 1.0);
+    MixedPrecisionSolver mixed;
+    mixed.define(op, floatFactory, regularDomain);
+    mixed.m_reps = 1.0e-10;
     op->scale(phi, 0.0);
-    op->axby(error, phi, phi_exact, 1, -1);
     op->residual(residual, phi, rhs, false);
-    Real rnorm = op->norm(residual, 2);
-    Real enorm = op->norm(error, 0);
+    Real rnorm0 = op->norm(residual, 0);
+    mixed.solve(phi, rhs);
+    op->residual(residual, phi, rhs, false);
+    Real rnorm = op->norm(residual, 0);
+    op->axby(error, phi, phi_exact, 1, -1);
+    pout()<<indent<<"residual max norm "<<rnorm<<"   Error max norm = "
+          <<op->norm(error, 0)<<std::endl;
+    if (mixed.m_exitStatus != 1 || rnorm > 1.0e-10*rnorm0)
+      {
+        pout()<<indent<<"mixed precision residual "<<rnorm
+              <<" is not below 1e-10 times "<<rnorm0<<std::endl;
+        delete op;
+        return 4;
+      }
+
+    delete op;
+  }
 
-    pout()<< "homogeneous solver mode : solver.oneCycle(correction, residual)\n";
+  pout()<<"\n deep ghost relaxation \n";
+  // GSRB with one exchange every few iterations (relaxation mode 7) must
+  // give the GSRB result on grids that cover the domain
+  {
+    Vector<Box> boxes;
+    domainSplit(domain, boxes, 32, blockingFactor);
+    Vector<int> procs;
+    LoadBalance(procs, boxes);
+    DisjointBoxLayout dbl(boxes, procs, regularDomain);
 
-    pout()<<"\nInitial residual norm "<<rnorm<<" Error max norm "<<enorm<<"\n\n";
-    solver.init(correction, residual);
-    for (int i=0; i<iter; ++i)
+    LevelData<FArrayBox> phi(dbl, 1, IntVect::Unit);
+    LevelData<FArrayBox> phiDeep(dbl, 1, IntVect::Unit);
+    LevelData<FArrayBox> rhs(dbl, 1);
+
+    setvalue::val = 2*CH_SPACEDIM;
+    rhs.apply(setvalue::setFunc);
+    phi.apply(parabola);
+
+    AMRPoissonOpFactory opFactory;
+    opFactory.define(regularDomain, dbl, dx, DomainDiriBC, 1);
+    AMRLevelOpFactory<LevelData<FArrayBox> >& castFact  =
+      (AMRLevelOpFactory<LevelData<FArrayBox> >&)opFactory;
+    AMRPoissonOp::setSweepsPerExchange(Vector<int>(1, 2));
+    MGLevelOp<LevelData<FArrayBox> >* op = castFact.MGnewOp(regularDomain,0);
+
+    // 5 iterations: two blocks of 2, then one of 1
+    op->assign(phiDeep, phi);
+    const int relaxMode = AMRPoissonOp::s_relaxMode;
+    AMRPoissonOp::s_relaxMode = 1;
+    op->relax(phi, rhs, 5);
+    AMRPoissonOp::s_relaxMode = 7;
+    op->relax(phiDeep, rhs, 5);
+    AMRPoissonOp::s_relaxMode = relaxMode;
+
+    Real norm = op->norm(phi, 0);
+    op->incr(phiDeep, phi, -1.0);
+    Real diff = op->norm(phiDeep, 0);
+    pout()<<indent<<"GSRB max norm "<<norm<<"   deep ghost difference = "<<diff<<std::endl;
+    delete op;
+    if (diff > 1.0e-12*norm)
       {
-        op->scale(correction, 0.0);
-        solver.oneCycle(correction, residual);
-        op->incr(phi, correction, 1.0);
-        op->axby(error, phi, phi_exact, 1, -1);
-        op->residual(residual, phi, rhs, false);
-        rnorm = op->norm(residual, 2);
-        enorm = op->norm(error, 0);
-        pout()<<indent<<"residual norm "<<rnorm<<"   Error max norm = "<<enorm<<std::endl;
+        pout()<<indent<<"deep ghost relaxation differs from GSRB by "<<diff<<std::endl;
+        return 5;
+      }
+  }
+
+  pout()<<"\n variable coefficient and viscous tensor operators \n";
+  // the V-cycles of the other factories that agglomerate their coarse
+  // multigrid levels must match those without agglomeration, and their
+  // Chebyshev smoothers must converge
+  {
+    Vector<Box> boxes;
+    domainSplit(domain, boxes, 32, blockingFactor);
+    Vector<int> procs;
+    LoadBalance(procs, boxes);
+    DisjointBoxLayout dbl(boxes, procs, regularDomain);
+    Vector<DisjointBoxLayout> grids(1, dbl);
+    Vector<int> refRatios(1, 2);
+
+    // a heat equation step, I - L: VCAMRPoissonOp2 is alpha*a*I - beta*L
+    // and ViscousTensorOp is alpha*a*I + beta*L
+    Real alpha = 1.0;
+    Real beta = 1.0;
+    Vector<RefCountedPtr<LevelData<FArrayBox> > > aCoef(1);
+    Vector<RefCountedPtr<LevelData<FluxBox> > > bCoef(1);
+    aCoef[0] = RefCountedPtr<LevelData<FArrayBox> >(new LevelData<FArrayBox>(dbl, 1));
+    bCoef[0] = RefCountedPtr<LevelData<FluxBox> >(new LevelData<FluxBox>(dbl, 1));
+    for (DataIterator dit = dbl.dataIterator(); dit.ok(); ++dit)
+      {
+        (*aCoef[0])[dit].setVal(1.0);
+        (*bCoef[0])[dit].setVal(1.0);
       }
 
+    BiCGStabSolver<LevelData<FArrayBox> > bicgstab;
+    bicgstab.m_verbosity = 0;
+    const char* names[2] = {"VCAMRPoissonOp2", "ViscousTensorOp"};
+    const char* variants[3] = {"", ", agglomerated", ", Chebyshev smoother"};
+    const int relaxMode = AMRPoissonOp::s_relaxMode;
+    const int tensorRelaxMode = ViscousTensorOp::s_relaxMode;
+    for (int iop = 0; iop < 2; iop++)
+      {
+        const int ncomp = (iop == 0) ? 1 : SpaceDim;
+        LevelData<FArrayBox> phi(dbl, ncomp, IntVect::Unit);
+        LevelData<FArrayBox> correction(dbl, ncomp, IntVect::Unit);
+        LevelData<FArrayBox> residual(dbl, ncomp);
+        LevelData<FArrayBox> rhs(dbl, ncomp);
+        rhs.apply(parabola);
+
+        Real initialNorm = 0;
+        Real finalNorm[3];
+        for (int ivar = 0; ivar < 3; ivar++)
+          {
+            setMGAgglomerationCells(ivar == 1 ? 1000000 : 0);
+            AMRPoissonOp::s_relaxMode = (ivar == 2) ? 6 : relaxMode;
+            ViscousTensorOp::s_relaxMode = (ivar == 2) ? 1 : tensorRelaxMode;
+            RefCountedPtr<AMRLevelOpFactory<LevelData<FArrayBox> > > factory;
+            if (iop == 0)
+              {
+                VCAMRPoissonOp2Factory* vcFactory = new VCAMRPoissonOp2Factory;
+                vcFactory->define(regularDomain, grids, refRatios, dx, DomainDiriBC,
+                                  alpha, aCoef, beta, bCoef);
+                factory = RefCountedPtr<AMRLevelOpFactory<LevelData<FArrayBox> > >(vcFactory);
+              }
+            else
+              {
+                Vector<RefCountedPtr<LevelData<FluxBox> > > eta(bCoef);
+                Vector<RefCountedPtr<LevelData<FluxBox> > > lambda(bCoef);
+                factory = RefCountedPtr<AMRLevelOpFactory<LevelData<FArrayBox> > >
+                  (new ViscousTensorOpFactory(grids, eta, lambda, aCoef, alpha, -beta,
+                                              refRatios, regularDomain, dx, DomainDiriBC));
+              }
+            MultiGrid<LevelData<FArrayBox> > solver;
+            solver.define(*factory, &bicgstab, regularDomain);
+            MGLevelOp<LevelData<FArrayBox> >* op = factory->MGnewOp(regularDomain, 0);
+
+            op->setToZero(phi);
+            op->residual(residual, phi, rhs, true);
+            Real rnorm = op->norm(residual, 2);
+            pout()<<indent<<names[iop]<<variants[ivar]
+                  <<": initial residual norm "<<rnorm<<std::endl;
+            initialNorm = rnorm;
+            solver.init(correction, residual);
+            for (int i = 0; i < 5; i++)
+              {
+                op->setToZero(correction);
+                solver.oneCycle(correction, residual);
+                op->incr(phi, correction, 1.0);
+                op->residual(residual, phi, rhs, true);
+                rnorm = op->norm(residual, 2);
+                pout()<<indent<<"residual norm "<<rnorm<<std::endl;
+              }
+            finalNorm[ivar] = rnorm;
+            delete op;
+          }
+        setMGAgglomerationCells(0);
+        AMRPoissonOp::s_relaxMode = relaxMode;
+        ViscousTensorOp::s_relaxMode = tensorRelaxMode;
+
+        if (Abs(finalNorm[1] - finalNorm[0]) > 1.0e-3*finalNorm[0])
+          {
+            pout()<<indent<<"agglomerated "<<names[iop]<<" residual "<<finalNorm[1]
+                  <<" differs from "<<finalNorm[0]<<std::endl;
+            return 6;
+          }
+        if (finalNorm[2] > 1.0e-3*initialNorm)
+          {
+            pout()<<indent<<names[iop]<<" Chebyshev smoother residual "<<finalNorm[2]
+                  <<" is not below 1e-3 times "<<initialNorm<<std::endl;
+            return 7;
+          }
+      }
+  }
+
+  pout()<<"\n viscous tensor residual at a coarse-fine interface \n";
+  // a homogeneous level residual on a refined level must see a zero
+  // coarser level, while the AMR residual must keep the coarse data
+  {
+    Vector<Box> coarseBoxes, fineBoxes;
+    domainSplit(domain, coarseBoxes, 32, blockingFactor);
+    Box fineDomain = refine(Box(domain.size()/4, 3*domain.size()/4 - IntVect::Unit), 2);
+    domainSplit(fineDomain, fineBoxes, 32, blockingFactor);
+    Vector<int> coarseProcs, fineProcs;
+    LoadBalance(coarseProcs, coarseBoxes);
+    LoadBalance(fineProcs, fineBoxes);
+    Vector<DisjointBoxLayout> grids(2);
+    grids[0] = DisjointBoxLayout(coarseBoxes, coarseProcs, regularDomain);
+    grids[1] = DisjointBoxLayout(fineBoxes, fineProcs, refine(regularDomain, 2));
+    Vector<int> refRatios(2, 2);
+
+    Vector<RefCountedPtr<LevelData<FArrayBox> > > aCoef(2);
+    Vector<RefCountedPtr<LevelData<FluxBox> > > eta(2);
+    for (int ilev = 0; ilev < 2; ilev++)
+      {
+        aCoef[ilev] = RefCountedPtr<LevelData<FArrayBox> >(new LevelData<FArrayBox>(grids[ilev], 1));
+        eta[ilev] = RefCountedPtr<LevelData<FluxBox> >(new LevelData<FluxBox>(grids[ilev], 1));
+        for (DataIterator dit = grids[ilev].dataIterator(); dit.ok(); ++dit)
+          {
+            (*aCoef[ilev])[dit].setVal(1.0);
+            (*eta[ilev])[dit].setVal(1.0);
+          }
+      }
+    ViscousTensorOpFactory factory(grids, eta, eta, aCoef, 1.0, -1.0, refRatios,
+                                   regularDomain, dx, DomainDiriBC);
+    ViscousTensorOp* op = (ViscousTensorOp*)factory.AMRnewOp(refine(regularDomain, 2));
+
+    LevelData<FArrayBox> phi(grids[1], SpaceDim, IntVect::Unit);
+    LevelData<FArrayBox> rhs(grids[1], SpaceDim);
+    LevelData<FArrayBox> residual(grids[1], SpaceDim);
+    LevelData<FArrayBox> amrResidual(grids[1], SpaceDim);
+    LevelData<FArrayBox> phiCoarse(grids[0], SpaceDim, IntVect::Unit);
+    rhs.apply(parabola);
+    phiCoarse.apply(parabola);
+    for (DataIterator dit = grids[1].dataIterator(); dit.ok(); ++dit)
+      {
+        parabola(phi[dit].box(), SpaceDim, phi[dit]);
+      }
+
+    // the parabola in the ghost cells must be replaced by the
+    // interpolation from a zero coarser level
+    op->residual(residual, phi, rhs, true);
+    for (DataIterator dit = grids[0].dataIterator(); dit.ok(); ++dit)
+      {
+        phiCoarse[dit].setVal(0.0);
+      }
+    op->AMRResidualNF(amrResidual, phi, phiCoarse, rhs, true);
+    op->incr(amrResidual, residual, -1.0);
+    Real norm = op->norm(residual, 0);
+    Real diff = op->norm(amrResidual, 0);
+
+    // and nonzero coarse data must change the AMR residual
+    phiCoarse.apply(parabola);
+    op->AMRResidualNF(amrResidual, phi, phiCoarse, rhs, true);
+    op->incr(amrResidual, residual, -1.0);
+    Real coarseDiff = op->norm(amrResidual, 0);
+    pout()<<indent<<"residual max norm "<<norm<<"   difference from zero coarse data = "
+          <<diff<<"   from nonzero coarse data = "<<coarseDiff<<std::endl;
     delete op;
+    if (diff > 1.0e-12*norm || coarseDiff < 1.0e-6*norm)
+      {
+        pout()<<indent<<"homogeneous viscous tensor residual does not match the AMR residual"<<std::endl;
+        return 8;
+      }
   }
 
   return 0;
@@ -68,6 +68,11 @@ public:
   void
   postTimeStep();
 
+// advance by one timestep, as a task per box
+  virtual
+  int
+  addAdvanceTasks(TaskGraph& a_graph, const Vector<int>& a_after);
+
 // create tags
   virtual
   void
@@ -140,6 +145,15 @@ public:
   Real
   computeInitialDt();
 
+// state vector at new time
+  const LevelData<FArrayBox>&
+  state() const;
+
+protected:
+// update the state on one box
+  void
+  advanceBox(const DataIndex& a_index);
+
 protected:
   DisjointBoxLayout
   loadBalance(const Vector<Box>& a_grids);
@@ -215,13 +229,47 @@ AMRDerivedClass::advance ()
                        m_state_old,
                        m_state_old.interval () );
 
-// blahblahblah.step(...)
+  for (DataIterator dit = m_state_new.dataIterator(); dit.ok(); ++dit)
+  {
+    advanceBox(dit());
+  }
 
   m_time += m_dt;
 
   return (.99 * m_dt);
 }
 
+// relax the state towards a value that differs between levels, so that
+// averaging down in postTimeStep changes the coarser levels
+
+void
+AMRDerivedClass::advanceBox (const DataIndex& a_index)
+{
+  FArrayBox& state_fab = m_state_new[a_index];
+  state_fab.mult(1. - m_dt);
+  state_fab.plus(m_dt * (m_level + 1));
+}
+
+// advance by one timestep, as a task per box
+
+int
+AMRDerivedClass::addAdvanceTasks (TaskGraph& a_graph, const Vector<int>& a_after)
+{
+  Vector<int> copies(a_after);
+  for (DataIterator dit = m_state_new.dataIterator(); dit.ok(); ++dit)
+  {
+    const DataIndex d = dit();
+    copies.push_back(a_graph.addTask([this, d]
+                                     {
+                                       m_state_old[d].copy(m_state_new[d]);
+                                       advanceBox(d);
+                                     },
+                                     a_after));
+  }
+
+  return a_graph.addTask([this] { m_time += m_dt; }, copies);
+}
+
 // things to do after a timestep
 
 void
@@ -695,6 +743,12 @@ AMRDerivedClass::computeInitialDt ()
   return m_dt;
 }
 
+const LevelData<FArrayBox>&
+AMRDerivedClass::state () const
+{
+  return m_state_new;
+}
+
 class AMRDerivedClassFactory : public AMRLevelFactory
 {
 public:
@@ -775,6 +829,144 @@ testAMR ()
 
   amr.conclude();
 
+  // the same run, with the level advances as tasks in three threads
+  {
+    AMR taskAmr;
+    taskAmr.define(max_level, ref_ratioes, prob_domain, &amrd_fact);
+    taskAmr.useTaskGraph(3);
+    taskAmr.setupForNewAMRRun();
+    taskAmr.run(8., 8);
+    taskAmr.conclude();
+
+    Vector<AMRLevel*> levels = amr.getAMRLevels();
+    Vector<AMRLevel*> taskLevels = taskAmr.getAMRLevels();
+    bool same = (taskAmr.getCurrentTime() == amr.getCurrentTime());
+    for (int lev = 0; lev < levels.size(); lev++)
+    {
+      same = same && (taskLevels[lev]->time() == levels[lev]->time()) &&
+        (taskLevels[lev]->dt() == levels[lev]->dt());
+
+      // the regrids are the same, so are the boxes in the same order
+      const LevelData<FArrayBox>& state =
+        dynamic_cast<AMRDerivedClass*>(levels[lev])->state();
+      const LevelData<FArrayBox>& taskState =
+        dynamic_cast<AMRDerivedClass*>(taskLevels[lev])->state();
+      same = same && (state.getBoxes().size() == taskState.getBoxes().size());
+      if (same)
+      {
+        DataIterator dit = state.dataIterator();
+        DataIterator tdit = taskState.dataIterator();
+        for (; dit.ok() && tdit.ok(); ++dit, ++tdit)
+        {
+          const FArrayBox& fab = state[dit];
+          const FArrayBox& taskFab = taskState[tdit];
+          same = same && (fab.box() == taskFab.box());
+          if (same)
+          {
+            FArrayBox diff(fab.box(), fab.nComp());
+            diff.copy(fab);
+            diff -= taskFab;
+            same = (diff.norm(0) == 0);
+          }
+        }
+      }
+      if (verbose)
+      {
+        pout() << indent2 << "level " << lev << " task graph data "
+               << (same ? "matches" : "differs") << endl;
+      }
+    }
+    if (!same)
+    {
+      pout() << indent << pgmname << ": the task graph run differs" << endl;
+      return 3;
+    }
+  }
+
+#ifdef CH_USE_HDF5
+  // the same run, writing its checkpoints synchronously and in the
+  // background; the files must hold the same data
+  if (numProc() == 1)
+    {
+      const char* prefixes[2] = {"syncchk", "asyncchk"};
+      for (int run = 0; run < 2; run++)
+        {
+          AMR outAmr;
+          outAmr.define(max_level, ref_ratioes, prob_domain, &amrd_fact);
+          outAmr.checkpointPrefix(prefixes[run]);
+          outAmr.checkpointInterval(2);
+          outAmr.asyncOutput(2*run);
+          outAmr.setupForNewAMRRun();
+          outAmr.run(8., 8);
+          outAmr.conclude();
+        }
+
+      for (int step = 0; step <= 8; step += 2)
+        {
+          HDF5Handle handles[2];
+          HDF5HeaderData headers[2];
+          for (int run = 0; run < 2; run++)
+            {
+              char filename[100];
+              sprintf(filename, "%s%06d.%dd.hdf5", prefixes[run], step, SpaceDim);
+              if (handles[run].open(filename, HDF5Handle::OPEN_RDONLY) != 0)
+                {
+                  pout() << indent << pgmname << ": could not open " << filename << endl;
+                  return 1;
+                }
+              headers[run].readFromFile(handles[run]);
+            }
+          if (headers[1].m_int["iteration"] != step ||
+              headers[1].m_int["num_levels"] != headers[0].m_int["num_levels"])
+            {
+              pout() << indent << pgmname << ": bad header in async checkpoint " << step << endl;
+              return 2;
+            }
+
+          for (int level = 0; level < headers[0].m_int["num_levels"]; level++)
+            {
+              char label[20];
+              sprintf(label, "level_%d", level);
+              Vector<Box> boxes[2];
+              for (int run = 0; run < 2; run++)
+                {
+                  handles[run].setGroup(label);
+                  read(handles[run], boxes[run]);
+                }
+              bool same = (boxes[0].stdVector() == boxes[1].stdVector());
+              Vector<int> procs(boxes[0].size(), 0);
+              DisjointBoxLayout grids(boxes[0], procs);
+              LevelData<FArrayBox> data[2];
+              for (int run = 0; same && run < 2; run++)
+                {
+                  read<FArrayBox>(handles[run], data[run], "data", grids);
+                }
+              for (DataIterator dit = grids.dataIterator(); same && dit.ok(); ++dit)
+                {
+                  const FArrayBox& syncFab = data[0][dit];
+                  const FArrayBox& asyncFab = data[1][dit];
+                  same = (syncFab.box() == asyncFab.box());
+                  for (BoxIterator bit(syncFab.box()); same && bit.ok(); ++bit)
+                    {
+                      for (int comp = 0; comp < syncFab.nComp(); comp++)
+                        {
+                          if (syncFab(bit(), comp) != asyncFab(bit(), comp)) same = false;
+                        }
+                    }
+                }
+              if (!same)
+                {
+                  pout() << indent << pgmname << ": async checkpoint " << step
+                         << " differs on level " << level << endl;
+                  return 3;
+                }
+            }
+          handles[0].close();
+          handles[1].close();
+        }
+    }
+#endif
+
   return 0 ;
 }
 
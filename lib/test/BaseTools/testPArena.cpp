@@ -0,0 +1,282 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include <thread>
+using std::endl;
+
+#include "parstream.H"
+#include "SPMD.H"
+#include "Arena.H"
+
+#include "UsingBaseNamespace.H"
+
+/// Prototypes:
+
+void
+parseTestOptions( int argc ,char* argv[] ) ;
+
+int
+testPArena();
+
+/// Global variables for handling output:
+static const char *pgmname = "testPArena" ;
+static const char *indent = "   ", *indent2 = "      " ;
+static bool verbose = true ;
+
+/// Code:
+
+int
+main(int argc, char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+  parseTestOptions( argc ,argv ) ;
+
+  if (verbose)
+    pout() << indent2 << "Beginning " << pgmname << " ..." << endl ;
+
+  ///
+  // Run the tests
+  ///
+  int ret = testPArena() ;
+
+  if (ret == 0)
+    {
+      if (verbose)
+        pout() << indent << pgmname << " passed all tests" << endl ;
+    }
+  else
+    {
+      pout() << indent << pgmname << " failed " << ret << " test(s)" << endl ;
+    }
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+  return ret;
+}
+
+// allocate, write, check and free blocks of assorted sizes
+static void allocFree(PArena* a_arena, int* a_errors, int a_seed)
+{
+  std::vector<int*> blocks;
+  for (int i = 0; i < 2000; i++)
+    {
+      size_t sz = 64 + 37*((i + 7*(a_seed + 1))%50);
+      int* p = (int*)a_arena->alloc(sz);
+      p[0] = i;
+      p[1] = a_seed;
+      blocks.push_back(p);
+      if (i%4 == 3)
+        {
+          // free some from the middle, so blocks change hands
+          for (int k = 0; k < 3; k++)
+            {
+              int* q = blocks[blocks.size()/2];
+              if (q[1] != a_seed) (*a_errors)++;
+              a_arena->free(q);
+              blocks.erase(blocks.begin() + blocks.size()/2);
+            }
+        }
+    }
+  for (unsigned int i = 0; i < blocks.size(); i++)
+    {
+      if (blocks[i][1] != a_seed) (*a_errors)++;
+      a_arena->free(blocks[i]);
+    }
+}
+
+int testPArena()
+{
+  int status = 0;
+  const size_t maxPooled = 1024*1024;
+  PArena arena("test", maxPooled);
+
+  // size classes cover their requests, with less than 25% waste
+  for (size_t sz = 1; sz <= maxPooled; sz += 1 + sz/7)
+    {
+      int c = arena.sizeClass(sz);
+      size_t csz = PArena::classSize(c);
+      if (c < 0 || csz < sz || (sz > 256 && 4*(csz - sz) >= csz))
+        {
+          pout() << indent << "bad size class " << c << " for " << sz << " bytes" << endl;
+          status += 1;
+          break;
+        }
+    }
+  if (arena.sizeClass(maxPooled + 1) != -1)
+    {
+      pout() << indent << "request over the pool limit was pooled" << endl;
+      status += 1;
+    }
+
+  // blocks are aligned, usable and reused after free
+  const int nblocks = 40;
+  std::vector<void*> blocks(nblocks);
+  for (int i = 0; i < nblocks; i++)
+    {
+      size_t sz = 100 + 997*i;
+      blocks[i] = arena.alloc(sz);
+      if (((size_t)blocks[i]) % PArena::Alignment != 0)
+        {
+          pout() << indent << "block " << i << " is not aligned" << endl;
+          status += 1;
+        }
+      memset(blocks[i], i, sz);
+    }
+  for (int i = 0; i < nblocks; i++)
+    {
+      const unsigned char* p = (const unsigned char*)blocks[i];
+      if (p[0] != i || p[99 + 997*i] != i)
+        {
+          pout() << indent << "block " << i << " was overwritten" << endl;
+          status += 1;
+        }
+    }
+  if (arena.pooledBytes() != 0)
+    {
+      pout() << indent << "pool not empty before any free" << endl;
+      status += 1;
+    }
+  for (int i = 0; i < nblocks; i++)
+    {
+      arena.free(blocks[i]);
+    }
+  size_t pooled = arena.pooledBytes();
+  if (pooled == 0)
+    {
+      pout() << indent << "freed blocks were not pooled" << endl;
+      status += 1;
+    }
+  void* again = arena.alloc(100 + 997*(nblocks-1));
+  if (again != blocks[nblocks-1])
+    {
+      pout() << indent << "freed block was not reused" << endl;
+      status += 1;
+    }
+  arena.free(again);
+  if (arena.pooledBytes() != pooled)
+    {
+      pout() << indent << "pooled bytes changed by alloc/free" << endl;
+      status += 1;
+    }
+
+  // large blocks bypass the pool
+  void* large = arena.alloc(2*maxPooled);
+  memset(large, 0, 2*maxPooled);
+  arena.free(large);
+  if (arena.pooledBytes() != pooled)
+    {
+      pout() << indent << "large block was pooled" << endl;
+      status += 1;
+    }
+
+  arena.release();
+  if (arena.pooledBytes() != 0)
+    {
+      pout() << indent << "release did not empty the pool" << endl;
+      status += 1;
+    }
+
+  // many threads allocating and freeing at once
+  const int nloop = 1000;
+  int errors = 0;
+#pragma omp parallel for reduction(+:errors)
+  for (int i = 0; i < nloop; i++)
+    {
+      size_t sz = 64 + 37*(i%50);
+      int* p = (int*)arena.alloc(sz);
+      p[0] = i;
+      if (i%3 != 0)
+        {
+          int* q = (int*)arena.alloc(sz);
+          q[0] = -i;
+          if (p[0] != i) errors++;
+          arena.free(q);
+        }
+      if (p[0] != i) errors++;
+      arena.free(p);
+    }
+  if (errors != 0)
+    {
+      pout() << indent << errors << " errors in threaded alloc/free" << endl;
+      status += 1;
+    }
+
+  // threads OpenMP does not know of, such as TaskGraph workers, alongside
+  // this one; their cached blocks go back to the pool when they exit
+  arena.release();
+  std::vector<int> threadErrors(4, 0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < (int)threadErrors.size(); t++)
+    {
+      threads.push_back(std::thread(allocFree, &arena, &(threadErrors[t]), t));
+    }
+  int mainErrors = 0;
+  allocFree(&arena, &mainErrors, -1);
+  for (unsigned int t = 0; t < threads.size(); t++)
+    {
+      threads[t].join();
+      mainErrors += threadErrors[t];
+    }
+  if (mainErrors != 0)
+    {
+      pout() << indent << mainErrors << " errors in alloc/free from std::threads" << endl;
+      status += 1;
+    }
+  if (arena.pooledBytes() == 0)
+    {
+      pout() << indent << "exited threads lost their cached blocks" << endl;
+      status += 1;
+    }
+  arena.release();
+  if (arena.pooledBytes() != 0)
+    {
+      pout() << indent << "release did not empty the pool after threads" << endl;
+      status += 1;
+    }
+  return status;
+}
+
+///
+// Parse the standard test options (-v -q) out of the command line.
+// Stop parsing when a non-option argument is found.
+///
+void
+parseTestOptions( int argc ,char* argv[] )
+{
+  for ( int i = 1 ; i < argc ; ++i )
+    {
+      if (argv[i][0] == '-') //if it is an option
+        {
+          // compare 3 chars to differentiate -x from -xx
+          if (strncmp( argv[i] ,"-v" ,3 ) == 0)
+            {
+              verbose = true ;
+              // argv[i] = "" ;
+            }
+          else if (strncmp( argv[i] ,"-q" ,3 ) == 0)
+            {
+              verbose = false ;
+              // argv[i] = "" ;
+            }
+          else
+            {
+              break ;
+            }
+        }
+    }
+  return ;
+}
+
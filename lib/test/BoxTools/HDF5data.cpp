@@ -25,6 +25,7 @@
 #include "LoadBalance.H"
 #include "DebugDump.H"
 #include "UGIO.H"
+#include "AMRIO.H"
 #include "TestCommon.H"
 #include "UsingNamespace.H"
 
@@ -456,6 +457,240 @@ int test()
 
  CH_assert(!testFile.isOpen());
 
+  // the aggregated, aligned write gives a file readLevel reads the same
+  CH_HDF5::setWriteAggregators(2);
+  CH_HDF5::setWriteAlignment(4096);
+  CH_HDF5::setReportWriteBandwidth(verbose);
+  error = testFile.open("aggregated.h5", HDF5Handle::CREATE);
+  if (error != 0)
+    {
+      if ( verbose )
+        pout() << indent2 << "aggregated file open failed "<<error<<endl;
+      return error;
+    }
+  error = writeLevel(testFile, 0, state, 2, 1, 0.001, b2, 2);
+  testFile.close();
+  CH_HDF5::setWriteAggregators(0);
+  CH_HDF5::setWriteAlignment(0);
+  CH_HDF5::setReportWriteBandwidth(false);
+  if (error != 0 || CH_HDF5::lastWriteBandwidth() <= 0)
+    {
+      if ( verbose )
+        pout() << indent2 << "aggregated writeLevel failed "<<error<<endl;
+      return 4;
+    }
+
+  LevelData<FArrayBox> readAggregated;
+  testFile.open("aggregated.h5", HDF5Handle::OPEN_RDONLY);
+  error = readLevel(testFile, 0, readAggregated, dx, dt, time, b2, refRatio);
+  testFile.close();
+  if (error != 0)
+    {
+      if ( verbose )
+        pout() << indent2 << "aggregated readLevel failed "<<error<<endl;
+      return error;
+    }
+  LevelData<FArrayBox> aggregated(state.disjointBoxLayout(), state.nComp());
+  readAggregated.copyTo(aggregated);
+  for (DataIterator dit(state.dataIterator()); dit.ok(); ++dit)
+    {
+      for (BoxIterator it(state.box(dit())); it.ok(); ++it)
+        {
+          for (int c=0; c<state.nComp(); ++c)
+            {
+              if (aggregated[dit()](it(), c) != state[dit()](it(), c))
+                {
+                  if ( verbose )
+                    pout() << indent2 << "state != aggregated read"<<endl;
+                  return 4;
+                }
+            }
+        }
+    }
+
+  // compressed plot files: deflate alone is exact, the mantissa bits and
+  // floats stay within their bound, and both read back as usual
+  LevelData<FArrayBox> smooth(plan2, 2);
+  for (DataIterator dit(smooth.dataIterator()); dit.ok(); ++dit)
+    {
+      for (BoxIterator it(smooth.box(dit())); it.ok(); ++it)
+        {
+          for (int c=0; c<2; ++c)
+            {
+              smooth[dit()](it(), c) = 1.0/(1.0 + it()[0] + c) + 0.001*it()[SpaceDim-1];
+            }
+        }
+    }
+  Vector<DisjointBoxLayout> plotGrids(1, plan2);
+  Vector<LevelData<FArrayBox>* > plotData(1, &smooth);
+  Vector<string> plotNames(2);
+  plotNames[0] = "u";
+  plotNames[1] = "v";
+  Vector<int> plotRatio(1, 2);
+  for (int lossy=0; lossy<2; ++lossy)
+    {
+      HDF5Compression compression;
+      compression.m_deflate = 6;
+      if (lossy)
+        {
+          compression.m_float = true;
+          compression.m_mantissaBits.push_back(10);
+          compression.m_mantissaBits.push_back(20);
+        }
+      CH_HDF5::setPlotCompression(compression);
+      WriteAMRHierarchyHDF5("compressed.h5", plotGrids, plotData, plotNames,
+                            b2, 1.0, 0.1, 0.0, plotRatio, 1);
+      CH_HDF5::setPlotCompression(HDF5Compression());
+
+      Vector<DisjointBoxLayout> readGrids;
+      Vector<LevelData<FArrayBox>* > readData;
+      Vector<string> readNames;
+      Box readDomain;
+      Real readDx, readDt, readTime;
+      Vector<int> readRatio;
+      int readLevels;
+      error = ReadAMRHierarchyHDF5("compressed.h5", readGrids, readData, readNames,
+                                   readDomain, readDx, readDt, readTime,
+                                   readRatio, readLevels);
+      if (error != 0 || readLevels != 1)
+        {
+          if ( verbose )
+            pout() << indent2 << "compressed read failed "<<error<<endl;
+          return 5;
+        }
+      if (lossy)
+        {
+          // stored as compressed floats
+          testFile.open("compressed.h5", HDF5Handle::OPEN_RDONLY);
+          testFile.setGroupToLevel(0);
+#ifdef H516
+          hid_t dataset = H5Dopen(testFile.groupID(), "data:datatype=0");
+#else
+          hid_t dataset = H5Dopen2(testFile.groupID(), "data:datatype=0", H5P_DEFAULT);
+#endif
+          hid_t type = H5Dget_type(dataset);
+          hid_t space = H5Dget_space(dataset);
+          bool stored = (H5Tget_size(type) == sizeof(float) &&
+                         H5Dget_storage_size(dataset) < H5Sget_simple_extent_npoints(space)*sizeof(float));
+          H5Sclose(space);
+          H5Tclose(type);
+          H5Dclose(dataset);
+          testFile.close();
+          if (!stored)
+            {
+              if ( verbose )
+                pout() << indent2 << "plot data not stored as compressed floats"<<endl;
+              return 5;
+            }
+        }
+      LevelData<FArrayBox> compressed(plan2, 2);
+      readData[0]->copyTo(compressed);
+      delete readData[0];
+      for (DataIterator dit(smooth.dataIterator()); dit.ok(); ++dit)
+        {
+          for (BoxIterator it(smooth.box(dit())); it.ok(); ++it)
+            {
+              for (int c=0; c<2; ++c)
+                {
+                  Real exact = smooth[dit()](it(), c);
+                  Real bound = lossy ? std::abs(exact)*pow(2.0, -compression.mantissaBits(c)-1) : 0;
+                  if (std::abs(compressed[dit()](it(), c) - exact) > bound)
+                    {
+                      if ( verbose )
+                        pout() << indent2 << "compressed != smooth, lossy = "<<lossy<<endl;
+                      return 5;
+                    }
+                }
+            }
+        }
+    }
+
+  // slab reads, of all components or some, give the same data
+  CH_HDF5::setSlabRead(true);
+  for (int some=0; some<2; ++some)
+    {
+      Interval slabComps = some ? Interval(1,2) : Interval();
+      LevelData<FArrayBox> slabState;
+      testFile.open("data.h5", HDF5Handle::OPEN_RDONLY);
+      error = readLevel(testFile, 0, slabState, dx, dt, time, b2, refRatio, slabComps);
+      testFile.close();
+      if (error != 0)
+        {
+          if ( verbose )
+            pout() << indent2 << "slab readLevel failed "<<error<<endl;
+          return error;
+        }
+      int first = some ? 1 : 0;
+      LevelData<FArrayBox> slab(state.disjointBoxLayout(), slabState.nComp());
+      slabState.copyTo(slab);
+      for (DataIterator dit(state.dataIterator()); dit.ok(); ++dit)
+        {
+          for (BoxIterator it(state.box(dit())); it.ok(); ++it)
+            {
+              for (int c=0; c<slab.nComp(); ++c)
+                {
+                  if (slab[dit()](it(), c) != state[dit()](it(), c + first))
+                    {
+                      if ( verbose )
+                        pout() << indent2 << "state != slab read"<<endl;
+                      CH_HDF5::setSlabRead(false);
+                      return 6;
+                    }
+                }
+            }
+        }
+    }
+
+  // in parallel, a layout that puts every box on another processor than
+  // the one that wrote it, so the slabs have to move to be read
+  {
+    const DisjointBoxLayout& written = state.disjointBoxLayout();
+    Vector<Box> boxes;
+    Vector<int> procs;
+    for (LayoutIterator lit = written.layoutIterator(); lit.ok(); ++lit)
+      {
+        boxes.push_back(written[lit()]);
+        procs.push_back((written.procID(lit()) + 1) % numProc());
+      }
+    DisjointBoxLayout moved(boxes, procs, written.physDomain());
+    LevelData<FArrayBox> movedState;
+    testFile.open("data.h5", HDF5Handle::OPEN_RDONLY);
+    testFile.setGroup("/level_0");
+    Vector<Box> fileBoxes;
+    error = read(testFile, fileBoxes);
+    if (error == 0)
+      {
+        error = read<FArrayBox>(testFile, movedState, "data", moved, Interval(), true);
+      }
+    testFile.close();
+    if (error != 0 || fileBoxes.size() != boxes.size())
+      {
+        if ( verbose )
+          pout() << indent2 << "slab read to another layout failed "<<error<<endl;
+        CH_HDF5::setSlabRead(false);
+        return 7;
+      }
+    LevelData<FArrayBox> back(written, movedState.nComp());
+    movedState.copyTo(back);
+    for (DataIterator dit(state.dataIterator()); dit.ok(); ++dit)
+      {
+        for (BoxIterator it(state.box(dit())); it.ok(); ++it)
+          {
+            for (int c=0; c<state.nComp(); ++c)
+              {
+                if (back[dit()](it(), c) != state[dit()](it(), c))
+                  {
+                    if ( verbose )
+                      pout() << indent2 << "state != slab read to another layout"<<endl;
+                    CH_HDF5::setSlabRead(false);
+                    return 7;
+                  }
+              }
+          }
+      }
+  }
+  CH_HDF5::setSlabRead(false);
+
 #endif // CH_USE_HDF5
 
   return 0;
@@ -0,0 +1,211 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include <cstring>
+#include <set>
+
+#include "REAL.H"
+#include "Vector.H"
+#include "DataIterator.H"
+#include "DisjointBoxLayout.H"
+#include "ProblemDomain.H"
+#include "BRMeshRefine.H"
+#include "LoadBalance.H"
+#include "BoxIterator.H"
+#include "LevelData.H"
+#include "FArrayBox.H"
+#include "ExchangeGroup.H"
+
+#ifdef CH_MPI
+#include "mpi.h"
+#endif
+#include "UsingNamespace.H"
+
+/// Prototypes:
+void
+parseTestOptions( int argc ,char* argv[] );
+
+int testExchangeGroup(bool a_splitPhase);
+
+/// Global variables for handling output:
+static const char *pgmname = "exchangeGroupTest";
+static const char *indent2 = "      ";
+static bool verbose = true;
+
+/// Code:
+int main(int argc, char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+  parseTestOptions(argc,argv);
+
+  if ( verbose ) pout() << indent2 << "Beginning " << pgmname << " ..." << endl;
+
+  int ret = testExchangeGroup(false);
+  if (ret == 0)
+    {
+      ret = testExchangeGroup(true);
+    }
+  if (ret == 0)
+    {
+      pout() << indent2 << pgmname << " passed." << endl;
+    }
+  else
+    {
+      pout() << indent2 << pgmname << " failed with return code " << ret << endl;
+    }
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+  return ret;
+}
+
+// value of valid cell a_iv, component a_comp
+template <class T>
+void setValid(LevelData<T>& a_data, int a_pass)
+{
+  const DisjointBoxLayout& grids = a_data.disjointBoxLayout();
+  for (DataIterator dit = grids.dataIterator(); dit.ok(); ++dit)
+    {
+      a_data[dit()].setVal(-1);
+      for (BoxIterator bit(grids[dit()]); bit.ok(); ++bit)
+        {
+          for (int comp = 0; comp < a_data.nComp(); comp++)
+            {
+              a_data[dit()](bit(), comp) = bit()[0] + 100*bit()[1] + 10000*comp + a_pass;
+            }
+        }
+    }
+}
+
+template <class T>
+int compare(const LevelData<T>& a_data, const LevelData<T>& a_ref)
+{
+  for (DataIterator dit = a_data.dataIterator(); dit.ok(); ++dit)
+    {
+      for (BoxIterator bit(a_data[dit()].box()); bit.ok(); ++bit)
+        {
+          for (int comp = 0; comp < a_data.nComp(); comp++)
+            {
+              if (a_data[dit()](bit(), comp) != a_ref[dit()](bit(), comp))
+                {
+                  pout() << "value at " << bit() << " comp " << comp << " looks wrong" << endl;
+                  return -1;
+                }
+            }
+        }
+    }
+  return 0;
+}
+
+// exchange three LevelData with different types, ghost widths and
+// Copiers (one periodic) as a group, and compare with separate exchanges
+int testExchangeGroup(bool a_splitPhase)
+{
+  int domsize = 32;
+  int maxbox = 8;
+  Box bigBox = Box(IntVect::Zero, (domsize-1)*IntVect::Unit);
+  bool periodic[SpaceDim];
+  for (int idir = 0; idir < SpaceDim; idir++) periodic[idir] = (idir == 0);
+  ProblemDomain domain(bigBox, periodic);
+  Vector<Box> boxes;
+  domainSplit(domain, boxes, maxbox, maxbox);
+  Vector<int> ranks;
+  LoadBalance(ranks, boxes);
+  DisjointBoxLayout grids(boxes, ranks, domain);
+
+  IntVect ghostA = 2*IntVect::Unit;
+  IntVect ghostB = IntVect::Unit;
+  IntVect ghostC = 3*IntVect::Unit;
+  LevelData<FArrayBox>      a(grids, SpaceDim, ghostA), aRef(grids, SpaceDim, ghostA);
+  LevelData<FArrayBox>      b(grids, 1, ghostB),        bRef(grids, 1, ghostB);
+  LevelData<BaseFab<int> >  c(grids, 2, ghostC),        cRef(grids, 2, ghostC);
+
+  Copier copierA(grids, grids, domain, ghostA, true);
+  Copier copierB(grids, grids, ghostB, true);
+  Copier copierC(grids, grids, domain, ghostC, true);
+
+  ExchangeGroup group;
+  group.add(a, copierA);
+  group.add(b, copierB);
+  group.add(c, copierC, Interval(1,1));
+
+  // several passes, so the cached message layout gets reused
+  for (int pass = 1; pass <= 3; pass++)
+    {
+      setValid(a, pass); setValid(aRef, pass);
+      setValid(b, pass); setValid(bRef, pass);
+      setValid(c, pass); setValid(cRef, pass);
+      if (a_splitPhase)
+        {
+          group.exchangeBegin();
+          group.exchangeEnd();
+        }
+      else
+        {
+          group.exchange();
+        }
+      aRef.exchange(copierA);
+      bRef.exchange(copierB);
+      cRef.exchange(Interval(1,1), copierC);
+
+      if (compare(a, aRef) != 0) return -1;
+      if (compare(b, bRef) != 0) return -2;
+      if (compare(c, cRef) != 0) return -3;
+    }
+
+  // one message per neighboring processor, whatever the number of members
+  std::set<int> neighbors;
+  for (CopyIterator it(copierA, CopyIterator::FROM); it.ok(); ++it) neighbors.insert(it().procID);
+  for (CopyIterator it(copierB, CopyIterator::FROM); it.ok(); ++it) neighbors.insert(it().procID);
+  for (CopyIterator it(copierC, CopyIterator::FROM); it.ok(); ++it) neighbors.insert(it().procID);
+#ifdef CH_MPI
+  if (group.numMessages() != (int)neighbors.size())
+    {
+      pout() << "sent " << group.numMessages() << " messages to "
+             << neighbors.size() << " neighbors" << endl;
+      return -4;
+    }
+#endif
+  return 0;
+}
+
+///
+// Parse the standard test options (-v -q) out of the command line.
+// Stop parsing when a non-option argument is found.
+///
+void
+parseTestOptions( int argc ,char* argv[] )
+{
+  for ( int i = 1 ; i < argc ; ++i )
+  {
+    if ( argv[i][0] == '-' ) //if it is an option
+    {
+      // compare 3 chars to differentiate -x from -xx
+      if ( strncmp( argv[i] ,"-v" ,3 ) == 0 )
+      {
+        verbose = true ;
+        // argv[i] = "" ;
+      }
+      else if ( strncmp( argv[i] ,"-q" ,3 ) == 0 )
+      {
+        verbose = false ;
+        // argv[i] = "" ;
+      }
+      else
+      {
+        break ;
+      }
+    }
+  }
+  return ;
+}
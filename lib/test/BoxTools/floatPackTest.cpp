@@ -0,0 +1,196 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include <cstring>
+#include <cmath>
+
+#include "REAL.H"
+#include "Vector.H"
+#include "DataIterator.H"
+#include "DisjointBoxLayout.H"
+#include "ProblemDomain.H"
+#include "BRMeshRefine.H"
+#include "LoadBalance.H"
+#include "BoxIterator.H"
+#include "LevelData.H"
+#include "FArrayBox.H"
+#include "FloatPackOp.H"
+
+#ifdef CH_MPI
+#include "mpi.h"
+#endif
+#include "UsingNamespace.H"
+
+/// Prototypes:
+void
+parseTestOptions( int argc ,char* argv[] );
+
+int testFloatPack();
+
+/// Global variables for handling output:
+static const char *pgmname = "floatPackTest";
+static const char *indent2 = "      ";
+static bool verbose = true;
+
+/// Code:
+int main(int argc, char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+  parseTestOptions(argc,argv);
+
+  if ( verbose ) pout() << indent2 << "Beginning " << pgmname << " ..." << endl;
+
+  int ret = testFloatPack();
+  if (ret == 0)
+    {
+      pout() << indent2 << pgmname << " passed." << endl;
+    }
+  else
+    {
+      pout() << indent2 << pgmname << " failed with return code " << ret << endl;
+    }
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+  return ret;
+}
+
+static Real exactValue(const IntVect& a_iv, int a_comp)
+{
+  return 1.0/3.0 + a_iv[0] + 0.01*a_iv[1] + 100.0*a_comp;
+}
+
+static void setValid(LevelData<FArrayBox>& a_data)
+{
+  const DisjointBoxLayout& grids = a_data.disjointBoxLayout();
+  for (DataIterator dit = grids.dataIterator(); dit.ok(); ++dit)
+    {
+      a_data[dit()].setVal(-1.0);
+      for (BoxIterator bit(grids[dit()]); bit.ok(); ++bit)
+        {
+          for (int comp = 0; comp < a_data.nComp(); comp++)
+            {
+              a_data[dit()](bit(), comp) = exactValue(bit(), comp);
+            }
+        }
+    }
+}
+
+// compare the ghost cells inside the domain with the exact values:
+// a_exact demands bit-for-bit equality, otherwise single-precision accuracy
+static int checkGhosts(const LevelData<FArrayBox>& a_data, const Box& a_domain, bool a_exact)
+{
+  for (DataIterator dit = a_data.dataIterator(); dit.ok(); ++dit)
+    {
+      Box region = a_data[dit()].box() & a_domain;
+      for (BoxIterator bit(region); bit.ok(); ++bit)
+        {
+          for (int comp = 0; comp < a_data.nComp(); comp++)
+            {
+              Real exact = exactValue(bit(), comp);
+              Real value = a_data[dit()](bit(), comp);
+              if (a_exact ? (value != exact) : (std::abs(value - exact) > 1.0e-6*std::abs(exact)))
+                {
+                  pout() << "value at " << bit() << " comp " << comp << " looks wrong" << endl;
+                  return -1;
+                }
+            }
+        }
+    }
+  return 0;
+}
+
+int testFloatPack()
+{
+  int domsize = 32;
+  int maxbox = 8;
+  Box domain(IntVect::Zero, (domsize-1)*IntVect::Unit);
+  Vector<Box> boxes;
+  domainSplit(ProblemDomain(domain), boxes, maxbox, maxbox);
+  Vector<int> ranks;
+  LoadBalance(ranks, boxes);
+  DisjointBoxLayout grids(boxes, ranks);
+
+  IntVect ghost = 3*IntVect::Unit;
+  LevelData<FArrayBox> data(grids, 2, ghost);
+  Copier copier(grids, grids, ghost, true);
+
+  // alternate operators through the same Copier, so its cached buffers
+  // must follow the change in message size
+  for (int pass = 0; pass < 2; pass++)
+    {
+      // per call
+      setValid(data);
+      data.exchange(data.interval(), copier, FloatPackOp<FArrayBox>());
+      if (checkGhosts(data, domain, false) != 0) return -1;
+
+      // default operator is bit-exact
+      setValid(data);
+      data.exchange(data.interval(), copier);
+      if (checkGhosts(data, domain, true) != 0) return -2;
+
+      // per LevelData, through the split-phase exchange
+      data.setExchangeOp(RefCountedPtr<LDOperator<FArrayBox> >(new FloatPackOp<FArrayBox>()));
+      setValid(data);
+      data.exchangeBegin(copier);
+      data.exchangeEnd();
+      if (checkGhosts(data, domain, false) != 0) return -3;
+      data.setExchangeOp(RefCountedPtr<LDOperator<FArrayBox> >());
+
+      // each packing keeps its own message layout in the Copier, so
+      // alternating operators does not re-lay the buffers
+      const CopierBuffer& full  = copier.buffers(LDOperator<FArrayBox>().packing());
+      const CopierBuffer& half  = copier.buffers(FloatPackOp<FArrayBox>().packing());
+      if (&full == &half) return -4;
+      if (full.m_fromMe.size() != half.m_fromMe.size()) return -5;
+      for (unsigned int i = 0; i < full.m_fromMe.size(); i++)
+        {
+          if (half.m_fromMe[i].size*sizeof(Real) != full.m_fromMe[i].size*sizeof(float))
+            {
+              return -6;
+            }
+        }
+    }
+  return 0;
+}
+
+///
+// Parse the standard test options (-v -q) out of the command line.
+// Stop parsing when a non-option argument is found.
+///
+void
+parseTestOptions( int argc ,char* argv[] )
+{
+  for ( int i = 1 ; i < argc ; ++i )
+  {
+    if ( argv[i][0] == '-' ) //if it is an option
+    {
+      // compare 3 chars to differentiate -x from -xx
+      if ( strncmp( argv[i] ,"-v" ,3 ) == 0 )
+      {
+        verbose = true ;
+        // argv[i] = "" ;
+      }
+      else if ( strncmp( argv[i] ,"-q" ,3 ) == 0 )
+      {
+        verbose = false ;
+        // argv[i] = "" ;
+      }
+      else
+      {
+        break ;
+      }
+    }
+  }
+  return ;
+}
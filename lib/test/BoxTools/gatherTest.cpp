@@ -19,6 +19,7 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
 #ifdef CH_MPI
 #include "mpi.h"
 #endif
@@ -52,6 +53,9 @@ parseTestOptions( int argc ,char* argv[] ) ;
   10: values in vector<box> wrong
   11: size of vector<vector<box>> wrong
   12: values in vector<vector<box>> wrong
+  13: size of vector<IntVectSet> wrong
+  14: values in vector<IntVectSet> wrong
+  15: pieces gathered by gatherPieces wrong
   */
 int gatherTest(void);
 
@@ -104,6 +108,10 @@ Real realVal(Real input)
   Real rfactor = 42.0;
   return(rfactor*(input+1.0));
 }
+char byteVal(long long input)
+{
+  return (char)(7*input + 3);
+}
 Box boxVal(int input)
 {
   unsigned int icareful = abs(input);
@@ -454,6 +462,74 @@ int gatherTest()
               }
         }
     }
+  if (retflag == 0)
+    {
+      if (verbose)
+        pout () << indent2 << "testing gatherPieces " << endl;
+      // boxes of uneven sizes (some empty), dealt out backwards so that
+      // the boxes of a processor are not next to each other
+      const int numBoxes = 7*nProcess + 3;
+      Vector<long long> offsets(numBoxes + 1, 0);
+      Vector<int> procs(numBoxes);
+      for (int b = 0; b < numBoxes; b++)
+        {
+          offsets[b+1] = offsets[b] + (b*37)%23;
+          procs[b] = (numBoxes - 1 - b)%nProcess;
+        }
+      const long long total = offsets[numBoxes];
+      std::vector<char> local;
+      for (int b = 0; b < numBoxes; b++)
+        {
+          if (procs[b] != procID()) continue;
+          for (long long i = offsets[b]; i < offsets[b+1]; i++)
+            {
+              local.push_back(byteVal(i));
+            }
+        }
+      int errors = 0;
+      for (int numAggregators = 1; numAggregators <= nProcess; numAggregators++)
+        {
+          // in one round, and in rounds of small pieces
+          for (int rounds = 0; rounds < 2; rounds++)
+            {
+              const long long piece = rounds ? 5 : (total + numAggregators - 1)/numAggregators;
+              long long covered = 0;
+              for (long long start = 0; start < total; start += numAggregators*piece)
+                {
+                  std::vector<char> contiguous;
+                  long long lo, hi;
+                  gatherPieces(contiguous, lo, hi, (local.size() > 0) ? &(local[0]) : NULL,
+                               offsets, procs, piece, numAggregators, start);
+                  if ((long long)contiguous.size() != hi - lo) errors++;
+                  for (long long i = lo; errors == 0 && i < hi; i++)
+                    {
+                      if (contiguous[i - lo] != byteVal(i)) errors++;
+                    }
+                  covered += hi - lo;
+                }
+              // the pieces cover the array once
+#ifdef CH_MPI
+              long long mine = covered;
+              MPI_Allreduce(&mine, &covered, 1, MPI_LONG_LONG, MPI_SUM, Chombo_MPI::comm);
+#endif
+              if (covered != total) errors++;
+            }
+        }
+#ifdef CH_MPI
+      int myErrors = errors;
+      MPI_Allreduce(&myErrors, &errors, 1, MPI_INT, MPI_SUM, Chombo_MPI::comm);
+#endif
+      if (errors > 0)
+        {
+          if (verbose)
+            pout () << indent2 << "gatherTest: gatherPieces gave wrong pieces" << endl;
+          retflag = 15;
+        }
+      else if (verbose)
+        {
+          pout () << indent2 << "gatherPieces test passed." << endl;
+        }
+    }
 #ifdef CH_MPI
   //make sure all processors have the same return flag
   int rootProc = destProc;
@@ -32,7 +32,9 @@
 void
 parseTestOptions( int argc ,char* argv[] );
 
-int testExchange(void);
+int testExchange(bool a_splitPhase);
+
+int testNestedExchange();
 
 /// Global variables for handling output:
 static const char *pgmname = "interiorExchangeTest";
@@ -52,7 +54,7 @@ int main(int argc, char* argv[])
   ///
   // Run the tests
   ///
-  int ret = testExchange();
+  int ret = testExchange(false);
   if (ret == 0)
     {
       pout() << "exchange test passed" << endl;
@@ -61,6 +63,79 @@ int main(int argc, char* argv[])
     {
       pout() << "exchange test failed with code" << ret << endl;
     }
+
+  int retSplit = testExchange(true);
+  if (retSplit == 0)
+    {
+      pout() << "split-phase exchange test passed" << endl;
+    }
+  else
+    {
+      pout() << "split-phase exchange test failed with code" << retSplit << endl;
+      ret = retSplit;
+    }
+
+  // reuse the same Copiers through persistent MPI requests
+  CopierBuffer::s_persistentRequests = true;
+  int retPersistent = testExchange(false);
+  if (retPersistent == 0)
+    {
+      retPersistent = testExchange(true);
+    }
+  CopierBuffer::s_persistentRequests = false;
+  if (retPersistent == 0)
+    {
+      pout() << "persistent-request exchange test passed" << endl;
+    }
+  else
+    {
+      pout() << "persistent-request exchange test failed with code" << retPersistent << endl;
+      ret = retPersistent;
+    }
+
+  // the same exchanges as one neighborhood collective per Copier
+  CopierBuffer::s_messageBackend = CopierBuffer::NEIGHBOR_COLLECTIVE;
+  int retNeighbor = testExchange(false);
+  if (retNeighbor == 0)
+    {
+      retNeighbor = testExchange(true);
+    }
+  if (retNeighbor == 0)
+    {
+      retNeighbor = testNestedExchange();
+    }
+  CopierBuffer::s_messageBackend = CopierBuffer::POINT_TO_POINT;
+  if (retNeighbor == 0)
+    {
+      pout() << "neighbor-collective exchange test passed" << endl;
+    }
+  else
+    {
+      pout() << "neighbor-collective exchange test failed with code" << retNeighbor << endl;
+      ret = retNeighbor;
+    }
+
+  // on-node messages through MPI-3 shared-memory windows
+  CopierBuffer::s_sharedMemory = 1;
+  int retShared = testExchange(false);
+  if (retShared == 0)
+    {
+      retShared = testExchange(true);
+    }
+  if (retShared == 0)
+    {
+      retShared = testNestedExchange();
+    }
+  CopierBuffer::s_sharedMemory = 0;
+  if (retShared == 0)
+    {
+      pout() << "shared-memory exchange test passed" << endl;
+    }
+  else
+    {
+      pout() << "shared-memory exchange test failed with code" << retShared << endl;
+      ret = retShared;
+    }
 #ifdef CH_MPI
   MPI_Finalize();
 #endif
@@ -69,71 +144,38 @@ int main(int argc, char* argv[])
 }
 
 
-int testExchange(void)
+// set each component to -a_pass below the midpoint in its direction and
+// a_pass above it
+static void setQuadrants(LevelData< BaseFab<int> >& a_data, int a_midpt, int a_pass)
 {
-
-  int domsize = 32;
-  int maxbox = 16;
-  Box bigBox = Box(IntVect::Zero, (domsize-1)*IntVect::Unit);
-  ProblemDomain baseLevelDomain(bigBox);
-  ProblemDomain dom2;
-  dom2.define(baseLevelDomain);
-  Vector<Box> baseLevelBoxes;
-  domainSplit(baseLevelDomain, baseLevelBoxes, maxbox, maxbox);
-
-  const int numLevels = 1;
-  Vector<int> ranks;
-  for (int ilev = 0; ilev < numLevels; ilev++)
-    {
-      LoadBalance(ranks, baseLevelBoxes);
-    }
-
-  DisjointBoxLayout grids(baseLevelBoxes, ranks);
-  int nghost = 4;
-  LevelData< BaseFab<int> > data(grids, SpaceDim, nghost*IntVect::Unit);
-
-  //set the data on the boxes according to which quadrant it is in
-  int midpt = domsize/2;
+  const DisjointBoxLayout& grids = a_data.disjointBoxLayout();
   for (DataIterator dit = grids.dataIterator(); dit.ok(); ++dit)
     {
+      a_data[dit()].setVal(0);
       for (BoxIterator bit(grids[dit()]); bit.ok(); ++bit)
         {
           for (int idir = 0; idir < SpaceDim; idir++)
             {
-              int  val = 0;
-              if (bit()[idir] < midpt)
-                {
-                  val = -1;
-                }
-              else
-                {
-                  val = 1;
-                }
-              data[dit()](bit(), idir) = val;
+              a_data[dit()](bit(), idir) = (bit()[idir] < a_midpt) ? -a_pass : a_pass;
             }
         }
     }
-  //exchange the data to fill the ghost cells
-  data.exchange();
-  //check the answer
-  for (DataIterator dit = grids.dataIterator(); dit.ok(); ++dit)
+}
+
+// check that the exchange filled the ghost cells inside a_domain
+static int checkQuadrants(const LevelData< BaseFab<int> >& a_data, const Box& a_domain,
+                          int a_midpt, int a_pass)
+{
+  for (DataIterator dit = a_data.dataIterator(); dit.ok(); ++dit)
     {
-      Box grownBox = data[dit()].box();
-      grownBox &= baseLevelDomain;
+      Box grownBox = a_data[dit()].box();
+      grownBox &= a_domain;
       for (BoxIterator bit(grownBox); bit.ok(); ++bit)
         {
           for (int idir = 0; idir < SpaceDim; idir++)
             {
-              int  val = 0;
-              if (bit()[idir] < midpt)
-                {
-                  val = -1;
-                }
-              else
-                {
-                  val = 1;
-                }
-              if (data[dit()](bit(), idir) != val)
+              int val = (bit()[idir] < a_midpt) ? -a_pass : a_pass;
+              if (a_data[dit()](bit(), idir) != val)
                 {
                   pout() << "value at " << bit() << "looks wrong" << endl;
                   return -42;
@@ -144,6 +186,80 @@ int testExchange(void)
   return 0;
 }
 
+static DisjointBoxLayout testGrids(int a_domsize, int a_maxbox)
+{
+  Box bigBox = Box(IntVect::Zero, (a_domsize-1)*IntVect::Unit);
+  ProblemDomain baseLevelDomain(bigBox);
+  Vector<Box> baseLevelBoxes;
+  domainSplit(baseLevelDomain, baseLevelBoxes, a_maxbox, a_maxbox);
+  Vector<int> ranks;
+  LoadBalance(ranks, baseLevelBoxes);
+  return DisjointBoxLayout(baseLevelBoxes, ranks);
+}
+
+int testExchange(bool a_splitPhase)
+{
+
+  int domsize = 32;
+  int maxbox = 16;
+  Box bigBox = Box(IntVect::Zero, (domsize-1)*IntVect::Unit);
+  DisjointBoxLayout grids = testGrids(domsize, maxbox);
+  int nghost = 4;
+  LevelData< BaseFab<int> > data(grids, SpaceDim, nghost*IntVect::Unit);
+  Copier copier(grids, grids, nghost*IntVect::Unit, true);
+
+  // several passes with different data through the same Copier, so that
+  // any message state cached between exchanges gets exercised
+  int midpt = domsize/2;
+  for (int pass = 1; pass <= 3; pass++)
+    {
+      //set the data on the boxes according to which quadrant it is in
+      setQuadrants(data, midpt, pass);
+      //exchange the data to fill the ghost cells
+      if (a_splitPhase)
+        {
+          data.exchangeBegin(data.interval(), copier);
+          data.exchangeEnd();
+        }
+      else
+        {
+          data.exchange();
+        }
+      //check the answer
+      int ret = checkQuadrants(data, bigBox, midpt, pass);
+      if (ret != 0) return ret;
+    }
+  return 0;
+}
+
+// a full exchange through one Copier between the begin and end of a
+// split-phase exchange through another, as when ghost cells are filled by
+// interpolation while an exchange is in flight
+int testNestedExchange()
+{
+  int domsize = 32;
+  int maxbox = 8;
+  Box bigBox = Box(IntVect::Zero, (domsize-1)*IntVect::Unit);
+  DisjointBoxLayout grids = testGrids(domsize, maxbox);
+  LevelData< BaseFab<int> > outer(grids, SpaceDim, 2*IntVect::Unit);
+  LevelData< BaseFab<int> > inner(grids, SpaceDim, IntVect::Unit);
+  Copier outerCopier;
+  outerCopier.exchangeDefine(grids, 2*IntVect::Unit);
+  int midpt = domsize/2;
+  for (int pass = 1; pass <= 3; pass++)
+    {
+      setQuadrants(outer, midpt, pass);
+      setQuadrants(inner, midpt, -pass);
+      outer.exchangeBegin(outerCopier);
+      inner.exchange();
+      outer.exchangeEnd();
+      int ret = checkQuadrants(outer, bigBox, midpt, pass);
+      if (ret == 0) ret = checkQuadrants(inner, bigBox, midpt, -pass);
+      if (ret != 0) return ret;
+    }
+  return 0;
+}
+
 ///
 // Parse the standard test options (-v -q) out of the command line.
 // Stop parsing when a non-option argument is found.
@@ -0,0 +1,246 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include <iostream>
+#include <cstring>
+
+using std::endl;
+
+#include "Box.H"
+#include "BoxIterator.H"
+#include "BoxLayout.H"
+#include "BoxCostModel.H"
+#include "LoadBalance.H"
+#include "SPMD.H"
+#include "parstream.H"
+#ifdef CH_MPI
+#include "mpi.h"
+#endif
+#include "UsingNamespace.H"
+
+/// Prototypes:
+
+void
+parseTestOptions( int argc ,char* argv[] ) ;
+
+int
+testBoxCostModel();
+
+/// Global variables for handling output:
+static const char *pgmname = "testBoxCostModel" ;
+static const char *indent = "   ", *indent2 = "      " ;
+static bool verbose = true ;
+
+/// Code:
+
+int
+main(int argc, char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+  parseTestOptions( argc ,argv ) ;
+
+  if ( verbose )
+    pout() << indent2 << "Beginning " << pgmname << " ..." << endl ;
+
+  int ret = testBoxCostModel() ;
+
+  if ( ret == 0 )
+    {
+      pout() << indent << pgmname << " passed all tests" << endl ;
+    }
+  else
+    {
+      pout() << indent << pgmname << " failed " << ret << " test(s)" << endl ;
+    }
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+  return ret;
+}
+
+static void
+check(bool a_ok, const char* a_what, int& a_failures)
+{
+  int ok = a_ok ? 1 : 0;
+#ifdef CH_MPI
+  int allOk;
+  MPI_Allreduce(&ok, &allOk, 1, MPI_INT, MPI_MIN, Chombo_MPI::comm);
+  ok = allOk;
+#endif
+  if (!ok)
+    {
+      a_failures++;
+      pout() << indent << pgmname << ": failed " << a_what << endl;
+    }
+  else if (verbose)
+    {
+      pout() << indent2 << a_what << " ok" << endl;
+    }
+}
+
+// the 8^D blocks of [0,63]^D
+static Vector<Box>
+blocks()
+{
+  Vector<Box> boxes;
+  Box blockBox(IntVect::Zero, 7*IntVect::Unit);
+  for (BoxIterator bit(blockBox); bit.ok(); ++bit)
+    {
+      boxes.push_back(Box(8*bit(), 8*bit() + 7*IntVect::Unit));
+    }
+  return boxes;
+}
+
+// cells with index in direction 0 below 16 cost ten times the others
+static unsigned long long
+ticks(const Box& a_box)
+{
+  return (a_box.smallEnd(0) < 16 ? 10 : 1)*a_box.numPts();
+}
+
+static bool
+near(Real a_x, Real a_y)
+{
+  return Abs(a_x - a_y) <= 1.0e-6*Abs(a_y);
+}
+
+int
+testBoxCostModel()
+{
+  int failures = 0;
+  Vector<Box> oldBoxes = blocks();
+  Vector<int> oldProcs;
+  LoadBalance(oldProcs, oldBoxes);
+  BoxLayout oldGrids(oldBoxes, oldProcs);
+
+  BoxCostModel model(oldGrids);
+
+  // without measurements the loads are the numbers of cells
+  {
+    Vector<long long> loads;
+    model.computeLoads(loads, oldBoxes);
+    bool ok = true;
+    for (int i = 0; i < oldBoxes.size(); i++)
+      {
+        if (loads[i] != oldBoxes[i].numPts()) ok = false;
+      }
+    check(ok, "unmeasured loads", failures);
+  }
+
+  // TimedDataIterator times end up in the model
+  {
+    TimedDataIterator dit = oldGrids.timedDataIterator();
+    dit.clearTime();
+    dit.enableTime();
+    for (dit.begin(); dit.ok(); ++dit)
+      {
+        int n = 0;
+        for (BoxIterator bit(oldGrids[dit]); bit.ok(); ++bit) n++;
+        CH_assert(n == oldGrids[dit].numPts());
+      }
+    dit.disableTime();
+    model.accumulate(dit);
+    Vector<long long> loads;
+    model.computeLoads(loads, oldBoxes);
+    bool ok = (loads.size() == oldBoxes.size());
+    for (int i = 0; i < loads.size(); i++)
+      {
+        if (loads[i] < 1) ok = false;
+      }
+    check(ok, "accumulate(TimedDataIterator)", failures);
+  }
+
+  // measured times map onto new boxes by overlap; new boxes straddle the
+  // expensive region and stick out of the old layout
+  model.clearTime();
+  for (DataIterator dit = oldGrids.dataIterator(); dit.ok(); ++dit)
+    {
+      model.addTime(dit(), ticks(oldGrids[dit]));
+      // a second step adds to the first
+      model.addTime(dit(), ticks(oldGrids[dit]));
+    }
+  Box domain(IntVect::Zero, 63*IntVect::Unit);
+  Vector<Box> newBoxes;
+  for (int lo = 4; lo < 68; lo += 16)
+    {
+      Box slab(domain);
+      slab.setRange(0, lo, 16);
+      newBoxes.push_back(slab);
+    }
+  Vector<long long> loads;
+  model.computeLoads(loads, newBoxes);
+  {
+    // cost of the slices of width one in direction 0; the cells beyond 63
+    // cost the average, (16*10 + 48)/64 per cell
+    Real expected[4] = {12*10 + 4, 16, 16, 12 + 4*(16*10 + 48)/64.0};
+    bool ok = true;
+    for (int i = 0; i < 4; i++)
+      {
+        if (!near(Real(loads[i])/Real(loads[1]), expected[i]/expected[1])) ok = false;
+      }
+    check(ok, "computeLoads", failures);
+  }
+
+  // balancing by measured cost gives every processor about the same time
+  if (numProc() > 1)
+    {
+      Vector<long long> blockLoads;
+      model.computeLoads(blockLoads, oldBoxes);
+      Vector<int> procs;
+      LoadBalance(procs, blockLoads, oldBoxes);
+      Vector<Real> cost(numProc(), 0.0);
+      Real total = 0;
+      for (int i = 0; i < oldBoxes.size(); i++)
+        {
+          cost[procs[i]] += ticks(oldBoxes[i]);
+          total += ticks(oldBoxes[i]);
+        }
+      Real maxCost = 0;
+      for (int p = 0; p < numProc(); p++)
+        {
+          maxCost = Max(maxCost, cost[p]);
+        }
+      check(maxCost <= 1.1*total/numProc(), "LoadBalance by cost", failures);
+    }
+
+  return failures;
+}
+
+///
+// Parse the standard test options (-v -q) out of the command line.
+// Stop parsing when a non-option argument is found.
+///
+void
+parseTestOptions( int argc ,char* argv[] )
+{
+  for ( int i = 1 ; i < argc ; ++i )
+    {
+      if ( argv[i][0] == '-' ) //if it is an option
+        {
+          // compare 3 chars to differentiate -x from -xx
+          if ( strncmp( argv[i] ,"-v" ,3 ) == 0 )
+            {
+              verbose = true ;
+            }
+          else if ( strncmp( argv[i] ,"-q" ,3 ) == 0 )
+            {
+              verbose = false ;
+            }
+          else
+            {
+              break ;
+            }
+        }
+    }
+  return ;
+}
@@ -37,6 +37,7 @@ testLB3(void);
 int
 testLB4(void);
 int testLB5(void);
+int testLB6(void);
 
 using std::endl;
 
@@ -103,6 +104,18 @@ main(int argc ,char* argv[])
   {
     if ( verbose ) pout() << indent << pgmname << " passed test 5." << endl ;
   }
+  status = testLB6();
+
+  if ( status == 0 )
+  {
+    if ( verbose ) pout() << indent << pgmname << " passed test 6." << endl ;
+  }
+  else
+  {
+    pout() << indent << pgmname << " failed test 6 with return code " << status << endl ;
+    stat_all = status ;
+  }
+
   status = testLB4();
 
   if ( status == 0 )
@@ -349,6 +362,99 @@ int testLB5()
   return status;
 }
 
+// number of face neighbors of each box that are on another processor
+static int offProcNeighbors(const Vector<Box>& a_grids, const Vector<int>& a_procs)
+{
+  int count = 0;
+  for (int i=0; i<a_grids.size(); i++)
+    {
+      Box grown = grow(a_grids[i], 1);
+      for (int j=0; j<a_grids.size(); j++)
+        {
+          if (j != i && a_procs[j] != a_procs[i] && grown.intersects(a_grids[j]))
+            {
+              count++;
+            }
+        }
+    }
+  return count;
+}
+
+// space-filling-curve load balancing: balanced, and more local than knapsack
+int testLB6()
+{
+  const int nproc = 16;
+  Box domain(IntVect::Zero, (8*16-1)*IntVect::Unit);
+  Vector<Box> grids;
+  domainSplit(domain, grids, 8);
+  Vector<long long> loads(grids.size(), 8*8);
+  const int target = grids.size()/nproc;
+
+  Vector<int> knapsack;
+  int status = LoadBalance(knapsack, loads, grids, nproc);
+  if (status != 0) return -601;
+  int knapsackNeighbors = offProcNeighbors(grids, knapsack);
+
+  for (int method = MortonLoadBalance; method <= HilbertLoadBalance; method++)
+    {
+      Vector<int> procs;
+      setLoadBalanceMethod(method);
+      status = LoadBalance(procs, loads, grids, nproc);
+      setLoadBalanceMethod(KnapsackLoadBalance);
+      if (status != 0) return -602;
+
+      Vector<int> count(nproc, 0);
+      for (int i=0; i<procs.size(); i++)
+        {
+          if (procs[i] < 0 || procs[i] >= nproc) return -603;
+          count[procs[i]]++;
+        }
+      for (int p=0; p<nproc; p++)
+        {
+          if (count[p] != target)
+            {
+              pout() << indent << "processor " << p << " got " << count[p]
+                     << " boxes instead of " << target << endl;
+              return -604;
+            }
+        }
+      int neighbors = offProcNeighbors(grids, procs);
+      if ( verbose )
+        pout() << indent2 << (method == HilbertLoadBalance ? "Hilbert" : "Morton")
+               << " off-processor neighbors " << neighbors
+               << ", knapsack " << knapsackNeighbors << endl;
+      if (neighbors > knapsackNeighbors) return -605;
+    }
+
+  // fewer boxes than processors: one box each
+  Vector<Box> few;
+  for (int i=0; i<5; i++) few.push_back(grids[i]);
+  Vector<long long> fewLoads(5, 1);
+  Vector<int> procs;
+  status = SFCLoadBalance(procs, fewLoads, few, HilbertLoadBalance, 8);
+  Vector<int> used(8, 0);
+  for (int i=0; i<5; i++) used[procs[i]]++;
+  for (int i=0; i<8; i++) if (used[i] > 1) return -606;
+
+  // a row of boxes in the last direction spanning more than 2^16 cells,
+  // listed backwards: the curve must still follow the row
+  Vector<Box> row;
+  for (int k=7; k>=0; k--)
+    {
+      IntVect lo = IntVect::Zero;
+      lo[SpaceDim-1] = 40000*k;
+      row.push_back(Box(lo, lo + 7*IntVect::Unit));
+    }
+  Vector<long long> rowLoads(row.size(), 1);
+  status = SFCLoadBalance(procs, rowLoads, row, MortonLoadBalance, 2);
+  for (int i=0; i<row.size(); i++)
+    {
+      if (procs[i] != (i < 4 ? 1 : 0)) return -607;
+    }
+
+  return status;
+}
+
 int
 testLB3()
 {
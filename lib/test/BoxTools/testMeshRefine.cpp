@@ -39,6 +39,7 @@ using std::endl;
 #endif
 
 #include "BRMeshRefine.H"
+#include "BoxIterator.H"
 #include "AMRIO.H"
 #include "parstream.H"
 #include "LoadBalance.H"
@@ -1052,6 +1053,113 @@ main(int argc ,char *argv[] )
     if (!passedVariableRefTest) status += defaultBlockFactor*16;
   }
 
+  ///
+  // Test: distributed clustering must build a valid, properly nested
+  // hierarchy covering the tags, close in size to the serial one
+  ///
+  {
+    const int nlev = 3;
+    Vector<int> ratios(nlev, 2);
+    Vector<Box> lvlDomains(nlev);
+    lvlDomains[0] = Box(IntVect::Zero, 63*IntVect::Unit);
+    for (int ilev = 1; ilev < nlev; ilev++)
+      {
+        lvlDomains[ilev] = refine(lvlDomains[ilev-1], ratios[ilev-1]);
+      }
+
+    Vector<Vector<Box> > oldMeshes(nlev);
+    oldMeshes[0].push_back(lvlDomains[0]);
+    oldMeshes[1].push_back(refine(Box(8*IntVect::Unit, 55*IntVect::Unit), ratios[0]));
+
+    // rings of tags about the center of the domain
+    Vector<IntVectSet> ringTags(nlev);
+    for (int ilev = 0; ilev < 2; ilev++)
+      {
+        const Box& dom = lvlDomains[ilev];
+        IntVect center = (dom.smallEnd() + dom.bigEnd())/2;
+        Real radius = 0.3*dom.size(0);
+        for (BoxIterator bit(dom); bit.ok(); ++bit)
+          {
+            IntVect d = bit() - center;
+            Real r2 = 0;
+            for (int idir = 0; idir < SpaceDim; idir++) r2 += d[idir]*d[idir];
+            Real r = sqrt(r2);
+            if (fabs(r - radius) < 1.5) ringTags[ilev] |= bit();
+          }
+      }
+
+    const int maxSize = 16;
+    const int nBuff = 1;
+    Vector<Vector<Vector<Box> > > results(2, Vector<Vector<Box> >(nlev));
+    for (int run = 0; run < 2; run++)
+      {
+        BRMeshRefine mr(lvlDomains[0], ratios, 0.75, 2, nBuff, maxSize);
+        mr.setDistributedClustering(run*8);
+        Vector<IntVectSet> runTags = ringTags;
+        // stray tags outside the domain must not upset the tile routing
+        runTags[0] |= -2*IntVect::Unit;
+        runTags[0] |= lvlDomains[0].bigEnd() + 3*IntVect::Unit;
+        mr.regrid(results[run], runTags, 0, 1, oldMeshes);
+      }
+
+    bool passedDistributedTest = true;
+    long numPts[2] = {0, 0};
+    for (int run = 0; run < 2; run++)
+      {
+        const Vector<Vector<Box> >& mesh = results[run];
+        if (mesh.size() < nlev || mesh[1].size() == 0 || mesh[2].size() == 0)
+          {
+            passedDistributedTest = false;
+            break;
+          }
+        for (int ilev = 1; ilev < nlev; ilev++)
+          {
+            IntVectSet covered;
+            for (int i = 0; i < mesh[ilev].size(); i++)
+              {
+                const Box& b = mesh[ilev][i];
+                numPts[run] += b.numPts();
+                for (int idir = 0; idir < SpaceDim; idir++)
+                  {
+                    if (b.size(idir) > maxSize) passedDistributedTest = false;
+                  }
+                IntVectSet overlap(b);
+                overlap &= covered;
+                if (!overlap.isEmpty()) passedDistributedTest = false;
+                covered |= b;
+              }
+
+            // nesting in the next coarser level
+            IntVectSet crseCovered;
+            for (int i = 0; i < mesh[ilev-1].size(); i++) crseCovered |= mesh[ilev-1][i];
+            for (int i = 0; i < mesh[ilev].size(); i++)
+              {
+                Box b = coarsen(mesh[ilev][i], ratios[ilev-1]);
+                b.grow(nBuff);
+                b &= lvlDomains[ilev-1];
+                if (!crseCovered.contains(b)) passedDistributedTest = false;
+              }
+          }
+
+        // the base level tags are all refined
+        IntVectSet fineCovered;
+        for (int i = 0; i < mesh[1].size(); i++) fineCovered |= coarsen(mesh[1][i], ratios[0]);
+        if (!fineCovered.contains(ringTags[0])) passedDistributedTest = false;
+      }
+    // cuts at tile boundaries cost some efficiency, but not much
+    if (numPts[1] > 2*numPts[0]) passedDistributedTest = false;
+
+    if (verbose)
+      {
+        pout() << indent << pgmname << " distributed clustering test: "
+               << numPts[1] << " cells vs. " << numPts[0] << " serial: "
+               << (( passedDistributedTest ) ? "passed" : "failed")
+               << endl ;
+      }
+
+    if (!passedDistributedTest) status += 128;
+  }
+
   // Must do all parallel stuff (including pout's) BEFORE MPI_Finalize  (ndk)
   pout() << indent << pgmname << ": "
          << ( (status == 0) ? "passed all tests" : "failed at least one test,")
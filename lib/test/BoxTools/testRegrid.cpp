@@ -0,0 +1,300 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include <iostream>
+#include <cstring>
+#include <map>
+
+using std::endl;
+
+#include "Box.H"
+#include "BoxIterator.H"
+#include "FArrayBox.H"
+#include "LevelData.H"
+#include "RegridMap.H"
+#include "LoadBalance.H"
+#include "SPMD.H"
+#include "parstream.H"
+#ifdef CH_MPI
+#include "mpi.h"
+#endif
+#include "UsingNamespace.H"
+
+/// Prototypes:
+
+void
+parseTestOptions( int argc ,char* argv[] ) ;
+
+int
+testRegrid();
+
+/// Global variables for handling output:
+static const char *pgmname = "testRegrid" ;
+static const char *indent = "   ", *indent2 = "      " ;
+static bool verbose = true ;
+
+/// Code:
+
+int
+main(int argc, char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+  parseTestOptions( argc ,argv ) ;
+
+  if ( verbose )
+    pout() << indent2 << "Beginning " << pgmname << " ..." << endl ;
+
+  int ret = testRegrid() ;
+
+  if ( ret == 0 )
+    {
+      pout() << indent << pgmname << " passed all tests" << endl ;
+    }
+  else
+    {
+      pout() << indent << pgmname << " failed " << ret << " test(s)" << endl ;
+    }
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+  return ret;
+}
+
+static Real
+value(const IntVect& a_iv, int a_comp)
+{
+  Real v = 10000*a_comp;
+  Real scale = 1;
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      v += scale*a_iv[idir];
+      scale *= 100;
+    }
+  return v;
+}
+
+// the 8^D blocks of [0,63]^D whose index in direction 0 is in [a_lo, a_hi]
+static Vector<Box>
+blocks(int a_lo, int a_hi)
+{
+  Vector<Box> boxes;
+  Box blockBox(IntVect::Zero, 7*IntVect::Unit);
+  blockBox.setRange(0, a_lo, a_hi - a_lo + 1);
+  for (BoxIterator bit(blockBox); bit.ok(); ++bit)
+    {
+      Box b(8*bit(), 8*bit() + 7*IntVect::Unit);
+      boxes.push_back(b);
+    }
+  return boxes;
+}
+
+static void
+check(bool a_ok, const char* a_what, int& a_failures)
+{
+  int ok = a_ok ? 1 : 0;
+#ifdef CH_MPI
+  int allOk;
+  MPI_Allreduce(&ok, &allOk, 1, MPI_INT, MPI_MIN, Chombo_MPI::comm);
+  ok = allOk;
+#endif
+  if (!ok)
+    {
+      a_failures++;
+      pout() << indent << pgmname << ": failed " << a_what << endl;
+    }
+  else if (verbose)
+    {
+      pout() << indent2 << a_what << " ok" << endl;
+    }
+}
+
+int
+testRegrid()
+{
+  int failures = 0;
+  const ProblemDomain domain(Box(IntVect::Zero, 63*IntVect::Unit));
+  const int ncomp = 2;
+  const IntVect ghost = 2*IntVect::Unit;
+
+  // the old layout covers blocks 0 to 4 in direction 0; the new one drops
+  // block 0, splits the blocks at 2 in half, and adds block 5
+  Vector<Box> oldBoxes = blocks(0, 4);
+  Vector<int> oldProcs;
+  LoadBalance(oldProcs, oldBoxes);
+  DisjointBoxLayout oldGrids(oldBoxes, oldProcs, domain);
+
+  Vector<Box> newBoxes;
+  Vector<Box> candidates = blocks(1, 5);
+  for (int i = 0; i < candidates.size(); i++)
+    {
+      const Box& b = candidates[i];
+      if (b.smallEnd(0) == 16)
+        {
+          Box lo(b);
+          Box hi = lo.chop(SpaceDim-1, b.smallEnd(SpaceDim-1) + 4);
+          newBoxes.push_back(lo);
+          newBoxes.push_back(hi);
+        }
+      else
+        {
+          newBoxes.push_back(b);
+        }
+    }
+  Vector<int> newProcs;
+  incrementalLoadBalance(newProcs, newBoxes, oldGrids);
+  DisjointBoxLayout newGrids(newBoxes, newProcs, domain);
+
+  // survivors keep their processors
+  {
+    bool ok = true;
+    std::map<Box, int> oldProc;
+    for (LayoutIterator lit = oldGrids.layoutIterator(); lit.ok(); ++lit)
+      {
+        oldProc[oldGrids[lit()]] = oldGrids.procID(lit());
+      }
+    for (int i = 0; i < newBoxes.size(); i++)
+      {
+        if (oldProc.count(newBoxes[i]) > 0 && oldProc[newBoxes[i]] != newProcs[i]) ok = false;
+      }
+    check(ok, "incrementalLoadBalance", failures);
+  }
+
+  RegridMap map(oldGrids, newGrids);
+  int blocksPerSlab = 1;
+  for (int idir = 1; idir < SpaceDim; idir++) blocksPerSlab *= 8;
+  check(map.numSurvived() == 3*blocksPerSlab && !map.unchanged() &&
+        map.numCreated() == newGrids.size() - 3*blocksPerSlab &&
+        map.createdGrids().size() == map.numCreated(), "RegridMap", failures);
+
+  // old data: valid cells set, ghost cells filled by exchange
+  LevelData<FArrayBox> data(oldGrids, ncomp, ghost);
+  std::map<Box, const Real*> oldPointers;
+  for (DataIterator dit = oldGrids.dataIterator(); dit.ok(); ++dit)
+    {
+      FArrayBox& fab = data[dit];
+      fab.setVal(-1.0);
+      for (BoxIterator bit(oldGrids[dit]); bit.ok(); ++bit)
+        {
+          for (int comp = 0; comp < ncomp; comp++) fab(bit(), comp) = value(bit(), comp);
+        }
+      oldPointers[oldGrids[dit]] = fab.dataPtr();
+    }
+  data.exchange();
+
+  LevelData<FArrayBox> created(map.createdGrids(), ncomp, ghost);
+  for (DataIterator dit = created.dataIterator(); dit.ok(); ++dit)
+    {
+      created[dit].setVal(-7.0);
+    }
+
+  data.regrid(map, &created);
+
+  // surviving boxes keep their FABs, created ones are filled from the old
+  // data where the old layout covers them and from a_created elsewhere
+  {
+    bool kept = true;
+    bool filled = true;
+    Box oldRegion(IntVect::Zero, 63*IntVect::Unit);
+    oldRegion.setRange(0, 0, 40);
+    for (DataIterator dit = newGrids.dataIterator(); dit.ok(); ++dit)
+      {
+        const FArrayBox& fab = data[dit];
+        if (map.survived(dit()))
+          {
+            if (fab.dataPtr() != oldPointers[newGrids[dit]]) kept = false;
+          }
+        for (BoxIterator bit(newGrids[dit]); bit.ok(); ++bit)
+          {
+            for (int comp = 0; comp < ncomp; comp++)
+              {
+                Real expected = oldRegion.contains(bit()) ? value(bit(), comp) : -7.0;
+                if (fab(bit(), comp) != expected) filled = false;
+              }
+          }
+      }
+    check(kept, "surviving FABs kept", failures);
+    check(filled, "created boxes filled", failures);
+  }
+
+  // the regridded exchange Copier moves the same data as a new one
+  {
+    Copier fresh;
+    fresh.define(newGrids, newGrids, ghost, true);
+    Copier oldExchange;
+    oldExchange.define(oldGrids, oldGrids, ghost, true);
+    Copier reused;
+    reused.regridExchangeDefine(oldExchange, map, ghost);
+    check(reused.numLocalCellsToCopy() == fresh.numLocalCellsToCopy() &&
+          reused.numFromCellsToCopy() == fresh.numFromCellsToCopy() &&
+          reused.numToCellsToCopy() == fresh.numToCellsToCopy(), "regridExchangeDefine", failures);
+
+    LevelData<FArrayBox> reference(newGrids, ncomp, ghost);
+    for (DataIterator dit = newGrids.dataIterator(); dit.ok(); ++dit)
+      {
+        for (BoxIterator bit(newGrids[dit]); bit.ok(); ++bit)
+          {
+            for (int comp = 0; comp < ncomp; comp++) data[dit](bit(), comp) = value(bit(), comp);
+          }
+        reference[dit].copy(data[dit]);
+      }
+    reference.exchange(reference.interval(), fresh);
+    data.exchange();
+    // ghost cells that no box covers are not exchanged
+    Box newRegion(IntVect::Zero, 63*IntVect::Unit);
+    newRegion.setRange(0, 8, 40);
+    bool same = true;
+    for (DataIterator dit = newGrids.dataIterator(); dit.ok(); ++dit)
+      {
+        Box grown = grow(newGrids[dit], ghost) & newRegion;
+        for (BoxIterator bit(grown); bit.ok(); ++bit)
+          {
+            for (int comp = 0; comp < ncomp; comp++)
+              {
+                if (data[dit](bit(), comp) != reference[dit](bit(), comp)) same = false;
+              }
+          }
+      }
+    check(same, "exchange after regrid", failures);
+  }
+
+  return failures;
+}
+
+///
+// Parse the standard test options (-v -q) out of the command line.
+// Stop parsing when a non-option argument is found.
+///
+void
+parseTestOptions( int argc ,char* argv[] )
+{
+  for ( int i = 1 ; i < argc ; ++i )
+    {
+      if ( argv[i][0] == '-' ) //if it is an option
+        {
+          // compare 3 chars to differentiate -x from -xx
+          if ( strncmp( argv[i] ,"-v" ,3 ) == 0 )
+            {
+              verbose = true ;
+            }
+          else if ( strncmp( argv[i] ,"-q" ,3 ) == 0 )
+            {
+              verbose = false ;
+            }
+          else
+            {
+              break ;
+            }
+        }
+    }
+  return ;
+}
@@ -0,0 +1,187 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include <iostream>
+#include <cstring>
+#include <map>
+
+using std::endl;
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include "TaskGraph.H"
+#include "SPMD.H"
+#include "parstream.H"
+#ifdef CH_MPI
+#include "mpi.h"
+#endif
+#include "UsingNamespace.H"
+
+/// Prototypes:
+
+void
+parseTestOptions( int argc ,char* argv[] ) ;
+
+int
+testTaskGraph();
+
+/// Global variables for handling output:
+static const char *pgmname = "testTaskGraph" ;
+static const char *indent = "   ", *indent2 = "      " ;
+static bool verbose = true ;
+
+/// Code:
+
+int
+main(int argc, char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+  parseTestOptions( argc ,argv ) ;
+
+  if ( verbose )
+    pout() << indent2 << "Beginning " << pgmname << " ..." << endl ;
+
+  int ret = testTaskGraph() ;
+
+  if ( ret == 0 )
+    {
+      pout() << indent << pgmname << " passed all tests" << endl ;
+    }
+  else
+    {
+      pout() << indent << pgmname << " failed " << ret << " test(s)" << endl ;
+    }
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+  return ret;
+}
+
+static void
+check(bool a_ok, const char* a_what, int& a_failures)
+{
+  int ok = a_ok ? 1 : 0;
+#ifdef CH_MPI
+  int allOk;
+  MPI_Allreduce(&ok, &allOk, 1, MPI_INT, MPI_MIN, Chombo_MPI::comm);
+  ok = allOk;
+#endif
+  if (!ok)
+    {
+      a_failures++;
+      pout() << indent << pgmname << ": failed " << a_what << endl;
+    }
+  else if (verbose)
+    {
+      pout() << indent2 << a_what << " ok" << endl;
+    }
+}
+
+int
+testTaskGraph()
+{
+  int failures = 0;
+  const std::thread::id mainThread = std::this_thread::get_id();
+
+  for (int numThreads = 1; numThreads <= 4; numThreads += 3)
+    {
+      TaskGraph graph(numThreads);
+
+      // a diamond of layers of local tasks: each task of a layer comes
+      // after all the tasks of the previous one
+      const int numLayers = 5;
+      const int width = 8;
+      std::atomic<int> done(0);
+      std::atomic<int> outOfOrder(0);
+      Vector<int> previous;
+      for (int layer = 0; layer < numLayers; layer++)
+        {
+          Vector<int> current;
+          for (int i = 0; i < width; i++)
+            {
+              current.push_back(graph.addTask([&done, &outOfOrder, layer, width]
+                                              {
+                                                if (done.load() < layer*width) outOfOrder++;
+                                                done++;
+                                              }, previous));
+            }
+          previous = current;
+        }
+
+      // communicating tasks run in this thread, in the order they were
+      // added, after the tasks they come after
+      std::mutex mutex;
+      Vector<int> order;
+      bool inMainThread = true;
+      int sum = 0;
+      int last = -1;
+      for (int i = 0; i < 4; i++)
+        {
+          last = graph.addTask([&, i]
+                               {
+                                 std::lock_guard<std::mutex> lock(mutex);
+                                 if (std::this_thread::get_id() != mainThread) inMainThread = false;
+                                 order.push_back(i);
+                                 int one = 1;
+#ifdef CH_MPI
+                                 MPI_Allreduce(&one, &sum, 1, MPI_INT, MPI_SUM, Chombo_MPI::comm);
+#else
+                                 sum = one;
+#endif
+                               }, (i == 2) ? previous : Vector<int>(), true);
+        }
+      graph.wait(last);
+      bool ordered = (order.size() == 4);
+      for (int i = 0; ordered && i < 4; i++)
+        {
+          ordered = (order[i] == i);
+        }
+      check(ordered && inMainThread && sum == numProc() && done.load() == numLayers*width,
+            "communicating tasks", failures);
+
+      graph.waitAll();
+      check(outOfOrder.load() == 0 && graph.numTasks() == 0, "local task dependencies", failures);
+    }
+
+  return failures;
+}
+
+///
+// Parse the standard test options (-v -q) out of the command line.
+// Stop parsing when a non-option argument is found.
+///
+void
+parseTestOptions( int argc ,char* argv[] )
+{
+  for ( int i = 1 ; i < argc ; ++i )
+    {
+      if ( argv[i][0] == '-' ) //if it is an option
+        {
+          // compare 3 chars to differentiate -x from -xx
+          if ( strncmp( argv[i] ,"-v" ,3 ) == 0 )
+            {
+              verbose = true ;
+            }
+          else if ( strncmp( argv[i] ,"-q" ,3 ) == 0 )
+            {
+              verbose = false ;
+            }
+          else
+            {
+              break ;
+            }
+        }
+    }
+  return ;
+}
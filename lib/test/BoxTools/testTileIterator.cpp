@@ -0,0 +1,194 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include <iostream>
+#include <cstring>
+#include <map>
+
+using std::endl;
+
+#include "Box.H"
+#include "BoxIterator.H"
+#include "FArrayBox.H"
+#include "LevelData.H"
+#include "TileIterator.H"
+#include "LoadBalance.H"
+#include "SPMD.H"
+#include "parstream.H"
+#ifdef CH_MPI
+#include "mpi.h"
+#endif
+#include "UsingNamespace.H"
+
+/// Prototypes:
+
+void
+parseTestOptions( int argc ,char* argv[] ) ;
+
+int
+testTileIterator();
+
+/// Global variables for handling output:
+static const char *pgmname = "testTileIterator" ;
+static const char *indent = "   ", *indent2 = "      " ;
+static bool verbose = true ;
+
+/// Code:
+
+int
+main(int argc, char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+  parseTestOptions( argc ,argv ) ;
+
+  if ( verbose )
+    pout() << indent2 << "Beginning " << pgmname << " ..." << endl ;
+
+  int ret = testTileIterator() ;
+
+  if ( ret == 0 )
+    {
+      pout() << indent << pgmname << " passed all tests" << endl ;
+    }
+  else
+    {
+      pout() << indent << pgmname << " failed " << ret << " test(s)" << endl ;
+    }
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+  return ret;
+}
+
+static void
+check(bool a_ok, const char* a_what, int& a_failures)
+{
+  int ok = a_ok ? 1 : 0;
+#ifdef CH_MPI
+  int allOk;
+  MPI_Allreduce(&ok, &allOk, 1, MPI_INT, MPI_MIN, Chombo_MPI::comm);
+  ok = allOk;
+#endif
+  if (!ok)
+    {
+      a_failures++;
+      pout() << indent << pgmname << ": failed " << a_what << endl;
+    }
+  else if (verbose)
+    {
+      pout() << indent2 << a_what << " ok" << endl;
+    }
+}
+
+// true if the tiles of a_tit cover every box of a_grids on this
+// processor, grown by a_ghost, exactly once and none is larger than a_size
+static bool
+tilesCover(const TileIterator& a_tit, const DisjointBoxLayout& a_grids,
+           const IntVect& a_size, const IntVect& a_ghost)
+{
+  LevelData<FArrayBox> count(a_grids, 1, a_ghost);
+  for (DataIterator dit = a_grids.dataIterator(); dit.ok(); ++dit)
+    {
+      count[dit].setVal(0.0);
+    }
+  bool ok = true;
+  for (int itile = 0; itile < a_tit.size(); itile++)
+    {
+      const Box& tile = a_tit[itile];
+      const DataIndex& d = a_tit.index(itile);
+      if (!grow(a_grids[d], a_ghost).contains(tile)) ok = false;
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          if (a_size[idir] > 0 && tile.size(idir) > a_size[idir]) ok = false;
+        }
+      count[d].plus(1.0, tile, 0, 1);
+    }
+  for (DataIterator dit = a_grids.dataIterator(); dit.ok(); ++dit)
+    {
+      if (count[dit].min() != 1.0 || count[dit].max() != 1.0) ok = false;
+    }
+  return ok;
+}
+
+int
+testTileIterator()
+{
+  int failures = 0;
+  const ProblemDomain domain(Box(IntVect::Zero, 63*IntVect::Unit));
+
+  // boxes of uneven sizes, so that tiles are clipped at their high ends
+  Vector<Box> boxes;
+  Box blockBox(IntVect::Zero, IntVect::Unit);
+  for (BoxIterator bit(blockBox); bit.ok(); ++bit)
+    {
+      IntVect lo = 32*bit();
+      IntVect hi = lo + (31 - 7*bit()[0])*IntVect::Unit;
+      boxes.push_back(Box(lo, hi));
+    }
+  Vector<int> procs;
+  LoadBalance(procs, boxes);
+  DisjointBoxLayout grids(boxes, procs, domain);
+
+  IntVect size = 5*IntVect::Unit;
+  size[0] = 12;
+  TileIterator tit(grids, size);
+  check(tilesCover(tit, grids, size, IntVect::Zero), "tiles cover the boxes", failures);
+
+  TileIterator grown(grids, size, 2*IntVect::Unit);
+  check(tilesCover(grown, grids, size, 2*IntVect::Unit), "tiles cover the grown boxes", failures);
+
+  TileIterator whole(grids, IntVect::Zero);
+  check(whole.size() == grids.dataIterator().size() &&
+        tilesCover(whole, grids, IntVect::Zero, IntVect::Zero), "one tile per box", failures);
+
+  {
+    int n = 0;
+    bool same = true;
+    for (tit.begin(); tit.ok(); ++tit, ++n)
+      {
+        if (tit() != tit[n] || tit.dataIndex() != tit.index(n)) same = false;
+      }
+    check(same && n == tit.size(), "sequential iteration", failures);
+  }
+
+  return failures;
+}
+
+///
+// Parse the standard test options (-v -q) out of the command line.
+// Stop parsing when a non-option argument is found.
+///
+void
+parseTestOptions( int argc ,char* argv[] )
+{
+  for ( int i = 1 ; i < argc ; ++i )
+    {
+      if ( argv[i][0] == '-' ) //if it is an option
+        {
+          // compare 3 chars to differentiate -x from -xx
+          if ( strncmp( argv[i] ,"-v" ,3 ) == 0 )
+            {
+              verbose = true ;
+            }
+          else if ( strncmp( argv[i] ,"-q" ,3 ) == 0 )
+            {
+              verbose = false ;
+            }
+          else
+            {
+              break ;
+            }
+        }
+    }
+  return ;
+}
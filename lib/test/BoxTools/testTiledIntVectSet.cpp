@@ -0,0 +1,363 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include <iostream>
+#include <cstring>
+
+using std::endl;
+
+#include "Box.H"
+#include "BoxIterator.H"
+#include "IntVectSet.H"
+#include "TiledIntVectSet.H"
+#include "TreeIntVectSet.H"
+#include "DenseIntVectSet.H"
+#include "ProblemDomain.H"
+#include "parstream.H"
+#ifdef CH_MPI
+#include "mpi.h"
+#endif
+#include "UsingNamespace.H"
+
+/// Prototypes:
+
+void
+parseTestOptions( int argc ,char* argv[] ) ;
+
+int
+testTiledIntVectSet();
+
+/// Global variables for handling output:
+static const char *pgmname = "testTiledIntVectSet" ;
+static const char *indent = "   ", *indent2 = "      " ;
+static bool verbose = true ;
+
+/// Code:
+
+int
+main(int argc, char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+  parseTestOptions( argc ,argv ) ;
+
+  if ( verbose )
+    pout() << indent2 << "Beginning " << pgmname << " ..." << endl ;
+
+  int ret = testTiledIntVectSet() ;
+
+  if ( ret == 0 )
+    {
+      pout() << indent << pgmname << " passed all tests" << endl ;
+    }
+  else
+    {
+      pout() << indent << pgmname << " failed " << ret << " test(s)" << endl ;
+    }
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+  return ret;
+}
+
+static unsigned int s_seed = 12345;
+
+static int
+randomInt(int a_n)
+{
+  s_seed = s_seed*1103515245 + 12345;
+  return (s_seed >> 8) % a_n;
+}
+
+// clusters of random cells, so there are full, partial and empty tiles
+static void
+randomSet(const Box& a_region, TiledIntVectSet& a_tiled, TreeIntVectSet& a_tree,
+          DenseIntVectSet& a_dense)
+{
+  a_tiled.clear();
+  a_tree.clear();
+  a_dense = DenseIntVectSet(a_region, false);
+  for (int n = 0; n < 12; n++)
+    {
+      IntVect lo, hi;
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          lo[idir] = a_region.smallEnd(idir) + randomInt(a_region.size(idir));
+          hi[idir] = std::min(a_region.bigEnd(idir), lo[idir] + randomInt(12));
+        }
+      Box b(lo, hi);
+      bool solid = (n % 3 == 0);
+      for (BoxIterator bit(b); bit.ok(); ++bit)
+        {
+          if (solid || randomInt(4) == 0)
+            {
+              a_tiled |= bit();
+              a_tree  |= bit();
+              a_dense |= bit();
+            }
+        }
+    }
+}
+
+// true if a_tiled holds exactly the IntVects of a_tree
+static bool
+same(const TiledIntVectSet& a_tiled, const TreeIntVectSet& a_tree)
+{
+  if (a_tiled.numPts() != a_tree.numPts()) return false;
+  for (TreeIntVectSetIterator it(a_tree); it.ok(); ++it)
+    {
+      if (!a_tiled.contains(it())) return false;
+    }
+  return true;
+}
+
+static bool
+same(const TiledIntVectSet& a_tiled, const DenseIntVectSet& a_dense)
+{
+  if (a_tiled.numPts() != a_dense.numPts()) return false;
+  for (DenseIntVectSetIterator it(a_dense); it.ok(); ++it)
+    {
+      if (!a_tiled.contains(it())) return false;
+    }
+  return true;
+}
+
+static void
+check(bool a_ok, const char* a_what, int& a_failures)
+{
+  if (!a_ok)
+    {
+      a_failures++;
+      pout() << indent << pgmname << ": failed " << a_what << endl;
+    }
+  else if (verbose)
+    {
+      pout() << indent2 << a_what << " ok" << endl;
+    }
+}
+
+int
+testTiledIntVectSet()
+{
+  int failures = 0;
+  const Box region(-21*IntVect::Unit, 36*IntVect::Unit);
+  const Box domain(-16*IntVect::Unit, 31*IntVect::Unit);
+
+  TiledIntVectSet tiledA, tiledB;
+  TreeIntVectSet  treeA,  treeB;
+  DenseIntVectSet denseA, denseB;
+  randomSet(region, tiledA, treeA, denseA);
+  randomSet(region, tiledB, treeB, denseB);
+  check(same(tiledA, treeA) && same(tiledB, treeB), "construction", failures);
+  check(tiledA.minBox() == treeA.minBox(), "minBox", failures);
+
+  // iteration visits every IntVect once
+  {
+    TiledIntVectSet visited;
+    int n = 0;
+    for (TiledIntVectSetIterator it(tiledA); it.ok(); ++it, ++n) visited |= it();
+    check(n == tiledA.numPts() && visited == tiledA, "iterator", failures);
+  }
+
+  // set algebra
+  {
+    TiledIntVectSet t(tiledA);
+    TreeIntVectSet  r(treeA);
+    t |= tiledB;
+    r |= treeB;
+    check(same(t, r), "union", failures);
+    t = tiledA;
+    r = treeA;
+    t &= tiledB;
+    r &= treeB;
+    check(same(t, r), "intersection", failures);
+    t = tiledA;
+    r = treeA;
+    t -= tiledB;
+    r -= treeB;
+    check(same(t, r), "difference", failures);
+    check(tiledA.contains(t) && !t.contains(tiledA), "contains(TiledIntVectSet)", failures);
+  }
+
+  // boxes
+  {
+    Box b(-5*IntVect::Unit, 13*IntVect::Unit);
+    TiledIntVectSet t(tiledA);
+    TreeIntVectSet  r(treeA);
+    t |= b;
+    r |= b;
+    check(same(t, r) && t.contains(b), "union with Box", failures);
+    t &= domain;
+    r &= domain;
+    check(same(t, r), "intersection with Box", failures);
+    t -= b;
+    r -= b;
+    check(same(t, r) && !t.contains(b), "difference with Box", failures);
+  }
+
+  // grow, shift, growHi
+  {
+    TiledIntVectSet t(tiledA);
+    TreeIntVectSet  r(treeA);
+    t.grow(2);
+    r.grow(2);
+    check(same(t, r), "grow(2)", failures);
+    t = tiledA;
+    r = treeA;
+    t.grow(SpaceDim-1, 11);
+    r.grow(SpaceDim-1, 11);
+    check(same(t, r), "grow(dir, 11)", failures);
+    t = tiledA;
+    t.grow(-1);
+    DenseIntVectSet d(denseA);
+    d.grow(-1);
+    check(same(t, d), "grow(-1)", failures);
+    t = tiledA;
+    r = treeA;
+    IntVect s;
+    for (int idir = 0; idir < SpaceDim; idir++) s[idir] = (idir % 2 == 0) ? 3 - 8*idir : -13;
+    t.shift(s);
+    r.shift(s);
+    check(same(t, r), "shift", failures);
+    t = tiledA;
+    r = treeA;
+    t.growHi();
+    r.growHi();
+    check(same(t, r), "growHi", failures);
+  }
+
+  // refine and coarsen
+  for (int ref = 2; ref <= 4; ref *= 2)
+    {
+      TiledIntVectSet t(tiledA);
+      TreeIntVectSet  r(treeA);
+      t.refine(ref);
+      r.refine(ref);
+      check(same(t, r), "refine", failures);
+      t = tiledA;
+      r = treeA;
+      t.coarsen(ref);
+      r.coarsen(ref);
+      check(same(t, r), "coarsen", failures);
+    }
+
+  // chop keeps the low part and returns the high part
+  {
+    TiledIntVectSet lo(tiledA);
+    TiledIntVectSet hi = lo.chop(0, 5);
+    check(lo.minBox().bigEnd(0) < 5 && hi.minBox().smallEnd(0) >= 5 &&
+          lo.numPts() + hi.numPts() == tiledA.numPts(), "chop", failures);
+  }
+
+  // nesting regions
+  {
+    TiledIntVectSet t(tiledA);
+    TreeIntVectSet  r(treeA);
+    t |= tiledB;
+    r |= treeB;
+    t.grow(3);
+    r.grow(3);
+    t &= domain;
+    r &= domain;
+    TiledIntVectSet t2(t);
+    TreeIntVectSet  r2(r);
+    t.nestingRegion(2, domain);
+    r.nestingRegion(2, domain, 1);
+    check(same(t, r), "nestingRegion", failures);
+
+    bool periodic[SpaceDim];
+    for (int idir = 0; idir < SpaceDim; idir++) periodic[idir] = (idir == 0);
+    ProblemDomain pdomain(domain, periodic);
+    t = t2;
+    r = r2;
+    t.nestingRegion(2, pdomain);
+    r.nestingRegion(2, pdomain, 1);
+    check(same(t, r), "periodic nestingRegion", failures);
+  }
+
+  // boxes cover the set exactly once
+  {
+    Vector<Box> boxes = tiledA.createBoxes();
+    TiledIntVectSet covered;
+    long n = 0;
+    for (int i = 0; i < boxes.size(); i++)
+      {
+        covered |= boxes[i];
+        n += boxes[i].numPts();
+      }
+    check(covered == tiledA && n == tiledA.numPts(), "createBoxes", failures);
+  }
+
+  // linearization
+  {
+    Vector<char> buf(tiledA.linearSize());
+    tiledA.linearOut(&(buf[0]));
+    TiledIntVectSet t;
+    t.linearIn(&(buf[0]));
+    check(t == tiledA, "linearIn/linearOut", failures);
+  }
+
+  // as the sparse representation of IntVectSet
+  {
+    IntVectSet::setUseTiles(true);
+    IntVectSet tiled;
+    for (TreeIntVectSetIterator it(treeA); it.ok(); ++it) tiled |= it();
+    IntVectSet tree(treeA);
+    IntVectSet::setUseTiles(false);
+    tiled.grow(1);
+    tree.grow(1);
+    IntVectSet mixed(tiled);
+    mixed -= tree;
+    bool ok = tiled.isTiled() && mixed.isEmpty() &&
+      tiled.numPts() == tree.numPts() && tiled.contains(tree);
+    int n = 0;
+    for (IVSIterator it(tiled); it.ok(); ++it) n++;
+    ok = ok && (n == tiled.numPts());
+    Vector<char> buf(tiled.linearSize());
+    tiled.linearOut(&(buf[0]));
+    IntVectSet copy;
+    copy.linearIn(&(buf[0]));
+    ok = ok && copy.isTiled() && copy == tiled;
+    check(ok, "IntVectSet with tiles", failures);
+  }
+
+  return failures;
+}
+
+///
+// Parse the standard test options (-v -q) out of the command line.
+// Stop parsing when a non-option argument is found.
+///
+void
+parseTestOptions( int argc ,char* argv[] )
+{
+  for ( int i = 1 ; i < argc ; ++i )
+    {
+      if ( argv[i][0] == '-' ) //if it is an option
+        {
+          // compare 3 chars to differentiate -x from -xx
+          if ( strncmp( argv[i] ,"-v" ,3 ) == 0 )
+            {
+              verbose = true ;
+            }
+          else if ( strncmp( argv[i] ,"-q" ,3 ) == 0 )
+            {
+              verbose = false ;
+            }
+          else
+            {
+              break ;
+            }
+        }
+    }
+  return ;
+}
@@ -309,6 +309,10 @@ void amrGodunov()
   Real dtToleranceFactor = 1.1;
   ppgodunov.get("dt_tolerance_factor",dtToleranceFactor);
 
+  // Run the level steps as tasks in this many threads (0 for no tasks)
+  int taskThreads = 0;
+  ppgodunov.query("task_threads",taskThreads);
+
   // Create and define IBC (initial and boundary condition) object
   PhysIBC* ibc;
 
@@ -674,6 +678,11 @@ void amrGodunov()
   amr.maxDtGrow(maxDtGrowth);
   amr.dtToleranceFactor(dtToleranceFactor);
 
+  if (taskThreads > 0)
+  {
+    amr.useTaskGraph(taskThreads);
+  }
+
   // Set up output files
   if (ppgodunov.contains("plot_prefix"))
   {
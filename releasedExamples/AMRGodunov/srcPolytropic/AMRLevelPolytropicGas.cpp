@@ -189,6 +189,49 @@ Real AMRLevelPolytropicGas::advance()
 {
   CH_assert(allDefined());
 
+  advanceBegin();
+
+  DataIterator dit = m_grids.dataIterator();
+  int nbox = dit.size();
+#pragma omp parallel for
+  for (int ibox = 0; ibox < nbox; ibox++)
+    {
+      m_levelGodunov.stepBox(dit[ibox]);
+    }
+
+  return advanceEnd();
+}
+
+// Advance by one timestep, as tasks
+int AMRLevelPolytropicGas::addAdvanceTasks(TaskGraph&         a_graph,
+                                           const Vector<int>& a_after)
+{
+  CH_assert(allDefined());
+
+  // Ghost cells come from other processors and the next coarser level
+  int begin = a_graph.addTask([this] { advanceBegin(); }, a_after, true);
+
+  // The box updates only touch their own box and flux register entries
+  Vector<int> boxTasks;
+  for (DataIterator dit = m_grids.dataIterator(); dit.ok(); ++dit)
+    {
+      const DataIndex dataIndex = dit();
+      boxTasks.push_back(a_graph.addTask([this, dataIndex]
+                                         {
+                                           m_levelGodunov.stepBox(dataIndex);
+                                         },
+                                         Vector<int>(1, begin)));
+    }
+  boxTasks.push_back(begin);
+
+  // The new time step is a minimum over all processors
+  return a_graph.addTask([this] { advanceEnd(); }, boxTasks, true);
+}
+
+// Copy the new state to the old, set up the source term and start the
+// level step
+void AMRLevelPolytropicGas::advanceBegin()
+{
   if (s_verbosity >= 3)
     {
       pout() << "AMRLevelPolytropicGas::advance level " << m_level << " to time " << m_time + m_dt << endl;
@@ -200,20 +243,15 @@ Real AMRLevelPolytropicGas::advance()
       m_UOld[dit()].copy(m_UNew[dit()]);
     }
 
-  Real newDt = 0.0;
-
   // Set up arguments to LevelGodunov::step based on whether there are
   // coarser and finer levels
 
-  // Undefined flux register in case we need it
-  LevelFluxRegister dummyFR;
-
   // Undefined leveldata in case we need it
   const LevelData<FArrayBox> dummyData;
 
   // Set arguments to dummy values and then fix if real values are available
-  LevelFluxRegister* coarserFR = &dummyFR;
-  LevelFluxRegister* finerFR   = &dummyFR;
+  LevelFluxRegister* coarserFR = &m_dummyFluxRegister;
+  LevelFluxRegister* finerFR   = &m_dummyFluxRegister;
 
   const LevelData<FArrayBox>* coarserDataOld = &dummyData;
   const LevelData<FArrayBox>* coarserDataNew = &dummyData;
@@ -245,19 +283,16 @@ Real AMRLevelPolytropicGas::advance()
       finerFR = &m_fluxRegister;
     }
 
-  // Source term leveldata
-  LevelData<FArrayBox> sourceData;
-
   // Set up source term for hyperbolic update
   if (m_useSourceTerm)
     {
       // Define source term leveldata
       IntVect ivGhost = m_numGhost * IntVect::Unit;
-      sourceData.define(m_grids,m_gdnvPhysics->numPrimitives(),ivGhost);
+      m_sourceData.define(m_grids,m_gdnvPhysics->numPrimitives(),ivGhost);
 
-      for (DataIterator dit = sourceData.dataIterator(); dit.ok(); ++dit)
+      for (DataIterator dit = m_sourceData.dataIterator(); dit.ok(); ++dit)
         {
-          FArrayBox& sourceFAB = sourceData[dit()];
+          FArrayBox& sourceFAB = m_sourceData[dit()];
           const FArrayBox& consFAB = m_UNew[dit()];
 
           FORT_SETSOURCEPRIM(CHF_FRA(sourceFAB),
@@ -267,26 +302,29 @@ Real AMRLevelPolytropicGas::advance()
         }
     }
 
-  // we don't need the flux in the simple hyperbolic case...
-  LevelData<FArrayBox> flux[SpaceDim];
+  // Fill the ghost cells; the coarser data is not needed after this
+  m_levelGodunov.stepBegin(m_UNew,
+                           *finerFR,
+                           *coarserFR,
+                           m_sourceData,
+                           *coarserDataOld,
+                           tCoarserOld,
+                           *coarserDataNew,
+                           tCoarserNew,
+                           m_time,
+                           m_dt);
+}
 
-  // Advance the solve one timestep
-  newDt = m_levelGodunov.step(m_UNew,
-                              flux,
-                              *finerFR,
-                              *coarserFR,
-                              sourceData,
-                              *coarserDataOld,
-                              tCoarserOld,
-                              *coarserDataNew,
-                              tCoarserNew,
-                              m_time,
-                              m_dt);
+// Conclude the level step, add the source term and return the new
+// time step
+Real AMRLevelPolytropicGas::advanceEnd()
+{
+  Real newDt = m_levelGodunov.stepEnd(m_UNew);
 
   // Update with source term (2nd order accurate)
   if (m_useSourceTerm)
     {
-      for (DataIterator dit = sourceData.dataIterator(); dit.ok(); ++dit)
+      for (DataIterator dit = m_sourceData.dataIterator(); dit.ok(); ++dit)
         {
           const FArrayBox& consOldFAB = m_UOld[dit()];
           FArrayBox&       consNewFAB = m_UNew[dit()];
@@ -330,11 +368,6 @@ void AMRLevelPolytropicGas::postTimeStep()
 {
   CH_assert(allDefined());
 
-  // Used for conservation tests
-  static Real orig_integral = 0.0;
-  static Real last_integral = 0.0;
-  static bool first = true;
-
   if (s_verbosity >= 3)
     {
       pout() << "AMRLevelPolytropicGas::postTimeStep " << m_level << endl;
@@ -342,17 +375,54 @@ void AMRLevelPolytropicGas::postTimeStep()
 
   if (m_hasFiner)
     {
-      // Reflux
-      Real scale = -1.0/m_dx;
-      m_fluxRegister.reflux(m_UNew,scale);
+      reflux();
+      averageFromFiner();
+    }
 
-      // Average from finer level data
-      AMRLevelPolytropicGas* amrGodFinerPtr = getFinerLevel();
+  reportSums();
+}
 
-      amrGodFinerPtr->m_coarseAverage.averageToCoarse(m_UNew,
-                                                      amrGodFinerPtr->m_UNew);
+// Things to do after a timestep, as tasks
+int AMRLevelPolytropicGas::addPostTimeStepTasks(TaskGraph&         a_graph,
+                                                const Vector<int>& a_after)
+{
+  CH_assert(allDefined());
+
+  // Refluxing and averaging both copy between layouts
+  Vector<int> after(a_after);
+  if (m_hasFiner)
+    {
+      after = Vector<int>(1, a_graph.addTask([this] { reflux(); }, after, true));
+      after = Vector<int>(1, a_graph.addTask([this] { averageFromFiner(); }, after, true));
     }
 
+  return a_graph.addTask([this] { reportSums(); }, after, true);
+}
+
+// Reflux from the next finer level
+void AMRLevelPolytropicGas::reflux()
+{
+  Real scale = -1.0/m_dx;
+  m_fluxRegister.reflux(m_UNew,scale);
+}
+
+// Average from finer level data
+void AMRLevelPolytropicGas::averageFromFiner()
+{
+  AMRLevelPolytropicGas* amrGodFinerPtr = getFinerLevel();
+
+  amrGodFinerPtr->m_coarseAverage.averageToCoarse(m_UNew,
+                                                  amrGodFinerPtr->m_UNew);
+}
+
+// Print the sums of the conserved variables for conservation tests
+void AMRLevelPolytropicGas::reportSums()
+{
+  // Used for conservation tests
+  static Real orig_integral = 0.0;
+  static Real last_integral = 0.0;
+  static bool first = true;
+
   if (s_verbosity >= 2 && m_level == 0)
     {
       int nRefFine = 1;